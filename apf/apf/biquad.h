@@ -31,6 +31,10 @@
 #include <cmath>  // for std::pow(), std::tan(), std::sqrt(), ...
 #include <complex>
 #include <vector>
+#include <array>
+#include <limits>  // for std::numeric_limits
+#include <algorithm>  // for std::min(), std::max()
+#include <iterator>  // for std::iterator_traits
 #include <cassert>  // for assert()
 
 #include "apf/denormalprevention.h"
@@ -173,6 +177,35 @@ class BiQuad : public SosCoefficients<T> , private DenormalPrevention<T>
       return in;
     }
 
+    /// Process filter on audio block.
+    /// The states are kept in local variables for the whole block, the result
+    /// is the same as calling operator() for each sample.
+    /// @tparam In Iterator type for input samples
+    /// @tparam Out Iterator type for output samples
+    /// @param first Iterator to first input sample
+    /// @param last Iterator to (one past) last input sample
+    /// @param result Iterator to first output sample (may be equal to @p first)
+    template<typename In, typename Out>
+    void execute(In first, In last, Out result)
+    {
+      T s0 = w0, s1 = w1, s2 = w2;
+
+      for (; first != last; ++first, ++result)
+      {
+        s0 = s1;
+        s1 = s2;
+        s2 = argument_type(*first) - this->a1*s1 - this->a2*s0;
+
+        this->prevent_denormals(s2);
+
+        *result = this->b0*s2 + this->b1*s1 + this->b2*s0;
+      }
+
+      w0 = s0;
+      w1 = s1;
+      w2 = s2;
+    }
+
     T w0, w1, w2;
 };
 
@@ -224,10 +257,26 @@ class Cascade
     {
       using out_t = typename std::iterator_traits<Out>::value_type;
 
+      // The block is split into chunks which are processed section by
+      // section, each section keeps its states in registers for a whole chunk.
+      result_type buffer[64];
+      const size_type chunk_size = sizeof(buffer) / sizeof(*buffer);
+
       while (first != last)
       {
-        *result++ = static_cast<out_t>(this->operator()(*first));
-        ++first;
+        size_type n = 0;
+        for (; n < chunk_size && first != last; ++n, ++first)
+        {
+          buffer[n] = *first;
+        }
+        for (auto& section: _sections)
+        {
+          section.execute(buffer, buffer + n, buffer);
+        }
+        for (size_type i = 0; i < n; ++i)
+        {
+          *result++ = static_cast<out_t>(buffer[i]);
+        }
       }
     }
 
@@ -240,6 +289,262 @@ class Cascade
 namespace internal
 {
 
+/// Direct Form II sections for all lanes of a CascadeBank.
+template<typename T, size_t N, template<typename> class DenormalPrevention>
+struct DirectFormSection
+{
+  using value_type = T;
+
+  /// Default constructor, the section passes the signal through.
+  DirectFormSection()
+  {
+    for (size_t lane = 0; lane < N; ++lane)
+    {
+      b0[lane] = 1;
+      b1[lane] = b2[lane] = a1[lane] = a2[lane] = 0;
+      w1[lane] = w2[lane] = 0;
+    }
+  }
+
+  template<typename C>
+  void set(size_t lane, const SosCoefficients<C>& c)
+  {
+    b0[lane] = static_cast<T>(c.b0);
+    b1[lane] = static_cast<T>(c.b1);
+    b2[lane] = static_cast<T>(c.b2);
+    a1[lane] = static_cast<T>(c.a1);
+    a2[lane] = static_cast<T>(c.a2);
+  }
+
+  /// Process one sample of all lanes (in-place).
+  void process(T* values)
+  {
+    for (size_t lane = 0; lane < N; ++lane)
+    {
+      T w0 = w1[lane];
+      T w1_ = w2[lane];
+      T w2_ = values[lane] - a1[lane]*w1_ - a2[lane]*w0;
+
+      dp[lane].prevent_denormals(w2_);
+
+      values[lane] = b0[lane]*w2_ + b1[lane]*w1_ + b2[lane]*w0;
+
+      w1[lane] = w1_;
+      w2[lane] = w2_;
+    }
+  }
+
+  T b0[N], b1[N], b2[N];
+  T        a1[N], a2[N];
+  T w1[N], w2[N];
+  DenormalPrevention<T> dp[N];
+};
+
+/** Lattice-ladder sections for all lanes of a LatticeBank.
+ * The recursive part is a two-multiplier lattice with the reflection
+ * coefficients @c k1 and @c k2, the numerator is realized with the ladder
+ * coefficients @c v0, @c v1 and @c v2.
+ * The filter is stable if (and only if) both reflection coefficients have a
+ * magnitude below one. This is enforced after rounding to @p T, therefore the
+ * filter stays stable even if the poles are very close to the unit circle.
+ * @see A. H. Gray and J. D. Markel, "Digital lattice and ladder filter
+ *   synthesis", IEEE Trans. Audio Electroacoust., vol. 21, no. 6, 1973.
+ **/
+template<typename T, size_t N, template<typename> class DenormalPrevention>
+struct LatticeSection
+{
+  using value_type = T;
+
+  /// Default constructor, the section passes the signal through.
+  LatticeSection()
+  {
+    for (size_t lane = 0; lane < N; ++lane)
+    {
+      v0[lane] = 1;
+      v1[lane] = v2[lane] = k1[lane] = k2[lane] = 0;
+      g0[lane] = g1[lane] = 0;
+    }
+  }
+
+  /// Convert direct form coefficients to lattice-ladder coefficients.
+  /// The conversion is done with the precision of @p C.
+  template<typename C>
+  void set(size_t lane, const SosCoefficients<C>& c)
+  {
+    // largest magnitude of reflection coefficients which is still stable
+    const C limit = C(1) - C(std::numeric_limits<T>::epsilon());
+
+    auto clip = [limit] (C k) { return std::max(-limit, std::min(limit, k)); };
+
+    C k2_ = clip(c.a2);
+    C k1_ = clip(c.a1 / (C(1) + k2_));
+    C v2_ = c.b2;
+    C v1_ = c.b1 - v2_ * k1_ * (C(1) + k2_);
+    C v0_ = c.b0 - v1_ * k1_ - v2_ * k2_;
+
+    k1[lane] = static_cast<T>(k1_);
+    k2[lane] = static_cast<T>(k2_);
+    v0[lane] = static_cast<T>(v0_);
+    v1[lane] = static_cast<T>(v1_);
+    v2[lane] = static_cast<T>(v2_);
+  }
+
+  /// Process one sample of all lanes (in-place).
+  void process(T* values)
+  {
+    for (size_t lane = 0; lane < N; ++lane)
+    {
+      T f1 = values[lane] - k2[lane]*g1[lane];
+      T f0 = f1 - k1[lane]*g0[lane];
+
+      dp[lane].prevent_denormals(f0);
+
+      T g1_ = k1[lane]*f0 + g0[lane];
+      T g2_ = k2[lane]*f1 + g1[lane];
+
+      values[lane] = v0[lane]*f0 + v1[lane]*g1_ + v2[lane]*g2_;
+
+      g0[lane] = f0;
+      g1[lane] = g1_;
+    }
+  }
+
+  T v0[N], v1[N], v2[N];
+  T k1[N], k2[N];
+  T g0[N], g1[N];  // delayed backward signals
+  DenormalPrevention<T> dp[N];
+};
+
+/// Common implementation of CascadeBank and LatticeBank.
+/// @tparam Section sections for all lanes, e.g. DirectFormSection
+/// @tparam N number of lanes
+template<typename Section, size_t N>
+class SectionBank
+{
+  public:
+    using argument_type = typename Section::value_type;
+    using result_type = typename Section::value_type;
+    using size_type = size_t;
+
+    /// Number of cascades
+    static constexpr size_type lanes = N;
+
+    /// Constructor.
+    /// @param n Number of sections per lane
+    explicit SectionBank(size_type n) : _sections(n) {}
+
+    /// Overwrite (the first) sections of one lane with new coefficients.
+    /// @tparam I Iterator type for arguments (SosCoefficients of any type)
+    /// @param lane Index of the cascade
+    /// @param first Begin iterator
+    /// @param last End iterator
+    template<typename I>
+    void set(size_type lane, I first, I last)
+    {
+      assert(lane < N);
+
+      auto section = _sections.begin();
+      for (; first != last; ++first, ++section)
+      {
+        assert(section != _sections.end());
+        section->set(lane, *first);
+      }
+    }
+
+    /// Process all lanes on audio block.
+    /// @tparam In Iterator type for input samples
+    /// @tparam Out Iterator type for output samples
+    /// @param first Iterator to first input sample
+    /// @param last Iterator to (one past) last input sample
+    /// @param results Iterators to first output sample of each lane
+    template<typename In, typename Out>
+    void execute(In first, In last, std::array<Out, N> results)
+    {
+      using out_t = typename std::iterator_traits<Out>::value_type;
+
+      // The results are collected in chunks and written to the (separate)
+      // outputs afterwards, this allows the compiler to keep all lanes of a
+      // sample in one SIMD register.
+      result_type buffer[64][N];
+      const size_type chunk_size = sizeof(buffer) / sizeof(*buffer);
+
+      while (first != last)
+      {
+        size_type n = 0;
+        for (; n < chunk_size && first != last; ++n, ++first)
+        {
+          const result_type in = static_cast<result_type>(*first);
+          result_type* values = buffer[n];
+          for (size_type lane = 0; lane < N; ++lane)
+          {
+            values[lane] = in;
+          }
+
+          for (auto& section: _sections)
+          {
+            section.process(values);
+          }
+        }
+
+        for (size_type lane = 0; lane < N; ++lane)
+        {
+          for (size_type i = 0; i < n; ++i)
+          {
+            *results[lane]++ = static_cast<out_t>(buffer[i][lane]);
+          }
+        }
+      }
+    }
+
+    size_type number_of_sections() const { return _sections.size(); }
+
+  private:
+    std::vector<Section> _sections;
+};
+
+template<typename Section, size_t N>
+constexpr typename SectionBank<Section, N>::size_type
+SectionBank<Section, N>::lanes;
+
+}  // namespace internal
+
+/** Bank of @p N cascades of second order sections with a common input.
+ * Coefficients and states are stored lane by lane (one lane per cascade),
+ * which allows the compiler to process all cascades at once with SIMD
+ * instructions. For best performance, @p N should be a multiple of the SIMD
+ * width (e.g. 4 for @c double and 8 for @c float with AVX).
+ * Each lane gives the same result as a Cascade of BiQuad%s.
+ * All lanes have the same number of sections, sections which are not set
+ * pass the signal through (apart from denormal prevention).
+ * @tparam T internal type of states and coefficients
+ * @tparam N number of cascades
+ * @tparam DenormalPrevention method of denormal prevention (see apf::dp)
+ * @see Cascade, BiQuad, LatticeBank
+ **/
+template<typename T, size_t N
+  , template<typename> class DenormalPrevention = apf::dp::ac>
+using CascadeBank
+  = internal::SectionBank<internal::DirectFormSection<T, N, DenormalPrevention>
+  , N>;
+
+/** Like CascadeBank, but with lattice-ladder sections.
+ * This needs more operations per sample, but it is guaranteed to be stable,
+ * which makes it suitable for single precision filters with poles close to
+ * the unit circle (i.e. at very low frequencies).
+ * @tparam T internal type of states and coefficients
+ * @tparam N number of cascades
+ * @tparam DenormalPrevention method of denormal prevention (see apf::dp)
+ * @see internal::LatticeSection
+ **/
+template<typename T, size_t N
+  , template<typename> class DenormalPrevention = apf::dp::ac>
+using LatticeBank
+  = internal::SectionBank<internal::LatticeSection<T, N, DenormalPrevention>
+  , N>;
+
+namespace internal
+{
+
 /** Roots-to-polynomial conversion.
  * @tparam T precision of data
  * @param Roots 2x2 roots matrix
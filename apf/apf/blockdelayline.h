@@ -28,9 +28,11 @@
 #define APF_BLOCKDELAYLINE_H
 
 #include <algorithm>  // for std::max()
+#include <cmath>  // for std::floor()
 #include <vector>  // default container
 
 #include "apf/iterator.h"  // for circular_iterator, stride_iterator
+#include "apf/math.h"  // for wrap()
 
 namespace apf
 {
@@ -56,6 +58,15 @@ class BlockDelayLine
       return delay <= _max_delay;
     }
 
+    /// Return @b true if the fractional @p delay is valid for @p interpolator
+    template<typename Interpolator>
+    bool delay_is_valid(double delay, const Interpolator& interpolator) const
+    {
+      double first = std::floor(delay) - double(interpolator.before());
+      return first >= 0
+        && first + double(interpolator.taps() - 1) <= double(_max_delay);
+    }
+
     /// Advance the internal iterators/pointers to the next block.
     void advance()
     {
@@ -72,6 +83,10 @@ class BlockDelayLine
     template<typename Iterator>
     bool read_block(Iterator destination, size_type delay, T weight) const;
 
+    template<typename Iterator, typename Interpolator>
+    bool read_block(Iterator destination, double old_delay, double new_delay
+        , T old_weight, T new_weight, const Interpolator& interpolator) const;
+
     pointer get_write_pointer() const;
 
     circulator get_read_circulator(size_type delay = 0) const;
@@ -171,6 +186,78 @@ BlockDelayLine<T, Container>::read_block(Iterator destination
   return true;
 }
 
+/** Read from the delay line with fractional delay.
+ * The delay changes linearly from @p old_delay to @p new_delay and the
+ * weighting factor from @p old_weight to @p new_weight (sample by sample, the
+ * new values are reached at the beginning of the next block).
+ * @param destination Iterator to destination
+ * @param old_delay Delay (in samples) of the first sample of the block
+ * @param new_delay Delay (in samples) of the first sample of the next block
+ * @param old_weight Weighting factor of the first sample of the block
+ * @param new_weight Weighting factor of the first sample of the next block
+ * @param interpolator e.g. DelayInterpolator
+ * @return @b true on success
+ **/
+template<typename T, typename Container>
+template<typename Iterator, typename Interpolator>
+bool
+BlockDelayLine<T, Container>::read_block(Iterator destination
+    , double old_delay, double new_delay, T old_weight, T new_weight
+    , const Interpolator& interpolator) const
+{
+  if (!this->delay_is_valid(old_delay, interpolator)
+      || !this->delay_is_valid(new_delay, interpolator))
+  {
+    return false;
+  }
+
+  using difference_type = typename circulator::difference_type;
+
+  const auto length = static_cast<difference_type>(_data.size());
+  const auto taps = static_cast<difference_type>(interpolator.taps());
+  const auto before = static_cast<difference_type>(interpolator.before());
+  // index of the first sample of the current block
+  const auto now = static_cast<difference_type>(
+      _data_circulator.base() - _data.begin());
+  const T* data = &_data[0];
+
+  const double delay_step = (new_delay - old_delay) / double(_block_size);
+  const T weight_step = (new_weight - old_weight) / T(_block_size);
+
+  for (size_type n = 0; n < _block_size; ++n)
+  {
+    double delay = old_delay + double(n) * delay_step;
+    double int_delay = std::floor(delay);
+    const T* coefficients = interpolator.coefficients(T(delay - int_delay));
+
+    // index of the oldest sample needed for this output sample
+    difference_type first = math::wrap(now + difference_type(n)
+        - static_cast<difference_type>(int_delay) + before - (taps - 1)
+        , length);
+
+    T sum = T();
+    if (first + taps <= length)
+    {
+      // no wrap-around, coefficients and samples are contiguous in memory
+      const T* samples = data + first;
+      for (difference_type j = 0; j < taps; ++j)
+      {
+        sum += coefficients[j] * samples[j];
+      }
+    }
+    else
+    {
+      for (difference_type j = 0; j < taps; ++j)
+      {
+        sum += coefficients[j] * data[(first + j) % length];
+      }
+    }
+    *destination = sum * (old_weight + T(n) * weight_step);
+    ++destination;
+  }
+  return true;
+}
+
 /** Get the write pointer.
  * @attention Before the write operation, advance() must be called to
  * update read and write pointers.
@@ -262,6 +349,25 @@ class NonCausalBlockDelayLine : private BlockDelayLine<T, Container>
       return _base::read_block(destination, delay + _initial_delay, weight);
     }
 
+    /// @see BlockDelayLine::delay_is_valid()
+    template<typename Interpolator>
+    bool delay_is_valid(double delay, const Interpolator& interpolator) const
+    {
+      return _base::delay_is_valid(delay + double(_initial_delay)
+          , interpolator);
+    }
+
+    /// @see BlockDelayLine::read_block()
+    template<typename Iterator, typename Interpolator>
+    bool read_block(Iterator destination, double old_delay, double new_delay
+        , T old_weight, T new_weight, const Interpolator& interpolator) const
+    {
+      return _base::read_block(destination
+          , old_delay + double(_initial_delay)
+          , new_delay + double(_initial_delay)
+          , old_weight, new_weight, interpolator);
+    }
+
     /// @see BlockDelayLine::get_read_circulator()
     circulator get_read_circulator(difference_type delay = 0) const
     {
@@ -465,6 +465,97 @@ class CombineChannelsCrossfade : public CombineChannelsCrossfadeBase<
     }
 };
 
+/** Combine channels: accumulate in the frequency domain and crossfade.
+ * Instead of transforming each item to the time domain, the items add their
+ * spectra to three accumulators (constant, fade-out and fade-in), only those
+ * have to be transformed back.
+ * The function object has to provide @c select() and two @c accumulate()
+ * member functions, one for the new and one (with fade_out_tag) for the old
+ * result of the selected item.
+ * @tparam Accumulator e.g. conv::Accumulator. Must have a constructor taking
+ *   the block size and the member functions @c clear(), @c empty() and
+ *   @c ifft().
+ **/
+template<typename L, typename Out, typename Crossfade, typename Accumulator>
+class CombineChannelsCrossfadeAccumulate : public CombineChannelsCrossfadeBase<
+            CombineChannelsCrossfadeAccumulate<L, Out, Crossfade, Accumulator>
+                                                        , L, Out, Crossfade>
+{
+  private:
+    using _base = CombineChannelsCrossfadeBase<
+      CombineChannelsCrossfadeAccumulate<L, Out, Crossfade, Accumulator>
+      , L, Out, Crossfade>;
+
+    using _base::_fade_out_buffer;
+    using _base::_fade_in_buffer;
+    using _base::_accumulate_fade_in;
+    using _base::_accumulate_fade_out;
+    using _base::_selection;
+
+  public:
+    CombineChannelsCrossfadeAccumulate(const L& in, Out& out
+        , const Crossfade& fade)
+      : _base(in, out, fade)
+      , _constant(fade.size())
+      , _fade_out(fade.size())
+      , _fade_in(fade.size())
+    {}
+
+    void before_the_loop()
+    {
+      _base::before_the_loop();
+      _constant.clear();
+      _fade_out.clear();
+      _fade_in.clear();
+    }
+
+    template<typename ItemType, typename F>
+    void case_one(const ItemType&, F& f)
+    {
+      f.accumulate(_constant);
+    }
+
+    template<typename ItemType, typename F>
+    void case_two(const ItemType&, F& f)
+    {
+      if (_selection != CombineChannelsResult::fade_in)
+      {
+        f.accumulate(_fade_out, fade_out_tag());
+      }
+      if (_selection != CombineChannelsResult::fade_out)
+      {
+        f.accumulate(_fade_in);
+      }
+    }
+
+    void after_the_loop()
+    {
+      const auto size = _fade_out_buffer.size();
+
+      if (!_constant.empty())
+      {
+        auto first = _constant.ifft();
+        this->_case_one_copy(make_begin_and_end(first, first + size));
+      }
+      if (!_fade_out.empty())
+      {
+        auto first = _fade_out.ifft();
+        std::copy(first, first + size, _fade_out_buffer.begin());
+        _accumulate_fade_out = true;
+      }
+      if (!_fade_in.empty())
+      {
+        auto first = _fade_in.ifft();
+        std::copy(first, first + size, _fade_in_buffer.begin());
+        _accumulate_fade_in = true;
+      }
+      _base::after_the_loop();
+    }
+
+  private:
+    Accumulator _constant, _fade_out, _fade_in;
+};
+
 /** Crossfade using a raised cosine.
  **/
 template<typename T>
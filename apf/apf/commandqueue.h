@@ -29,8 +29,14 @@
 
 #include <unistd.h> // for usleep()
 #include <cassert>  // for assert()
+#include <functional>  // for std::less_equal, std::less
+#include <new>  // for placement new
+#include <type_traits>  // for std::aligned_storage, std::is_base_of
+#include <utility>  // for std::forward
+#include <vector>
 
 #include "apf/lockfreefifo.h"
+#include "apf/container.h"  // for fixed_vector
 
 namespace apf
 {
@@ -40,6 +46,13 @@ namespace apf
  *
  * Commands are executed when process_commands() is called from the realtime
  * thread.
+ *
+ * Commands which are created with emplace() are constructed in a
+ * pre-allocated pool of fixed-size slots, therefore they don't need any
+ * dynamic memory allocation.
+ * If a command is too large for a slot or if all slots are in use, it is
+ * allocated with @c new.
+ * Commands which are passed to push() must be allocated with @c new.
  **/
 class CommandQueue : NonCopyable
 {
@@ -79,13 +92,22 @@ class CommandQueue : NonCopyable
     /// If there are multiple non-realtime threads, access has to be locked!
     //@{
 
+    /// Size of one slot in the command pool (in bytes).
+    static const size_t slot_size = 64;
+
     /// Constructor.
     /// @param size maximum number of commands in queue.
-    explicit CommandQueue(size_t size)
+    /// @param pool_size number of pre-allocated command slots, by default
+    ///   the same as @p size.
+    explicit CommandQueue(size_t size, size_t pool_size = size_t(-1))
       : _in_fifo(size)
       , _out_fifo(size)
       , _active(true)
-    {}
+      , _pool(pool_size == size_t(-1) ? size : pool_size)
+    {
+      _free_slots.reserve(_pool.size());
+      for (auto& slot: _pool) _free_slots.push_back(&slot);
+    }
 
     /// Destructor.
     /// @attention Commands in the cleanup queue are cleaned up, but commands in
@@ -99,6 +121,15 @@ class CommandQueue : NonCopyable
 
     inline void push(Command* cmd);
 
+    /// Construct a command of type @p C (from the command pool, if possible)
+    /// and push() it.
+    /// @param args arguments for the constructor of @p C
+    template<typename C, typename... Args>
+    void emplace(Args&&... args)
+    {
+      this->push(_new<C>(std::forward<Args>(args)...));
+    }
+
     inline void wait();
 
     /// Clean up all commands in the cleanup-queue.
@@ -162,12 +193,58 @@ class CommandQueue : NonCopyable
     //@}
 
   private:
+    using _slot_t = std::aligned_storage<slot_size>::type;
+
+    template<typename C, typename... Args>
+    C* _new(Args&&... args)
+    {
+      static_assert(std::is_base_of<Command, C>::value
+          , "C must be derived from CommandQueue::Command!");
+
+      if (sizeof(C) > sizeof(_slot_t) || alignof(C) > alignof(_slot_t)
+          || _free_slots.empty())
+      {
+        return new C(std::forward<Args>(args)...);
+      }
+
+      _slot_t* slot = _free_slots.back();
+      _free_slots.pop_back();
+      try
+      {
+        return new (slot) C(std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        _free_slots.push_back(slot);
+        throw;
+      }
+    }
+
+    /// Check if @p cmd was constructed in the command pool.
+    bool _in_pool(Command* cmd) const
+    {
+      // get the address of the most derived object
+      const void* ptr = dynamic_cast<const void*>(cmd);
+      return !_pool.empty()
+        && std::less_equal<const void*>()(&_pool.front(), ptr)
+        && std::less<const void*>()(ptr, &_pool.back() + 1);
+    }
+
     /// Clean up and delete a command @p cmd
     void _cleanup(Command* cmd)
     {
       assert(cmd != nullptr);
       cmd->cleanup();
-      delete cmd;
+      if (_in_pool(cmd))
+      {
+        auto slot = static_cast<_slot_t*>(dynamic_cast<void*>(cmd));
+        cmd->~Command();
+        _free_slots.push_back(slot);
+      }
+      else
+      {
+        delete cmd;
+      }
     }
 
     /// Queue of commands to execute in realtime thread
@@ -176,6 +253,11 @@ class CommandQueue : NonCopyable
     LockFreeFifo<Command*> _out_fifo;
 
     bool _active;  ///< default: true
+
+    /// Storage for commands, only used in the non-realtime thread
+    fixed_vector<_slot_t> _pool;
+    /// Unused elements of _pool (never re-allocated)
+    std::vector<_slot_t*> _free_slots;
 };
 
 /** Push a command to be executed in the realtime thread.
@@ -215,7 +297,7 @@ void CommandQueue::push(Command* cmd)
 void CommandQueue::wait()
 {
   bool done = false;
-  this->push(new WaitCommand(done));
+  this->emplace<WaitCommand>(done);
 
   this->cleanup_commands();
   while (!done)
@@ -35,6 +35,13 @@
 #include <xmmintrin.h>  // for SSE instrinsics
 #endif
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/// Wider SIMD kernels are compiled with function-level target attributes and
+/// selected at runtime (see apf::conv::best_multiply_partition()).
+#define APF_CONV_RUNTIME_DISPATCH
+#include <immintrin.h>  // for AVX2/FMA and AVX-512 intrinsics
+#endif
+
 #include "apf/math.h"
 #include "apf/fftwtools.h"  // for fftw_allocator and fftw traits
 #include "apf/container.h"  // for fixed_vector, fixed_list
@@ -376,11 +383,362 @@ Input::add_block(In first)
   }
 }
 
+/** Complex multiply-accumulate of one partition.
+ * All kernels work on the interleaved layout created by
+ * TransformBase::_sort_coefficients(): groups of 8 values, 4 real parts
+ * followed by the corresponding 4 imaginary parts.  The first group holds
+ * the DC and Nyquist values (which are real) at index 0 and 4.
+ * @param signal Input spectrum
+ * @param filter Filter spectrum
+ * @param[in,out] result The product is added to this spectrum
+ * @param size Number of values in each spectrum (a multiple of 16)
+ **/
+using multiply_partition_t = void (*)(const float* signal
+    , const float* filter, float* result, size_t size);
+
+/// Portable implementation of the complex multiply-accumulate.
+inline void multiply_partition_cpp(const float* signal, const float* filter
+    , float* result, size_t size)
+{
+  // see http://www.ludd.luth.se/~torger/brutefir.html#bruteconv_4
+
+  auto d1s = result[0] + signal[0] * filter[0];
+  auto d2s = result[4] + signal[4] * filter[4];
+
+  for (size_t nn = 0; nn < size; nn += 8)
+  {
+    // real parts
+    result[nn+0] += signal[nn+0] * filter[nn + 0] -
+                    signal[nn+4] * filter[nn + 4];
+    result[nn+1] += signal[nn+1] * filter[nn + 1] -
+                    signal[nn+5] * filter[nn + 5];
+    result[nn+2] += signal[nn+2] * filter[nn + 2] -
+                    signal[nn+6] * filter[nn + 6];
+    result[nn+3] += signal[nn+3] * filter[nn + 3] -
+                    signal[nn+7] * filter[nn + 7];
+
+    // imaginary parts
+    result[nn+4] += signal[nn+0] * filter[nn + 4] +
+                    signal[nn+4] * filter[nn + 0];
+    result[nn+5] += signal[nn+1] * filter[nn + 5] +
+                    signal[nn+5] * filter[nn + 1];
+    result[nn+6] += signal[nn+2] * filter[nn + 6] +
+                    signal[nn+6] * filter[nn + 2];
+    result[nn+7] += signal[nn+3] * filter[nn + 7] +
+                    signal[nn+7] * filter[nn + 3];
+
+  } // for
+
+  result[0] = d1s;
+  result[4] = d2s;
+}
+
+#ifdef __SSE__
+/// 128-bit SSE implementation of the complex multiply-accumulate.
+inline void multiply_partition_sse(const float* signal, const float* filter
+    , float* result, size_t size)
+{
+  // 16 byte alignment is needed for _mm_load_ps()!
+  // This should be the case anyway because fftwf_malloc() is used.
+
+  auto dc = result[0] + signal[0] * filter[0];
+  auto ny = result[4] + signal[4] * filter[4];
+
+  for(size_t i = 0; i < size; i += 8)
+  {
+    // load real and imaginary parts of signal and filter
+    __m128 sigr = _mm_load_ps(signal + i);
+    __m128 sigi = _mm_load_ps(signal + i + 4);
+    __m128 filtr = _mm_load_ps(filter + i);
+    __m128 filti = _mm_load_ps(filter + i + 4);
+
+    // multiply and subtract
+    __m128 res1 = _mm_sub_ps(_mm_mul_ps(sigr, filtr), _mm_mul_ps(sigi, filti));
+
+    // multiply and add
+    __m128 res2 = _mm_add_ps(_mm_mul_ps(sigr, filti), _mm_mul_ps(sigi, filtr));
+
+    // load output data for accumulation
+    __m128 acc1 = _mm_load_ps(result + i);
+    __m128 acc2 = _mm_load_ps(result + i + 4);
+
+    // accumulate
+    acc1 = _mm_add_ps(acc1, res1);
+    acc2 = _mm_add_ps(acc2, res2);
+
+    // store output data
+    _mm_store_ps(result + i, acc1);
+    _mm_store_ps(result + i + 4, acc2);
+  }
+
+  result[0] = dc;
+  result[4] = ny;
+}
+#endif
+
+#ifdef APF_CONV_RUNTIME_DISPATCH
+/** 256-bit AVX2/FMA implementation of the complex multiply-accumulate.
+ * One group of 8 values fills a whole register: [re | im].
+ * The real and imaginary parts of the signal are broadcast to both lanes,
+ * the filter is swapped to [-im | re], which gives
+ * [sr*fr - si*fi | sr*fi + si*fr] with two FMAs.
+ * @note Only call this if the CPU supports AVX2 and FMA!
+ **/
+__attribute__((target("avx2,fma")))
+inline void multiply_partition_avx2(const float* signal
+    , const float* filter, float* result, size_t size)
+{
+  auto dc = result[0] + signal[0] * filter[0];
+  auto ny = result[4] + signal[4] * filter[4];
+
+  // negate the lower lane
+  const __m256 sign = _mm256_setr_ps(-0.0f, -0.0f, -0.0f, -0.0f
+      , 0.0f, 0.0f, 0.0f, 0.0f);
+
+  for (size_t i = 0; i < size; i += 8)
+  {
+    __m256 sigr = _mm256_broadcast_ps(
+        reinterpret_cast<const __m128*>(signal + i));
+    __m256 sigi = _mm256_broadcast_ps(
+        reinterpret_cast<const __m128*>(signal + i + 4));
+    __m256 filt = _mm256_loadu_ps(filter + i);
+    __m256 swapped = _mm256_xor_ps(_mm256_permute2f128_ps(filt, filt, 0x01)
+        , sign);
+
+    __m256 acc = _mm256_loadu_ps(result + i);
+    acc = _mm256_fmadd_ps(sigr, filt, acc);
+    acc = _mm256_fmadd_ps(sigi, swapped, acc);
+    _mm256_storeu_ps(result + i, acc);
+  }
+
+  result[0] = dc;
+  result[4] = ny;
+}
+
+/** 512-bit AVX-512 implementation of the complex multiply-accumulate.
+ * Same scheme as multiply_partition_avx2(), but with two groups of 8 values
+ * per register.
+ * @note Only call this if the CPU supports AVX-512F and @p size is a multiple
+ *   of 16, see best_multiply_partition()!
+ **/
+#pragma GCC diagnostic push
+// false positive in GCC's _mm512_undefined_ps(), see GCC bug 105593
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+inline void multiply_partition_avx512(const float* signal
+    , const float* filter, float* result, size_t size)
+{
+  assert(size % 16 == 0);
+
+  auto dc = result[0] + signal[0] * filter[0];
+  auto ny = result[4] + signal[4] * filter[4];
+
+  // negate the lanes holding the real parts
+  const __mmask16 real_lanes = 0x0f0f;
+
+  for (size_t i = 0; i < size; i += 16)
+  {
+    __m512 sig = _mm512_loadu_ps(signal + i);
+    __m512 filt = _mm512_loadu_ps(filter + i);
+
+    __m512 sigr = _mm512_shuffle_f32x4(sig, sig, _MM_SHUFFLE(2, 2, 0, 0));
+    __m512 sigi = _mm512_shuffle_f32x4(sig, sig, _MM_SHUFFLE(3, 3, 1, 1));
+    __m512 swapped = _mm512_shuffle_f32x4(filt, filt, _MM_SHUFFLE(2, 3, 0, 1));
+    swapped = _mm512_mask_sub_ps(swapped, real_lanes, _mm512_setzero_ps()
+        , swapped);
+
+    __m512 acc = _mm512_loadu_ps(result + i);
+    acc = _mm512_fmadd_ps(sigr, filt, acc);
+    acc = _mm512_fmadd_ps(sigi, swapped, acc);
+    _mm512_storeu_ps(result + i, acc);
+  }
+
+  result[0] = dc;
+  result[4] = ny;
+}
+#pragma GCC diagnostic pop
+#endif
+
+/** Select the fastest multiply-accumulate kernel supported by the CPU.
+ * The CPU features are queried only once, the result is cached.
+ * @param size number of values per partition, the AVX-512 kernel is only
+ *   selected if it is a multiple of 16.
+ **/
+inline multiply_partition_t best_multiply_partition(size_t size)
+{
+#ifdef APF_CONV_RUNTIME_DISPATCH
+  static const bool avx512 = []()
+  {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") != 0;
+  }();
+  static const bool avx2 = __builtin_cpu_supports("avx2")
+    && __builtin_cpu_supports("fma");
+
+  if (avx512 && size % 16 == 0)
+  {
+    return multiply_partition_avx512;
+  }
+  if (avx2)
+  {
+    return multiply_partition_avx2;
+  }
+#else
+  (void)size;
+#endif
+#ifdef __SSE__
+  return multiply_partition_sse;
+#else
+  return multiply_partition_cpp;
+#endif
+}
+
+namespace internal
+{
+
+/** Undo TransformBase::_sort_coefficients() to prepare the IFFT.
+ * @param[in,out] data Sorted coefficients, replaced by the halfcomplex format
+ * @param buffer Temporary storage of @p partition_size values
+ * @param partition_size Size of the FFT
+ **/
+inline void unsort_coefficients(float* data, float* buffer
+    , size_t partition_size)
+{
+  size_t base = 8;
+
+  buffer[0]                  = data[0];
+  buffer[1]                  = data[1];
+  buffer[2]                  = data[2];
+  buffer[3]                  = data[3];
+  buffer[partition_size / 2] = data[4];
+  buffer[partition_size - 1] = data[5];
+  buffer[partition_size - 2] = data[6];
+  buffer[partition_size - 3] = data[7];
+
+  for (size_t i=0; i < (partition_size / 8-1); i++)
+  {
+    for (size_t ii = 0; ii < 4; ii++)
+    {
+      buffer[base/2+ii] = data[base+ii];
+    }
+
+    for (size_t ii = 0; ii < 4; ii++)
+    {
+      buffer[partition_size-base/2-ii] = data[base+4+ii];
+    }
+
+    base += 8;
+  }
+
+  std::copy(buffer, buffer + partition_size, data);
+}
+
+}  // namespace internal
+
+/** Frequency-domain accumulation of convolution results.
+ * Instead of transforming each result back to the time domain with
+ * OutputBase::convolve(), the (weighted) spectra of several Output and
+ * StaticOutput objects can be added with OutputBase::accumulate().
+ * Only one IFFT is needed for all of them.
+ **/
+class Accumulator
+{
+  public:
+    explicit Accumulator(size_t block_size);
+
+    /// Remove all contributions
+    void clear() { _buffer.zero = true; }
+
+    /// @return @b true if nothing (except zeros) has been accumulated
+    bool empty() const { return _buffer.zero; }
+
+    size_t block_size() const { return _block_size; }
+
+    void add(const fft_node& spectrum, float weight = 1.0f);
+
+    /// Add the contents of another Accumulator (with the same block size)
+    void add(const Accumulator& other, float weight = 1.0f)
+    {
+      this->add(other._buffer, weight);
+    }
+
+    float* ifft();
+
+  private:
+    const size_t _block_size, _partition_size;
+    fft_node _buffer;
+    fixed_vector<float> _unsort_buffer;
+    fftw<float>::scoped_plan _ifft_plan;
+};
+
+Accumulator::Accumulator(size_t block_size_)
+  : _block_size(block_size_)
+  , _partition_size(2 * _block_size)
+  , _buffer(_partition_size)
+  , _unsort_buffer(_partition_size)
+  , _ifft_plan(fftw<float>::plan_r2r_1d, int(_partition_size)
+      , _buffer.data(), _buffer.data(), FFTW_HC2R, FFTW_PATIENT)
+{}
+
+/** Add a (weighted) spectrum.
+ * @param spectrum Sorted spectrum, as used internally by OutputBase
+ * @param weight amplitude weighting factor
+ **/
+void
+Accumulator::add(const fft_node& spectrum, float weight)
+{
+  assert(spectrum.size() == _partition_size);
+
+  if (spectrum.zero) return;
+
+  if (_buffer.zero)
+  {
+    std::transform(spectrum.begin(), spectrum.end(), _buffer.begin()
+        , [weight] (float x) { return weight * x; });
+    _buffer.zero = false;
+  }
+  else
+  {
+    for (size_t i = 0; i < _partition_size; ++i)
+    {
+      _buffer[i] += weight * spectrum[i];
+    }
+  }
+}
+
+/** Transform the accumulated spectra to the time domain.
+ * Afterwards, the Accumulator is empty.
+ * @return pointer to the first sample of the (normalized) result.
+ **/
+float*
+Accumulator::ifft()
+{
+  auto second_half = _buffer.begin() + _block_size;
+
+  if (_buffer.zero)
+  {
+    std::fill(second_half, _buffer.end(), 0.0f);
+  }
+  else
+  {
+    internal::unsort_coefficients(_buffer.data(), _unsort_buffer.data()
+        , _partition_size);
+    fftw<float>::execute(_ifft_plan);
+
+    // normalize buffer (fftw3 does not do this)
+    const auto norm = 1.0f / float(_partition_size);
+    std::for_each(second_half, _buffer.end(), [norm] (float& x) { x *= norm; });
+    _buffer.zero = true;
+  }
+  return &*second_half;
+}
+
 /// Base class for Output and StaticOutput
 class OutputBase
 {
   public:
     float* convolve(float weight = 1.0f);
+    void accumulate(Accumulator& target, float weight = 1.0f);
 
     size_t block_size() const { return _input.block_size(); }
     size_t partitions() const { return _filter_ptrs.size(); }
@@ -396,10 +754,6 @@ class OutputBase
 
   private:
     void _multiply_spectra();
-    void _multiply_partition_cpp(const float* signal, const float* filter);
-#ifdef __SSE__
-    void _multiply_partition_simd(const float* signal, const float* filter);
-#endif
 
     void _unsort_coefficients();
 
@@ -411,6 +765,8 @@ class OutputBase
 
     fft_node _output_buffer;
     fftw<float>::scoped_plan _ifft_plan;
+
+    const multiply_partition_t _multiply_partition;
 };
 
 OutputBase::OutputBase(const Input& input)
@@ -423,6 +779,7 @@ OutputBase::OutputBase(const Input& input)
   , _ifft_plan(fftw<float>::plan_r2r_1d, int(_partition_size)
       , _output_buffer.data()
       , _output_buffer.data(), FFTW_HC2R, FFTW_PATIENT)
+  , _multiply_partition(best_multiply_partition(_partition_size))
 {
   assert(_filter_ptrs.size() > 0);
 }
@@ -466,83 +823,20 @@ OutputBase::convolve(float weight)
   return &second_half[0];
 }
 
+/** Fast convolution of one audio block, without IFFT.
+ * Like convolve(), but the (weighted) result is added to @p target in the
+ * frequency domain.
+ * @param target Accumulator with the same block size
+ * @param weight amplitude weighting factor for current audio block.
+ **/
 void
-OutputBase::_multiply_partition_cpp(const float* signal, const float* filter)
-{
-  // see http://www.ludd.luth.se/~torger/brutefir.html#bruteconv_4
-
-  auto d1s = _output_buffer[0] + signal[0] * filter[0];
-  auto d2s = _output_buffer[4] + signal[4] * filter[4];
-
-  for (size_t nn = 0; nn < _partition_size; nn += 8)
-  {
-    // real parts
-    _output_buffer[nn+0] += signal[nn+0] * filter[nn + 0] -
-                            signal[nn+4] * filter[nn + 4];
-    _output_buffer[nn+1] += signal[nn+1] * filter[nn + 1] -
-                            signal[nn+5] * filter[nn + 5];
-    _output_buffer[nn+2] += signal[nn+2] * filter[nn + 2] -
-                            signal[nn+6] * filter[nn + 6];
-    _output_buffer[nn+3] += signal[nn+3] * filter[nn + 3] -
-                            signal[nn+7] * filter[nn + 7];
-
-    // imaginary parts
-    _output_buffer[nn+4] += signal[nn+0] * filter[nn + 4] +
-                            signal[nn+4] * filter[nn + 0];
-    _output_buffer[nn+5] += signal[nn+1] * filter[nn + 5] +
-                            signal[nn+5] * filter[nn + 1];
-    _output_buffer[nn+6] += signal[nn+2] * filter[nn + 6] +
-                            signal[nn+6] * filter[nn + 2];
-    _output_buffer[nn+7] += signal[nn+3] * filter[nn + 7] +
-                            signal[nn+7] * filter[nn + 3];
-
-  } // for
-
-  _output_buffer[0] = d1s;
-  _output_buffer[4] = d2s;
-}
-
-#ifdef __SSE__
-void
-OutputBase::_multiply_partition_simd(const float* signal, const float* filter)
+OutputBase::accumulate(Accumulator& target, float weight)
 {
-  // 16 byte alignment is needed for _mm_load_ps()!
-  // This should be the case anyway because fftwf_malloc() is used.
-
-  auto dc = _output_buffer[0] + signal[0] * filter[0];
-  auto ny = _output_buffer[4] + signal[4] * filter[4];
-
-  for(size_t i = 0; i < _partition_size; i += 8)
-  {
-    // load real and imaginary parts of signal and filter
-    __m128 sigr = _mm_load_ps(signal + i);
-    __m128 sigi = _mm_load_ps(signal + i + 4);
-    __m128 filtr = _mm_load_ps(filter + i);
-    __m128 filti = _mm_load_ps(filter + i + 4);
-
-    // multiply and subtract
-    __m128 res1 = _mm_sub_ps(_mm_mul_ps(sigr, filtr), _mm_mul_ps(sigi, filti));
-
-    // multiply and add
-    __m128 res2 = _mm_add_ps(_mm_mul_ps(sigr, filti), _mm_mul_ps(sigi, filtr));
-
-    // load output data for accumulation
-    __m128 acc1 = _mm_load_ps(&_output_buffer[i]);
-    __m128 acc2 = _mm_load_ps(&_output_buffer[i + 4]);
-
-    // accumulate
-    acc1 = _mm_add_ps(acc1, res1);
-    acc2 = _mm_add_ps(acc2, res2);
-
-    // store output data
-    _mm_store_ps(&_output_buffer[i], acc1);
-    _mm_store_ps(&_output_buffer[i + 4], acc2);
-  }
+  assert(target.block_size() == _input.block_size());
 
-  _output_buffer[0] = dc;
-  _output_buffer[4] = ny;
+  _multiply_spectra();
+  target.add(_output_buffer, weight);
 }
-#endif
 
 /// Complex multiplication of input and filter spectra
 void
@@ -566,11 +860,8 @@ OutputBase::_multiply_spectra()
     }
     else
     {
-#ifdef __SSE__
-      _multiply_partition_simd(input->data(), filter->data());
-#else
-      _multiply_partition_cpp(input->data(), filter->data());
-#endif
+      _multiply_partition(input->data(), filter->data()
+          , _output_buffer.data(), _partition_size);
       _output_buffer.zero = false;
     }
     ++input;
@@ -581,34 +872,8 @@ void
 OutputBase::_unsort_coefficients()
 {
   fixed_vector<float> buffer(_partition_size);
-
-  size_t base = 8;
-
-  buffer[0]                 = _output_buffer[0];
-  buffer[1]                 = _output_buffer[1];
-  buffer[2]                 = _output_buffer[2];
-  buffer[3]                 = _output_buffer[3];
-  buffer[_input.block_size()] = _output_buffer[4];
-  buffer[_partition_size-1] = _output_buffer[5];
-  buffer[_partition_size-2] = _output_buffer[6];
-  buffer[_partition_size-3] = _output_buffer[7];
-
-  for (size_t i=0; i < (_partition_size / 8-1); i++)
-  {
-    for (size_t ii = 0; ii < 4; ii++)
-    {
-      buffer[base/2+ii] = _output_buffer[base+ii];
-    }
-
-    for (size_t ii = 0; ii < 4; ii++)
-    {
-      buffer[_partition_size-base/2-ii] = _output_buffer[base+4+ii];
-    }
-
-    base += 8;
-  }
-
-  std::copy(buffer.begin(), buffer.end(), _output_buffer.begin());
+  internal::unsort_coefficients(_output_buffer.data(), buffer.data()
+      , _partition_size);
 }
 
 void
@@ -630,7 +895,7 @@ class Output : public OutputBase
               , apf::make_index_iterator(input.partitions()))
     {}
 
-    void set_filter(const Filter& filter);
+    void set_filter(const Filter& filter, size_t delay = 0);
 
     bool queues_empty() const;
     void rotate_queues();
@@ -644,22 +909,29 @@ class Output : public OutputBase
  * updated with rotate_queues().
  * @param filter Container with filter partitions. If too few partitions are
  *   given, the rest is set to zero, if too many are given, the rest is ignored.
+ * @param delay Number of (zero) partitions to insert before @p filter.
  **/
 void
-Output::set_filter(const Filter& filter)
+Output::set_filter(const Filter& filter, size_t delay)
 {
   auto partition = filter.begin();
 
-  // First partition has no queue and is updated immediately
-  if (partition != filter.end())
+  auto next_partition = [&] () -> const fft_node*
   {
-    _filter_ptrs.front() = &*partition++;
-  }
+    if (delay > 0)
+    {
+      --delay;
+      return &_empty_partition;
+    }
+    return (partition == filter.end()) ? &_empty_partition : &*partition++;
+  };
+
+  // First partition has no queue and is updated immediately
+  _filter_ptrs.front() = next_partition();
 
   for (size_t i = 0; i < _queues.size(); ++i)
   {
-    _queues[i][i]
-      = (partition == filter.end()) ? &_empty_partition : &*partition++;
+    _queues[i][i] = next_partition();
   }
 }
 
@@ -723,21 +995,28 @@ class StaticOutput : public OutputBase
     }
 
     /// Constructor from existing frequency domain filter coefficients.
+    /// @param delay Number of (zero) partitions to insert before @p filter.
     /// @attention The filter coefficients are not copied, their lifetime must
     ///   exceed that of the StaticOutput!
-    StaticOutput(const Input& input, const Filter& filter)
+    StaticOutput(const Input& input, const Filter& filter, size_t delay = 0)
       : OutputBase(input)
     {
-      _set_filter(filter);
+      _set_filter(filter, delay);
     }
 
   private:
-    void _set_filter(const Filter& filter)
+    void _set_filter(const Filter& filter, size_t delay = 0)
     {
       auto from = filter.begin();
 
       for (auto& to: _filter_ptrs)
       {
+        if (delay > 0)
+        {
+          to = &_empty_partition;
+          --delay;
+          continue;
+        }
         // If less partitions are given, the rest is set to zero
         to = (from == filter.end()) ? &_empty_partition : &*from++;
       }
@@ -127,7 +127,7 @@ class dummy_thread_policy::Semaphore
   public:
     using value_type = unsigned int;
 
-    explicit Semaphore(value_type = 0)
+    explicit Semaphore(value_type = 0, unsigned = 0)
     {
       APF_DUMMY_THREAD_POLICY_ERROR;
     }
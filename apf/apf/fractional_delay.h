@@ -0,0 +1,162 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the Audio Processing Framework (APF).                 *
+ *                                                                            *
+ * The APF is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The APF is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ *                                 http://AudioProcessingFramework.github.com *
+ ******************************************************************************/
+
+/// @file
+/// Interpolation kernels for fractional delays.
+
+#ifndef APF_FRACTIONAL_DELAY_H
+#define APF_FRACTIONAL_DELAY_H
+
+#include <cassert>  // for assert()
+#include <cmath>  // for std::sin(), std::cos()
+#include <stdexcept>  // for std::logic_error
+#include <string>
+
+#include "apf/math.h"  // for pi()
+#include "apf/container.h"  // for fixed_vector
+
+namespace apf
+{
+
+/** Table of FIR interpolation kernels for fractional delays.
+ * The coefficients are pre-computed for @p resolution equally spaced
+ * fractions between 0 and 1, the nearest one is used.
+ *
+ * A delay of @c i+f samples (with integer @c i and @c 0 <= f < 1) uses the
+ * samples with the delays @c i-before() up to @c i-before()+taps()-1.
+ * The coefficients returned by coefficients() belong to those samples in
+ * reverse order, i.e. the first coefficient is used for the oldest sample.
+ * Therefore, samples and coefficients can be read in the same direction.
+ *
+ * Only kernels with an even number of taps are supported (i.e. odd Lagrange
+ * orders), this way the fractional delay is always in the middle of the
+ * kernel.
+ *
+ * @see BlockDelayLine::read_block()
+ **/
+template<typename T>
+class DelayInterpolator
+{
+  public:
+    enum type
+    {
+      lagrange,  ///< Lagrange interpolation, @c order+1 taps
+      sinc  ///< Hann-windowed sinc, @c order+1 taps
+    };
+
+    /// Constructor.
+    /// @param kernel interpolation type
+    /// @param order interpolation order, must be odd
+    /// @param resolution number of pre-computed fractions
+    /// @throw std::logic_error if @p order is not odd
+    DelayInterpolator(type kernel, size_t order, size_t resolution = 1024)
+      : _taps(order + 1)
+      , _before(order / 2)
+      , _resolution(resolution)
+      , _table(_taps * (resolution + 1))
+    {
+      if (order % 2 == 0)
+      {
+        throw std::logic_error(
+            "DelayInterpolator: Interpolation order must be odd!");
+      }
+      assert(resolution > 0);
+
+      for (size_t row = 0; row <= resolution; ++row)
+      {
+        T f = T(row) / T(resolution);
+        auto c = _table.begin() + row * _taps;
+        T sum = 0;
+        for (size_t j = 0; j < _taps; ++j)
+        {
+          c[j] = kernel == lagrange ? _lagrange(j, f) : _sinc(j, f);
+          sum += c[j];
+        }
+        if (kernel == sinc)
+        {
+          // normalize to unity gain at DC
+          for (size_t j = 0; j < _taps; ++j) c[j] /= sum;
+        }
+      }
+    }
+
+    /// Number of coefficients
+    size_t taps() const { return _taps; }
+
+    /// Number of samples used with less delay than the integer delay
+    size_t before() const { return _before; }
+
+    /// Coefficients for the fractional delay @p fraction (0 <= fraction < 1).
+    const T* coefficients(T fraction) const
+    {
+      assert(0 <= fraction && fraction <= 1);
+      auto row = static_cast<size_t>(fraction * T(_resolution) + T(0.5));
+      return _table.data() + row * _taps;
+    }
+
+    /// Convert string to interpolation type.
+    /// @throw std::logic_error if @p name is unknown
+    static type from_string(const std::string& name)
+    {
+      if (name == "lagrange") return lagrange;
+      if (name == "sinc") return sinc;
+      throw std::logic_error("DelayInterpolator: Unknown type \"" + name
+          + "\"!");
+    }
+
+  private:
+    /// Delay (relative to the integer delay) of coefficient @p j
+    T _position(size_t j) const { return T(_taps - 1 - _before - j); }
+
+    T _lagrange(size_t j, T f) const
+    {
+      T result = 1;
+      for (size_t m = 0; m < _taps; ++m)
+      {
+        if (m == j) continue;
+        result *= (f - _position(m)) / (_position(j) - _position(m));
+      }
+      return result;
+    }
+
+    T _sinc(size_t j, T f) const
+    {
+      T x = f - _position(j);
+      T half_length = T(_taps) / 2;
+      if (std::abs(x) >= half_length) return 0;
+      T window = T(0.5) * (1 + std::cos(math::pi<T>() * x / half_length));
+      if (x == 0) return window;
+      return window * std::sin(math::pi<T>() * x) / (math::pi<T>() * x);
+    }
+
+    const size_t _taps, _before, _resolution;
+    fixed_vector<T> _table;
+};
+
+}  // namespace apf
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -29,6 +29,9 @@
 
 #include <cassert>  // for assert()
 #include <stdexcept>  // for std::logic_error
+#include <atomic>  // for std::atomic
+#include <memory>  // for std::unique_ptr
+#include <algorithm>  // for std::find()
 
 #include "apf/rtlist.h"
 #include "apf/parameter_map.h"
@@ -101,6 +104,25 @@ class disable_queries
  *   jack_policy, pointer_policy<T*>) or write your own policy class.
  * @tparam thread_policy Policy for threads, locks and semaphores.
  *
+ * By default, the items of each list are distributed in a fixed round-robin
+ * order to the threads.
+ * If the parameter @c "dynamic_scheduling" is @b true, each thread takes the
+ * next unprocessed item (using an atomic counter) as soon as it has finished
+ * the previous one.
+ * This is better for items with very different processing time, but it
+ * causes some more inter-thread communication.
+ *
+ * The parameter @c "spin_count" is passed to the semaphores which are used to
+ * start the worker threads and to wait for them (see
+ * posix_thread_policy::Semaphore), 0 (the default) means that threads are put
+ * to sleep immediately.
+ * Spinning only pays off if each audio thread has a CPU core of its own.
+ *
+ * Several lists can be processed as a dependency graph with _process_graph().
+ * Instead of waiting for all items of one list before the next list is
+ * started, each item waits only for the items it actually depends on (see
+ * wait_for()).
+ *
  * Example: @ref MimoProcessor
  **/
 template<typename Derived
@@ -124,10 +146,17 @@ class MimoProcessor : public interface_policy
     /// Abstract base class for list items.
     struct Item : NonCopyable
     {
+      Item() : _cycle(0) {}
       virtual ~Item() = default;
 
       /// to be overwritten in the derived class
       virtual void process() = 0;
+
+      private:
+        friend class MimoProcessor;
+
+        /// Number of the last _process_graph() call which processed the item
+        std::atomic<unsigned> _cycle;
     };
 
     /** Base class for items which have a @c Process class.
@@ -253,6 +282,39 @@ class MimoProcessor : public interface_policy
 
     void wait_for_rt_thread() { _fifo.wait(); }
 
+    /** Wait until @p item is processed.
+     * This can be called from the process() function of an item during
+     * _process_graph(), @p item must be at an earlier position in the same
+     * graph.
+     * The thread busy-waits for "spin_count" cycles, afterwards it sleeps
+     * until the item is finished.
+     * Outside of _process_graph(), this returns immediately.
+     **/
+    void wait_for(const Item& item) const
+    {
+      if (!_graph) return;
+
+      assert(std::find(_current_list->begin(), _current_list->end(), &item)
+          != _current_list->end());
+
+      // The item is being processed by another thread, this shouldn't take
+      // long, unless the other thread was preempted.
+      for (unsigned spin = 0; spin < _spin_count; ++spin)
+      {
+        if (_is_processed(item)) return;
+      }
+
+      while (!_is_processed(item))
+      {
+        _graph_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        // Either we see the finished item here, or its thread sees us.
+        // In the first case, its post() leads to a spurious wake-up later.
+        if (_is_processed(item)) return;
+        assert(_graph_semaphore);
+        _graph_semaphore->wait();
+      }
+    }
+
     template<typename X>
     X* add()
     {
@@ -275,6 +337,9 @@ class MimoProcessor : public interface_policy
     const rtlist_t& get_input_list() const { return _input_list; }
     const rtlist_t& get_output_list() const { return _output_list; }
 
+    /// Number of threads used for processing (including the main thread)
+    int num_threads() const { return _num_threads; }
+
     const parameter_map params;
 
     template<typename F>
@@ -298,6 +363,7 @@ class MimoProcessor : public interface_policy
     ~MimoProcessor()
     {
       this->deactivate();
+      _stop_worker_threads();
       _input_list.clear();
       _output_list.clear();
     }
@@ -305,6 +371,10 @@ class MimoProcessor : public interface_policy
     void _process_list(rtlist_t& l);
     void _process_list(rtlist_t& l1, rtlist_t& l2);
 
+    void _process_graph(rtlist_t& l);
+    void _process_graph(rtlist_t& l1, rtlist_t& l2);
+    void _process_graph(rtlist_t& l1, rtlist_t& l2, rtlist_t& l3);
+
     CommandQueue _fifo;
 
   private:
@@ -318,8 +388,8 @@ class MimoProcessor : public interface_policy
 
       public:
         WorkerThread(int thread_number, MimoProcessor& parent)
-          : cont_semaphore(0)
-          , wait_semaphore(0)
+          : cont_semaphore(0, parent._spin_count)
+          , wait_semaphore(0, parent._spin_count)
           , _thread(WorkerThreadFunction(thread_number, parent, *this))
         {
           // Set thread priority from interface_policy, if available
@@ -345,15 +415,24 @@ class MimoProcessor : public interface_policy
           , _thread(thread)
         {}
 
-        void operator()()
+        /// @return @b false if the thread should be stopped
+        bool operator()()
         {
           // wait for main thread
           _thread.cont_semaphore.wait();
 
+          if (!_parent._current_list)
+          {
+            // The parent is about to be destroyed, don't touch it afterwards
+            _thread.wait_semaphore.post();
+            return false;
+          }
+
           _parent._process_selected_items_in_current_list(_thread_number);
 
           // report to main thread
           _thread.wait_semaphore.post();
+          return true;
         }
 
       private:
@@ -376,6 +455,13 @@ class MimoProcessor : public interface_policy
 
     void _process_current_list_in_main_thread();
     void _process_selected_items_in_current_list(int thread_number);
+    void _stop_worker_threads();
+    void _process_next_items_in_current_list();
+
+    bool _is_processed(const Item& item) const
+    {
+      return item._cycle.load(std::memory_order_seq_cst) == _graph_cycle;
+    }
 
     Input* _add_helper(Input* in) { return _input_list.add(in); }
     Output* _add_helper(Output* out) { return _output_list.add(out); }
@@ -386,6 +472,22 @@ class MimoProcessor : public interface_policy
     /// Number of threads (main thread plus worker threads)
     const int _num_threads;
 
+    const bool _dynamic_scheduling;
+
+    /// Busy-wait time of semaphores before blocking (see thread_policy)
+    const unsigned _spin_count;
+
+    /// Index of next unprocessed item (only for dynamic scheduling)
+    std::atomic<size_t> _next_item;
+
+    bool _graph;  ///< Is _current_list processed by _process_graph()?
+    unsigned _graph_cycle;  ///< Number of current _process_graph() call
+    /// Number of threads which are (about to be) sleeping in wait_for()
+    mutable std::atomic<int> _graph_sleepers;
+    /// Sleeping threads in wait_for() are woken up with this (only if there
+    /// are several threads)
+    std::unique_ptr<typename thread_policy::Semaphore> _graph_semaphore;
+
     fixed_vector<WorkerThread> _thread_data;
 
     rtlist_t _input_list, _output_list;
@@ -401,6 +503,12 @@ APF_MIMOPROCESSOR_BASE::MimoProcessor(const parameter_map& params_)
   , _current_list(nullptr)
   , _num_threads(params.get("threads"
         , thread_policy::default_number_of_threads()))
+  , _dynamic_scheduling(params.get("dynamic_scheduling", false))
+  , _spin_count(params.get("spin_count", 0u))
+  , _next_item(0)
+  , _graph(false)
+  , _graph_cycle(0)
+  , _graph_sleepers(0)
   , _input_list(_fifo)
   , _output_list(_fifo)
 {
@@ -415,6 +523,10 @@ APF_MIMOPROCESSOR_BASE::MimoProcessor(const parameter_map& params_)
   {
     _thread_data.emplace_back(i, *this);
   }
+  if (_num_threads > 1)
+  {
+    _graph_semaphore.reset(new typename thread_policy::Semaphore);
+  }
 }
 
 APF_MIMOPROCESSOR_TEMPLATES
@@ -446,12 +558,65 @@ APF_MIMOPROCESSOR_BASE::_process_list(rtlist_t& l1, rtlist_t& l2)
   // not exception-safe (original lists are not restored), but who cares?
 }
 
+/** Process a list as dependency graph.
+ * Items are started in list order (each one as soon as a thread is free), but
+ * they don't wait for all previous items to be finished.
+ * An item which needs the result of a previous item has to call wait_for() in
+ * its process() function.
+ * Because items are started in order, this cannot lead to a deadlock.
+ **/
+APF_MIMOPROCESSOR_TEMPLATES
+void
+APF_MIMOPROCESSOR_BASE::_process_graph(rtlist_t& l)
+{
+  _current_list = &l;
+  _graph = true;
+  if (++_graph_cycle == 0) ++_graph_cycle;  // 0 means "never processed"
+  _process_current_list_in_main_thread();
+  _graph = false;
+}
+
+/// Process two lists as one dependency graph.
+/// @see _process_graph(rtlist_t&), _process_list(rtlist_t&, rtlist_t&)
+APF_MIMOPROCESSOR_TEMPLATES
+void
+APF_MIMOPROCESSOR_BASE::_process_graph(rtlist_t& l1, rtlist_t& l2)
+{
+  auto temp = l2.begin();
+  l2.splice(temp, l1);  // join lists: "L2 = L1 + L2"
+  _process_graph(l2);
+  l1.splice(l1.end(), l2, l2.begin(), temp);  // restore original lists
+}
+
+/// Process three lists as one dependency graph.
+/// @see _process_graph(rtlist_t&)
+APF_MIMOPROCESSOR_TEMPLATES
+void
+APF_MIMOPROCESSOR_BASE::_process_graph(rtlist_t& l1, rtlist_t& l2
+    , rtlist_t& l3)
+{
+  auto temp2 = l3.begin();
+  l3.splice(temp2, l2);  // "L3 = L2 + L3"
+  auto temp1 = l3.begin();
+  l3.splice(temp1, l1);  // "L3 = L1 + L2 + L3"
+  _process_graph(l3);
+  l1.splice(l1.end(), l3, l3.begin(), temp1);  // restore original lists
+  l2.splice(l2.end(), l3, l3.begin(), temp2);
+}
+
 APF_MIMOPROCESSOR_TEMPLATES
 void
 APF_MIMOPROCESSOR_BASE::_process_selected_items_in_current_list(int thread_number)
 {
   assert(_current_list);
 
+  // A graph needs in-order claiming of items, otherwise it could deadlock
+  if (_dynamic_scheduling || _graph)
+  {
+    _process_next_items_in_current_list();
+    return;
+  }
+
   int n = 0;
   for (auto& i: *_current_list)
   {
@@ -463,6 +628,46 @@ APF_MIMOPROCESSOR_BASE::_process_selected_items_in_current_list(int thread_numbe
   }
 }
 
+/** Process items in the order in which they are claimed by the threads.
+ * Each thread walks through the list once, it only stops at the items it
+ * has claimed.
+ * The list itself is not changed, therefore no locks are needed.
+ **/
+APF_MIMOPROCESSOR_TEMPLATES
+void
+APF_MIMOPROCESSOR_BASE::_process_next_items_in_current_list()
+{
+  auto item = _current_list->begin();
+  size_t position = 0;
+
+  for (;;)
+  {
+    // The list is synchronized by the semaphores, the order of other memory
+    // operations doesn't matter here.
+    auto next = _next_item.fetch_add(1, std::memory_order_relaxed);
+
+    // Claimed indices are increasing, no need to go back
+    for (; position < next && item != _current_list->end(); ++position)
+    {
+      ++item;
+    }
+    if (item == _current_list->end()) break;
+
+    assert(*item);
+    (*item)->process();
+    (*item)->_cycle.store(_graph_cycle, std::memory_order_seq_cst);
+
+    // Wake up all threads in wait_for(), they check if their item is ready
+    if (_graph_sleepers.load(std::memory_order_seq_cst) > 0)
+    {
+      for (int n = _graph_sleepers.exchange(0); n > 0; --n)
+      {
+        _graph_semaphore->post();
+      }
+    }
+  }
+}
+
 APF_MIMOPROCESSOR_TEMPLATES
 void
 APF_MIMOPROCESSOR_BASE::_process_current_list_in_main_thread()
@@ -470,6 +675,9 @@ APF_MIMOPROCESSOR_BASE::_process_current_list_in_main_thread()
   assert(_current_list);
   if (_current_list->empty()) return;
 
+  // This is visible to the worker threads after posting the semaphores
+  _next_item.store(0, std::memory_order_relaxed);
+
   // wake all threads
   for (auto& it: _thread_data) it.cont_semaphore.post();
 
@@ -479,6 +687,20 @@ APF_MIMOPROCESSOR_BASE::_process_current_list_in_main_thread()
   for (auto& it: _thread_data) it.wait_semaphore.wait();
 }
 
+/** Let all worker threads finish.
+ * This is necessary because worker threads may still be busy-waiting on their
+ * semaphores, which would be destroyed afterwards.
+ **/
+APF_MIMOPROCESSOR_TEMPLATES
+void
+APF_MIMOPROCESSOR_BASE::_stop_worker_threads()
+{
+  _current_list = nullptr;  // signal to stop
+
+  for (auto& it: _thread_data) it.cont_semaphore.post();
+  for (auto& it: _thread_data) it.wait_semaphore.wait();
+}
+
 APF_MIMOPROCESSOR_TEMPLATES
 class APF_MIMOPROCESSOR_BASE::Xput : public Item
 {
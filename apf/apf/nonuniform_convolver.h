@@ -0,0 +1,833 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the Audio Processing Framework (APF).                 *
+ *                                                                            *
+ * The APF is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The APF is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ *                                 http://AudioProcessingFramework.github.com *
+ ******************************************************************************/
+
+/// @file
+/// Non-uniformly partitioned convolution engine.
+
+#ifndef APF_NONUNIFORM_CONVOLVER_H
+#define APF_NONUNIFORM_CONVOLVER_H
+
+#include <vector>
+#include <algorithm>  // for std::min(), std::copy_n()
+#include <memory>  // for std::unique_ptr
+#include <iterator>  // for std::distance(), std::advance()
+#include <cassert>
+
+#include "apf/convolver.h"  // for conv::Input, conv::Output, ...
+#include "apf/container.h"  // for fixed_vector
+
+namespace apf
+{
+
+namespace conv
+{
+
+/** Non-uniformly partitioned convolution.
+ * The filter is split into consecutive segments, each of which is handled by
+ * a uniformly partitioned convolution (see Input, Output, StaticOutput).
+ * The first segment (the "head") uses the audio block size and is computed
+ * in every audio block.
+ * Each later segment (the "tail") uses a larger block size and is computed
+ * only once per (own) block, i.e. at a correspondingly lower rate.
+ * The result of a tail segment block is delivered one (own) block after the
+ * block following its input, which is possible without additional latency
+ * because each tail segment starts at a filter position of at least twice its
+ * own block size.
+ * In the meantime, the segment is computed in a single audio block, the
+ * segments use different audio blocks (see OutputBase::_update_tail()).
+ *
+ * The classes in this namespace have the same interface as their uniform
+ * counterparts in apf::conv, except that the block size and the number of
+ * partitions are replaced by a Layout.
+ * A Layout with only one segment leads to uniformly partitioned convolution.
+ **/
+namespace nonuniform
+{
+
+/// Segmentation of a filter into uniformly partitioned parts.
+class Layout
+{
+  public:
+    /// Part of the filter which is handled by uniformly partitioned convolution
+    struct Segment
+    {
+      size_t block_size;  ///< Partition size is twice the block size
+      size_t offset;  ///< Index of the first filter coefficient
+      size_t partitions;  ///< Number of partitions (of the filter segment)
+
+      /// Number of (zero) partitions of delay, the first partition of a tail
+      /// segment is already used two blocks earlier.
+      size_t delay() const
+      {
+        return (this->offset == 0) ? 0 : this->offset / this->block_size - 2;
+      }
+    };
+
+    using const_iterator = std::vector<Segment>::const_iterator;
+
+    Layout(size_t block_size_, size_t filter_size, size_t head_partitions = 0
+        , size_t max_block_size = 0);
+
+    /// Audio block size (= block size of the first segment)
+    size_t block_size() const { return _segments.front().block_size; }
+    /// Number of segments (including the head)
+    size_t size() const { return _segments.size(); }
+    /// Number of filter coefficients which can be handled
+    size_t filter_size() const
+    {
+      return _segments.back().offset
+        + _segments.back().block_size * _segments.back().partitions;
+    }
+
+    const Segment& operator[](size_t n) const { return _segments[n]; }
+    const_iterator begin() const { return _segments.begin(); }
+    const_iterator end() const { return _segments.end(); }
+
+  private:
+    std::vector<Segment> _segments;
+};
+
+/** Constructor.
+ * The head segment has (at least) @p head_partitions partitions, afterwards
+ * the block size is doubled after (at least) as many partitions.
+ * The number of partitions in each segment is increased where necessary to
+ * make sure that the next segment starts at a multiple of its block size and
+ * at least at twice its block size.
+ * @param block_size_ audio block size
+ * @param filter_size number of filter coefficients
+ * @param head_partitions number of partitions per segment. If 0, there is only
+ *   one segment, which leads to uniformly partitioned convolution.
+ * @param max_block_size maximum block size of tail segments (0: no limit)
+ **/
+Layout::Layout(size_t block_size_, size_t filter_size, size_t head_partitions
+    , size_t max_block_size)
+{
+  auto offset = size_t(0);
+  auto size = block_size_;
+
+  for (;;)
+  {
+    auto remaining = std::max(min_partitions(size, filter_size - offset)
+        , size_t(1));
+    auto partitions = head_partitions;
+
+    if (head_partitions == 0
+        || (max_block_size != 0 && 2 * size > max_block_size))
+    {
+      partitions = remaining;
+    }
+    else
+    {
+      // Next segment must start at a multiple of its own block size (but not
+      // before its second block)
+      while ((offset + partitions * size) % (2 * size) != 0
+          || offset + partitions * size < 4 * size)
+      {
+        ++partitions;
+      }
+    }
+
+    if (partitions >= remaining)
+    {
+      _segments.push_back(Segment{size, offset, remaining});
+      break;
+    }
+    _segments.push_back(Segment{size, offset, partitions});
+    offset += partitions * size;
+    size *= 2;
+  }
+}
+
+/// Container holding one uniformly partitioned filter per segment.
+struct Filter : fixed_vector<conv::Filter>
+{
+  /// Constructor; create empty filter.
+  explicit Filter(const Layout& layout_)
+    : _layout(layout_)
+  {
+    this->reserve(_layout.size());
+    for (const auto& segment: _layout)
+    {
+      this->emplace_back(segment.block_size, segment.partitions);
+    }
+  }
+
+  /// Constructor from time domain coefficients.
+  template<typename In>
+  Filter(const Layout& layout_, In first, In last);
+  // Implementation below, after definition of Transform
+
+  const Layout& layout() const { return _layout; }
+  size_t block_size() const { return _layout.block_size(); }
+
+  private:
+    const Layout _layout;
+};
+
+/// Helper class to prepare filters
+class Transform
+{
+  public:
+    explicit Transform(const Layout& layout_)
+      : _layout(layout_)
+    {
+      _transforms.reserve(_layout.size());
+      for (const auto& segment: _layout)
+      {
+        _transforms.emplace_back(segment.block_size);
+      }
+    }
+
+    template<typename In>
+    void prepare_filter(In first, In last, Filter& filter) const;
+
+    const Layout& layout() const { return _layout; }
+    size_t block_size() const { return _layout.block_size(); }
+
+  private:
+    const Layout _layout;
+    fixed_vector<conv::Transform> _transforms;
+};
+
+/** %Transform time-domain samples.
+ * If there are too few input samples, the rest is zero-padded, if there are
+ * more samples than the Layout can handle, the rest is ignored.
+ * @param first Iterator to first time-domain sample
+ * @param last Past-the-end iterator
+ * @param[out] filter Target container, must have the same Layout
+ **/
+template<typename In>
+void
+Transform::prepare_filter(In first, In last, Filter& filter) const
+{
+  assert(filter.size() == _layout.size());
+
+  const auto size = size_t(std::distance(first, last));
+
+  for (size_t i = 0; i < _layout.size(); ++i)
+  {
+    const auto& segment = _layout[i];
+
+    auto segment_first = first;
+    std::advance(segment_first, std::min(segment.offset, size));
+    auto segment_last = first;
+    std::advance(segment_last, std::min(segment.offset
+          + segment.partitions * segment.block_size, size));
+
+    _transforms[i].prepare_filter(segment_first, segment_last, filter[i]);
+  }
+}
+
+template<typename In>
+Filter::Filter(const Layout& layout_, In first, In last)
+  : Filter(layout_)
+{
+  Transform(_layout).prepare_filter(first, last, *this);
+}
+
+/** %Input stage of non-uniformly partitioned convolution.
+ * New audio data is fed in here, further processing happens in Output.
+ **/
+class Input
+{
+  public:
+    explicit Input(const Layout& layout_);
+
+    template<typename In>
+    void add_block(In first);
+
+    const Layout& layout() const { return _layout; }
+    size_t block_size() const { return _layout.block_size(); }
+
+    /// Number of blocks added so far
+    size_t blocks() const { return _blocks; }
+
+    /// Uniformly partitioned input stages, one per segment
+    fixed_vector<conv::Input> segments;
+
+  private:
+    const Layout _layout;
+
+    /// Collect audio blocks for tail segments
+    fixed_vector<fixed_vector<float>> _buffers;
+
+    size_t _blocks;
+};
+
+Input::Input(const Layout& layout_)
+  : _layout(layout_)
+  , _blocks(0)
+{
+  this->segments.reserve(_layout.size());
+  _buffers.reserve(_layout.size());
+  for (const auto& segment: _layout)
+  {
+    this->segments.emplace_back(segment.block_size
+        , segment.delay() + segment.partitions);
+    // Head segment doesn't need a buffer
+    _buffers.emplace_back(segment.offset == 0 ? 0 : segment.block_size);
+  }
+}
+
+/** Add a block of time-domain input samples.
+ * @param first Iterator to first sample.
+ * @tparam In Forward iterator
+ **/
+template<typename In>
+void
+Input::add_block(In first)
+{
+  const auto block_size = this->block_size();
+
+  this->segments.front().add_block(first);
+
+  for (size_t i = 1; i < _layout.size(); ++i)
+  {
+    auto& buffer = _buffers[i];
+    auto ratio = buffer.size() / block_size;
+    auto position = _blocks % ratio;
+
+    std::copy_n(first, block_size, buffer.begin() + position * block_size);
+
+    if (position == ratio - 1)
+    {
+      this->segments[i].add_block(buffer.begin());
+    }
+  }
+  ++_blocks;
+}
+
+/** Frequency-domain accumulation of convolution results.
+ * The head segments are accumulated in the frequency domain (see
+ * conv::Accumulator), the tail segments (which are computed in the time
+ * domain anyway) are added to a separate buffer.
+ **/
+class Accumulator
+{
+  public:
+    explicit Accumulator(size_t block_size)
+      : _head(block_size)
+      , _tail(block_size)
+      , _tail_zero(true)
+    {}
+
+    /// Remove all contributions
+    void clear()
+    {
+      _head.clear();
+      _tail_zero = true;
+    }
+
+    /// @return @b true if nothing (except zeros) has been accumulated
+    bool empty() const { return _head.empty() && _tail_zero; }
+
+    size_t block_size() const { return _head.block_size(); }
+
+    /// Add the contents of another Accumulator (with the same block size)
+    void add(const Accumulator& other, float weight = 1.0f)
+    {
+      _head.add(other._head, weight);
+      if (!other._tail_zero) _add_tail(other._tail.data(), weight);
+    }
+
+    float* ifft();
+
+  private:
+    template<typename> friend class OutputBase;
+
+    void _add_tail(const float* first, float weight);
+
+    conv::Accumulator _head;
+    fixed_vector<float> _tail;
+    bool _tail_zero;
+};
+
+/** Transform the accumulated results to the time domain.
+ * Afterwards, the Accumulator is empty.
+ * @return pointer to the first sample of the result.
+ **/
+float*
+Accumulator::ifft()
+{
+  auto result = _head.ifft();
+
+  if (!_tail_zero)
+  {
+    for (size_t i = 0; i < _tail.size(); ++i)
+    {
+      result[i] += _tail[i];
+    }
+    _tail_zero = true;
+  }
+  return result;
+}
+
+void
+Accumulator::_add_tail(const float* first, float weight)
+{
+  if (_tail_zero)
+  {
+    std::transform(first, first + _tail.size(), _tail.begin()
+        , [weight] (float x) { return weight * x; });
+    _tail_zero = false;
+  }
+  else
+  {
+    for (size_t i = 0; i < _tail.size(); ++i)
+    {
+      _tail[i] += weight * first[i];
+    }
+  }
+}
+
+/** Base class for Output and StaticOutput.
+ * @tparam SegmentOutput Uniformly partitioned output stage (conv::Output or
+ *   conv::StaticOutput)
+ **/
+template<typename SegmentOutput>
+class OutputBase
+{
+  public:
+    float* convolve(float weight = 1.0f);
+    void accumulate(Accumulator& target, float weight = 1.0f);
+
+    const Layout& layout() const { return _input.layout(); }
+    size_t block_size() const { return _input.block_size(); }
+
+  protected:
+    explicit OutputBase(const Input& input);
+
+    /// State of a tail segment
+    struct TailState
+    {
+      size_t ratio;  ///< Block size relative to audio block size
+      size_t delay;  ///< see Layout::Segment::delay()
+      size_t phase;  ///< Audio block (after a boundary) to compute the segment
+      size_t computed;  ///< Boundary of the latest computed result (or -1)
+      size_t stored[2];  ///< Boundaries of the results in _results (or -1)
+      size_t boundary;  ///< Block up to which filter changes were applied
+      const conv::Filter* pending;  ///< Filter to be set at next boundary
+      size_t pending_block;  ///< Block in which set_filter() was called
+    };
+
+    /// Most recent block in which the input of tail segment @p i was updated
+    size_t _latest_boundary(size_t i) const
+    {
+      return _input.blocks() / _tail[i].ratio * _tail[i].ratio;
+    }
+
+    /// Uniformly partitioned output stages, one per segment
+    fixed_vector<SegmentOutput> _segments;
+
+    /// Index 0 (the head segment) is unused
+    fixed_vector<TailState> _tail;
+
+    const Input& _input;
+
+  private:
+    void _update_tail();
+
+    /// Two results per tail segment, the one which is currently used and the
+    /// one which is computed for later
+    fixed_vector<fixed_vector<float>> _results;
+
+    fixed_vector<float> _tail_buffer;
+    bool _tail_zero;
+    size_t _tail_block;
+};
+
+template<typename SegmentOutput>
+OutputBase<SegmentOutput>::OutputBase(const Input& input)
+  : _tail(input.layout().size())
+  , _input(input)
+  , _tail_buffer(input.block_size())
+  , _tail_zero(true)
+  , _tail_block(0)
+{
+  _segments.reserve(input.layout().size());
+  _results.reserve(input.layout().size());
+
+  for (size_t i = 0; i < _tail.size(); ++i)
+  {
+    const auto& segment = input.layout()[i];
+    _tail[i].ratio = segment.block_size / input.block_size();
+    _tail[i].delay = segment.delay();
+    // Block sizes are doubled from segment to segment, with these phases no
+    // two segments are computed in the same audio block:
+    // ratio 2: 0, 2, 4, ...; ratio 4: 1, 5, 9, ...; ratio 8: 3, 11, 19, ...
+    _tail[i].phase = _tail[i].ratio / 2 - 1;
+    _tail[i].computed = size_t(-1);
+    _tail[i].stored[0] = size_t(-1);
+    _tail[i].stored[1] = size_t(-1);
+    _tail[i].boundary = 0;
+    _tail[i].pending = nullptr;
+    _tail[i].pending_block = 0;
+    // Head segment doesn't need result buffers
+    _results.emplace_back(i == 0 ? 0 : 2 * segment.block_size);
+  }
+}
+
+/** Fast convolution of one audio block.
+ * %Input data has to be supplied with Input::add_block().
+ * This may be called several times per audio block (e.g. for crossfades),
+ * the tail segments are only computed once.
+ * @param weight amplitude weighting factor for current audio block.
+ * @return pointer to the first sample of the convolved (and weighted) signal
+ **/
+template<typename SegmentOutput>
+float*
+OutputBase<SegmentOutput>::convolve(float weight)
+{
+  _update_tail();
+
+  auto result = _segments.front().convolve(weight);
+
+  if (!_tail_zero)
+  {
+    for (size_t i = 0; i < _tail_buffer.size(); ++i)
+    {
+      result[i] += weight * _tail_buffer[i];
+    }
+  }
+  return result;
+}
+
+/** Fast convolution of one audio block, without IFFT of the head segment.
+ * Like convolve(), but the (weighted) result is added to @p target.
+ * @param target Accumulator with the same block size
+ * @param weight amplitude weighting factor for current audio block.
+ **/
+template<typename SegmentOutput>
+void
+OutputBase<SegmentOutput>::accumulate(Accumulator& target, float weight)
+{
+  _update_tail();
+
+  _segments.front().accumulate(target._head, weight);
+
+  if (!_tail_zero)
+  {
+    target._add_tail(_tail_buffer.data(), weight);
+  }
+}
+
+/** Collect contributions of all tail segments to the current audio block.
+ * If necessary, tail segments are computed.
+ * The result of a tail segment block is used during @c ratio audio blocks,
+ * starting @c ratio blocks after the input of the segment block was
+ * completed.
+ * In the meantime, it is computed once (in the audio block given by
+ * @c phase), which spreads the computational load of the tail segments over
+ * time.
+ * If no convolve() call happens until the input of the segment changes
+ * again, the contribution is lost.
+ **/
+template<typename SegmentOutput>
+void
+OutputBase<SegmentOutput>::_update_tail()
+{
+  const auto blocks = _input.blocks();
+
+  if (blocks == _tail_block) return;  // Already done for this block
+
+  _tail_block = blocks;
+  _tail_zero = true;
+
+  const auto block_size = this->block_size();
+
+  for (size_t i = 1; i < _segments.size(); ++i)
+  {
+    auto& tail = _tail[i];
+    const auto segment_size = tail.ratio * block_size;
+
+    // Block in which the segment block used in the current block was completed
+    auto used = (blocks - 1) / tail.ratio * tail.ratio;
+
+    if (used >= tail.ratio)
+    {
+      used -= tail.ratio;
+      auto slot = used / tail.ratio % 2;
+
+      if (tail.stored[slot] == used)
+      {
+        auto chunk = _results[i].data() + slot * segment_size
+          + ((blocks - 1) % tail.ratio) * block_size;
+
+        if (_tail_zero)
+        {
+          std::copy(chunk, chunk + block_size, _tail_buffer.begin());
+          _tail_zero = false;
+        }
+        else
+        {
+          for (size_t n = 0; n < block_size; ++n)
+          {
+            _tail_buffer[n] += chunk[n];
+          }
+        }
+      }
+    }
+
+    const auto latest = _latest_boundary(i);
+
+    if (tail.computed != latest && blocks - latest >= tail.phase)
+    {
+      tail.computed = latest;
+      auto slot = latest / tail.ratio % 2;
+      auto result = _segments[i].convolve();
+      std::copy(result, result + segment_size
+          , _results[i].begin() + slot * segment_size);
+      tail.stored[slot] = latest;
+    }
+  }
+}
+
+/** Convolution engine (output part).
+ * The filter of the head segment is updated like in conv::Output.
+ * Filter changes of tail segments are applied at their block boundaries
+ * (i.e. all input samples of one segment block use the same filter), their
+ * queues are rotated automatically.
+ * @see Input, StaticOutput
+ **/
+class Output : public OutputBase<conv::Output>
+{
+  public:
+    explicit Output(const Input& input);
+
+    float* convolve(float weight = 1.0f);
+    void accumulate(Accumulator& target, float weight = 1.0f);
+
+    void set_filter(const Filter& filter);
+
+    bool queues_empty() const;
+    void rotate_queues();
+
+  private:
+    void _advance(size_t i);
+};
+
+Output::Output(const Input& input)
+  : OutputBase<conv::Output>(input)
+{
+  for (const auto& segment: input.segments)
+  {
+    _segments.emplace_back(segment);
+  }
+}
+
+/// @see OutputBase::convolve()
+float*
+Output::convolve(float weight)
+{
+  for (size_t i = 1; i < _segments.size(); ++i)
+  {
+    _advance(i);
+  }
+  return OutputBase<conv::Output>::convolve(weight);
+}
+
+/// @see OutputBase::accumulate()
+void
+Output::accumulate(Accumulator& target, float weight)
+{
+  for (size_t i = 1; i < _segments.size(); ++i)
+  {
+    _advance(i);
+  }
+  OutputBase<conv::Output>::accumulate(target, weight);
+}
+
+/** Set a new filter.
+ * @param filter Filter with the same Layout as the Input.
+ **/
+void
+Output::set_filter(const Filter& filter)
+{
+  assert(filter.size() == _segments.size());
+
+  _segments.front().set_filter(filter.front());
+
+  for (size_t i = 1; i < _segments.size(); ++i)
+  {
+    _advance(i);
+
+    auto& tail = _tail[i];
+
+    if (tail.boundary == _input.blocks() && tail.computed != tail.boundary)
+    {
+      // Segment block has just been completed, its result is not computed yet
+      _segments[i].set_filter(filter[i], tail.delay);
+      tail.pending = nullptr;
+    }
+    else
+    {
+      tail.pending = &filter[i];
+      tail.pending_block = _input.blocks();
+    }
+  }
+}
+
+/** Check if there are still valid partitions in the queues.
+ * @see conv::Output::queues_empty()
+ **/
+bool
+Output::queues_empty() const
+{
+  if (!_segments.front().queues_empty()) return false;
+
+  for (size_t i = 1; i < _segments.size(); ++i)
+  {
+    if (_tail[i].pending || !_segments[i].queues_empty()) return false;
+  }
+  return true;
+}
+
+/** Update filter queues of the head segment.
+ * The queues of tail segments are updated automatically.
+ * @see conv::Output::rotate_queues()
+ **/
+void
+Output::rotate_queues()
+{
+  _segments.front().rotate_queues();
+}
+
+/// Apply filter changes of tail segment @p i up to its latest boundary.
+void
+Output::_advance(size_t i)
+{
+  auto& tail = _tail[i];
+  auto& segment = _segments[i];
+
+  const auto target = _latest_boundary(i);
+
+  while (tail.boundary < target)
+  {
+    if (tail.pending == nullptr && segment.queues_empty())
+    {
+      // Nothing left to do
+      tail.boundary = target;
+      break;
+    }
+
+    tail.boundary += tail.ratio;
+
+    if (!segment.queues_empty()) segment.rotate_queues();
+
+    if (tail.pending && tail.pending_block < tail.boundary)
+    {
+      segment.set_filter(*tail.pending, tail.delay);
+      tail.pending = nullptr;
+    }
+  }
+}
+
+/** %Convolver output stage with static filter.
+ * @see Output, conv::StaticOutput
+ **/
+class StaticOutput : public OutputBase<conv::StaticOutput>
+{
+  public:
+    /// Constructor from time domain samples
+    template<typename In>
+    StaticOutput(const Input& input, In first, In last)
+      : OutputBase<conv::StaticOutput>(input)
+      , _filter(new Filter(input.layout(), first, last))
+    {
+      _set_filter(*_filter);
+    }
+
+    /// Constructor from existing frequency domain filter coefficients.
+    /// @attention The filter coefficients are not copied, their lifetime must
+    ///   exceed that of the StaticOutput!
+    StaticOutput(const Input& input, const Filter& filter)
+      : OutputBase<conv::StaticOutput>(input)
+    {
+      _set_filter(filter);
+    }
+
+  private:
+    void _set_filter(const Filter& filter)
+    {
+      assert(filter.size() == _tail.size());
+
+      for (size_t i = 0; i < _tail.size(); ++i)
+      {
+        _segments.emplace_back(_input.segments[i], filter[i], _tail[i].delay);
+      }
+    }
+
+    // This is only used for the first constructor!
+    std::unique_ptr<Filter> _filter;
+};
+
+/// Combination of Input and Output
+struct Convolver : Input, Output
+{
+  explicit Convolver(const Layout& layout_)
+    : Input(layout_)
+    // static_cast to resolve ambiguity
+    , Output(*static_cast<Input*>(this))
+  {}
+};
+
+/// Combination of Input and StaticOutput
+struct StaticConvolver : Input, StaticOutput
+{
+  template<typename In>
+  StaticConvolver(const Layout& layout_, In first, In last)
+    : Input(layout_)
+    , StaticOutput(*static_cast<Input*>(this), first, last)
+  {}
+
+  explicit StaticConvolver(const Filter& filter)
+    : Input(filter.layout())
+    , StaticOutput(*static_cast<Input*>(this), filter)
+  {}
+};
+
+/// Apply conv::transform_nested() to each segment
+template<typename BinaryFunction>
+void transform_nested(const Filter& in1, const Filter& in2, Filter& out
+    , BinaryFunction f)
+{
+  assert(in1.size() == out.size());
+  assert(in2.size() == out.size());
+
+  for (size_t i = 0; i < out.size(); ++i)
+  {
+    conv::transform_nested(in1[i], in2[i], out[i], f);
+  }
+}
+
+}  // namespace nonuniform
+
+}  // namespace conv
+
+}  // namespace apf
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -52,6 +52,7 @@
 #include <cerrno>
 #include <unistd.h>  // for usleep()
 #include <thread>  // for std::thread::hardware_concurrency()
+#include <atomic>  // for std::atomic
 
 #ifdef APF_PSEUDO_UNNAMED_SEMAPHORES
 #include <fcntl.h>  // for O_CREAT, O_EXCL
@@ -174,10 +175,8 @@ class posix_thread_policy::DetachedThread : public ThreadBase
 
     void _thread()
     {
-      for (;;)
-      {
-        _function();
-      }
+      // The function is called repeatedly until it returns false
+      while (_function()) {}
     }
 
     F _function;
@@ -208,22 +207,39 @@ class posix_thread_policy::Lock : NonCopyable
     pthread_mutex_t _lock;
 };
 
+/** Inner type Semaphore.
+ * If a spin count is given, wait() first polls for a limited time before the
+ * thread is put to sleep.
+ * As long as the semaphore is posted during that time, neither post() nor
+ * wait() make a system call, which makes the hand-over between threads much
+ * faster.
+ * The time between polls is doubled each time (up to a limit), in order to
+ * reduce the traffic on the shared cache line.
+ * Spinning is disabled on single-core systems, where it would only delay the
+ * posting thread.
+ **/
 class posix_thread_policy::Semaphore : NonCopyable
 {
   public:
     using value_type = unsigned int;
 
-    explicit Semaphore(value_type value = 0)
+    /// Constructor.
+    /// @param value initial value
+    /// @param spin_count maximum number of busy-wait cycles (CPU "pause"
+    ///   instructions) in wait() before blocking. 0 means block immediately.
+    explicit Semaphore(value_type value = 0, unsigned spin_count = 0)
+      : _count(static_cast<int>(value))
+      , _spin_count(std::thread::hardware_concurrency() > 1 ? spin_count : 0)
 #ifdef APF_PSEUDO_UNNAMED_SEMAPHORES
       // Create a unique dummy name from object pointer
-      : _name("/apf_" + apf::str::A2S(this))
-      , _sem_ptr(sem_open(_name.c_str(), O_CREAT | O_EXCL, 0600, value))
+      , _name("/apf_" + apf::str::A2S(this))
+      , _sem_ptr(sem_open(_name.c_str(), O_CREAT | O_EXCL, 0600, 0))
     {
       if (!_sem_ptr)
 #else
-      : _sem_ptr(&_semaphore)
+      , _sem_ptr(&_semaphore)
     {
-      if (sem_init(_sem_ptr, 0, value))
+      if (sem_init(_sem_ptr, 0, 0))
 #endif
       {
         throw std::runtime_error("Error initializing Semaphore! ("
@@ -231,7 +247,11 @@ class posix_thread_policy::Semaphore : NonCopyable
       }
     }
 
-    Semaphore(Semaphore&&) = default;
+    /// Move constructor, only allowed before the Semaphore is used
+    Semaphore(Semaphore&& other)
+      : Semaphore(static_cast<value_type>(other._count.load())
+          , other._spin_count)
+    {}
 
     ~Semaphore()
     {
@@ -242,10 +262,62 @@ class posix_thread_policy::Semaphore : NonCopyable
 #endif
     }
 
-    bool post() { return sem_post(_sem_ptr) == 0; }
-    bool wait() { return sem_wait(_sem_ptr) == 0; }
+    bool post()
+    {
+      // A negative count means that there are sleeping threads
+      if (_count.fetch_add(1, std::memory_order_release) < 0)
+      {
+        return sem_post(_sem_ptr) == 0;
+      }
+      return true;
+    }
+
+    bool wait()
+    {
+      unsigned pauses = 1;
+      for (unsigned spin = 0; spin < _spin_count; spin += pauses)
+      {
+        if (_try_wait()) return true;
+        for (unsigned i = 0; i < pauses; ++i) _pause();
+        if (pauses < _max_pauses) pauses *= 2;
+      }
+
+      if (_count.fetch_sub(1, std::memory_order_acquire) > 0) return true;
+
+      // The count was decremented, therefore we have to wait until post()
+      int result;
+      do
+      {
+        result = sem_wait(_sem_ptr);
+      }
+      while (result != 0 && errno == EINTR);
+      return result == 0;
+    }
 
   private:
+    static const unsigned _max_pauses = 64;
+
+    bool _try_wait()
+    {
+      int count = _count.load(std::memory_order_relaxed);
+      return count > 0 && _count.compare_exchange_weak(count, count - 1
+          , std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    static void _pause()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+      __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+      __asm__ __volatile__("yield");
+#else
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+    std::atomic<int> _count;
+    const unsigned _spin_count;
+
 #ifdef APF_PSEUDO_UNNAMED_SEMAPHORES
     const std::string _name;
 #else
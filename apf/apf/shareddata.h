@@ -53,9 +53,16 @@ class SharedData
 
     operator const X&() const { return this->get(); }
 
+    /// Set contained data directly, without a command.
+    /// @attention This must only be called from the realtime thread (e.g. from
+    ///   a command which changes several objects at once) or while the
+    ///   CommandQueue is inactive.
+    void assign_in_realtime_thread(const X& rhs) { _data = rhs; }
+
     void operator=(const X& rhs)
     {
-      _fifo.push(new SetCommand(&_data, rhs));
+      // SetCommand is small enough for the CommandQueue's pool
+      _fifo.emplace<SetCommand>(&_data, rhs);
     }
 
   private:
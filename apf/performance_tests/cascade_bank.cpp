@@ -0,0 +1,142 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the Audio Processing Framework (APF).                 *
+ *                                                                            *
+ * The APF is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The APF is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ *                                 http://AudioProcessingFramework.github.com *
+ ******************************************************************************/
+
+
+// Performance tests for CascadeBank (as used in the NFC-HOA renderer):
+// several Cascade%s with a common input, computed one after another or all at
+// once in one CascadeBank.
+
+#include <vector>
+#include <array>
+#include <iostream>
+#include <algorithm>  // for std::max()
+#include <cmath>  // for std::abs(), std::cos()
+#include <cstdlib>  // for random()
+
+#include "apf/biquad.h"
+#include "apf/stopwatch.h"
+
+const int block_size = 1024;
+const int number_of_blocks = 2000;
+const int number_of_sections = 8;  // this corresponds to mode number 16
+const size_t lanes = 4;
+
+using coeffs_t = apf::SosCoefficients<double>;
+using cascade_t = apf::Cascade<apf::BiQuad<double>>;
+using bank_t = apf::CascadeBank<double, lanes>;
+
+using output_t = std::array<std::vector<float>, lanes>;
+
+coeffs_t resonator(double radius, double angle)
+{
+  return coeffs_t(1.0, 0.0, 0.0, -2.0 * radius * std::cos(angle)
+      , radius * radius);
+}
+
+std::vector<coeffs_t> coefficients(size_t lane)
+{
+  auto coeffs = std::vector<coeffs_t>(number_of_sections);
+  for (int i = 0; i < number_of_sections; ++i)
+  {
+    coeffs[size_t(i)] = resonator(0.9 + 0.02 * double(lane), 0.1 * (i + 1));
+  }
+  return coeffs;
+}
+
+void process_cascades(const std::vector<float>& input, output_t& output)
+{
+  auto cascades = std::vector<cascade_t>(lanes, cascade_t(number_of_sections));
+  for (size_t lane = 0; lane < lanes; ++lane)
+  {
+    auto coeffs = coefficients(lane);
+    cascades[lane].set(coeffs.begin(), coeffs.end());
+  }
+
+  apf::StopWatch watch("separate Cascades");
+
+  for (int n = 0; n < number_of_blocks; ++n)
+  {
+    auto in = input.begin() + n * block_size;
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+      cascades[lane].execute(in, in + block_size
+          , output[lane].begin() + n * block_size);
+    }
+  }
+}
+
+void process_bank(const std::vector<float>& input, output_t& output)
+{
+  bank_t bank(number_of_sections);
+  for (size_t lane = 0; lane < lanes; ++lane)
+  {
+    auto coeffs = coefficients(lane);
+    bank.set(lane, coeffs.begin(), coeffs.end());
+  }
+
+  apf::StopWatch watch("CascadeBank");
+
+  for (int n = 0; n < number_of_blocks; ++n)
+  {
+    auto in = input.begin() + n * block_size;
+    auto results = std::array<std::vector<float>::iterator, lanes>();
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+      results[lane] = output[lane].begin() + n * block_size;
+    }
+    bank.execute(in, in + block_size, results);
+  }
+}
+
+int main()
+{
+  auto input = std::vector<float>(block_size * number_of_blocks);
+  for (auto& sample: input)
+  {
+    sample = float(random()) / float(RAND_MAX) - 0.5f;
+  }
+
+  output_t reference, output;
+  for (size_t lane = 0; lane < lanes; ++lane)
+  {
+    reference[lane].resize(input.size());
+    output[lane].resize(input.size());
+  }
+
+  process_cascades(input, reference);
+  process_bank(input, output);
+
+  float max_error = 0;
+  for (size_t lane = 0; lane < lanes; ++lane)
+  {
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+      max_error = std::max(max_error
+          , std::abs(output[lane][i] - reference[lane][i]));
+    }
+  }
+  std::cout << "maximum deviation: " << max_error << std::endl;
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
@@ -0,0 +1,136 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the Audio Processing Framework (APF).                 *
+ *                                                                            *
+ * The APF is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The APF is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ *                                 http://AudioProcessingFramework.github.com *
+ ******************************************************************************/
+
+
+// Performance tests for time-variant Cascade%s (as used in the NFC-HOA
+// renderer): coefficients are interpolated within each block and updated
+// after a given number of samples.
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>  // for std::min(), std::max()
+#include <cmath>  // for std::abs(), std::cos()
+#include <cstdlib>  // for random()
+
+#include "apf/biquad.h"
+#include "apf/iterator.h"  // for apf::dual_iterator, ...
+#include "apf/stopwatch.h"
+
+const int block_size = 1024;
+const int number_of_blocks = 2000;
+const int number_of_sections = 8;  // this corresponds to mode number 16
+
+using coeffs_t = apf::SosCoefficients<double>;
+using cascade_t = apf::Cascade<apf::BiQuad<double>>;
+
+// Both coefficient sets are stable, so is each linear combination
+coeffs_t resonator(double radius, double angle)
+{
+  return coeffs_t(1.0, 0.0, 0.0, -2.0 * radius * std::cos(angle)
+      , radius * radius);
+}
+
+void process(int interval, const std::vector<float>& input
+    , std::vector<float>& output)
+{
+  auto old_coeffs = std::vector<coeffs_t>(number_of_sections);
+  auto new_coeffs = std::vector<coeffs_t>(number_of_sections);
+  for (int i = 0; i < number_of_sections; ++i)
+  {
+    old_coeffs[i] = resonator(0.9, 0.1 * (i + 1));
+    new_coeffs[i] = resonator(0.99, 0.1 * (i + 1));
+  }
+
+  cascade_t cascade(number_of_sections);
+  cascade.set(old_coeffs.begin(), old_coeffs.end());
+
+  auto in = input.begin();
+  auto out = output.begin();
+
+  {
+    apf::StopWatch watch("interval " + std::to_string(interval));
+
+    for (int n = 0; n < number_of_blocks; ++n)
+    {
+      // back and forth between the two sets of coefficients
+      auto first_section = apf::make_dual_iterator(old_coeffs.begin()
+          , new_coeffs.begin());
+      auto last_section = apf::make_dual_iterator(old_coeffs.end()
+          , new_coeffs.end());
+
+      for (int first = 0; first < block_size; first += interval)
+      {
+        int last = std::min(first + interval, block_size);
+
+        cascade.execute(in + first, in + last, out + first);
+
+        double index = last;
+
+        auto interp_coeffs = [index] (
+            const std::pair<coeffs_t, coeffs_t>& coeffs)
+        {
+          return coeffs.first
+            + index * (coeffs.second - coeffs.first) / block_size;
+        };
+
+        cascade.set(apf::make_transform_iterator(first_section, interp_coeffs)
+                  , apf::make_transform_iterator(last_section, interp_coeffs));
+      }
+      in += block_size;
+      out += block_size;
+      std::swap(old_coeffs, new_coeffs);
+    }
+  }
+}
+
+int main()
+{
+  auto input = std::vector<float>(block_size * number_of_blocks);
+  for (auto& sample: input)
+  {
+    sample = float(random()) / float(RAND_MAX) - 0.5f;
+  }
+
+  // The reference: coefficients are updated after each sample
+  auto reference = std::vector<float>(input.size());
+  process(1, input, reference);
+
+  for (int interval: {2, 4, 8, 16, 32, 64, block_size})
+  {
+    auto output = std::vector<float>(input.size());
+    process(interval, input, output);
+
+    float max_error = 0, max_value = 0;
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+      max_error = std::max(max_error, std::abs(output[i] - reference[i]));
+      max_value = std::max(max_value, std::abs(reference[i]));
+    }
+    std::cout << "  maximum deviation: " << max_error / max_value
+      << " (relative to maximum output)" << std::endl;
+  }
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
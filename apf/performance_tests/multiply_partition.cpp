@@ -0,0 +1,95 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the Audio Processing Framework (APF).                 *
+ *                                                                            *
+ * The APF is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The APF is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ *                                 http://AudioProcessingFramework.github.com *
+ ******************************************************************************/
+
+// Performance tests for the spectral multiply-accumulate kernels of the
+// convolution engine.
+
+#include <cstdlib>  // for random()
+#include <iostream>
+#include <string>
+
+#include "apf/convolver.h"
+#include "apf/container.h"  // for apf::fixed_vector
+#include "apf/stopwatch.h"
+
+namespace c = apf::conv;
+
+// Total number of multiplied values is the same for all block sizes
+const size_t total_size = size_t(1) << 30;
+
+// Filter length in samples (e.g. a typical BRIR)
+const size_t filter_size = 16384;
+
+void run(const std::string& name, c::multiply_partition_t kernel
+    , size_t block_size)
+{
+  size_t size = 2 * block_size;
+  size_t partitions = c::min_partitions(block_size, filter_size);
+  size_t repetitions = total_size / (size * partitions);
+
+  using buffer_t = apf::fixed_vector<float, apf::fftw_allocator<float>>;
+  auto signal = buffer_t(size * partitions);
+  auto filter = buffer_t(size * partitions);
+  auto result = buffer_t(size);
+
+  // WARNING: this is not really a meaningful spectrum:
+  for (auto& x: signal) x = float(random()) / float(RAND_MAX) - 0.5f;
+  for (auto& x: filter) x = float(random()) / float(RAND_MAX) - 0.5f;
+
+  apf::StopWatch watch(name + " (block size " + std::to_string(block_size)
+      + ")");
+  for (size_t i = 0; i < repetitions; ++i)
+  {
+    std::fill(result.begin(), result.end(), 0.0f);
+    for (size_t p = 0; p < partitions; ++p)
+    {
+      kernel(signal.data() + p * size, filter.data() + p * size
+          , result.data(), size);
+    }
+  }
+}
+
+int main()
+{
+  for (size_t block_size = 32; block_size <= 4096; block_size *= 2)
+  {
+    run("C++    ", c::multiply_partition_cpp, block_size);
+#ifdef __SSE__
+    run("SSE    ", c::multiply_partition_sse, block_size);
+#endif
+#ifdef APF_CONV_RUNTIME_DISPATCH
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+      run("AVX2   ", c::multiply_partition_avx2, block_size);
+    }
+    if (__builtin_cpu_supports("avx512f"))
+    {
+      run("AVX-512", c::multiply_partition_avx512, block_size);
+    }
+#endif
+    std::cout << std::endl;
+  }
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
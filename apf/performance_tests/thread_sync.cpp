@@ -0,0 +1,133 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the Audio Processing Framework (APF).                 *
+ *                                                                            *
+ * The APF is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The APF is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ *                                 http://AudioProcessingFramework.github.com *
+ ******************************************************************************/
+
+// Performance tests for the synchronization of MimoProcessor threads.
+// Each list is processed with (almost) empty items, therefore the measured
+// time is mainly the overhead of waking up the worker threads and waiting for
+// them.
+
+#include <iostream>
+#include <list>
+#include <thread>  // for std::thread::hardware_concurrency()
+#include <chrono>  // std::clock() (used by StopWatch) doesn't count sleeping
+
+#include "apf/pointer_policy.h"
+#include "apf/posix_thread_policy.h"
+#include "apf/mimoprocessor.h"
+
+class MyProcessor : public apf::MimoProcessor<MyProcessor
+                    , apf::pointer_policy<float*>
+                    , apf::posix_thread_policy>
+{
+  public:
+    class Item : public ProcessItem<Item>
+    {
+      public:
+        Item() : _counter(0) {}
+
+        APF_PROCESS(Item, ProcessItem<Item>)
+        {
+          ++_counter;
+        }
+
+      private:
+        volatile int _counter;
+    };
+
+    MyProcessor(const apf::parameter_map& p)
+      : MimoProcessorBase(p)
+    {
+      for (size_t n = 0; n < p.get<size_t>("lists"); ++n)
+      {
+        _lists.emplace_back(_fifo);
+        auto& list = _lists.back();
+        for (int i = 0; i < p.get<int>("items"); ++i)
+        {
+          list.add(new Item());
+        }
+      }
+    }
+
+    APF_PROCESS(MyProcessor, MimoProcessorBase)
+    {
+      for (auto& list: _lists)
+      {
+        this->_process_list(list);
+      }
+    }
+
+  private:
+    std::list<rtlist_t> _lists;  // RtList is not movable
+};
+
+void run(int threads, unsigned spin_count)
+{
+  size_t lists = 4;  // e.g. NfcHoaRenderer
+  int blocks = 20000;
+
+  apf::parameter_map p;
+  p.set("block_size", 64);
+  p.set("sample_rate", 44100);  // Not really relevant in this case
+  p.set("threads", threads);
+  p.set("spin_count", spin_count);
+  p.set("lists", lists);
+  p.set("items", 2 * threads);
+
+  MyProcessor processor(p);
+
+  processor.activate();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < blocks; ++i)
+  {
+    processor.audio_callback(64, nullptr, nullptr);
+  }
+  auto time = std::chrono::duration<double, std::micro>(
+      std::chrono::steady_clock::now() - start).count();
+
+  processor.deactivate();
+
+  std::cout << threads << " threads, spin count " << spin_count << ": "
+    << time / double(blocks) / double(lists) << " us per list"
+    << std::endl;
+}
+
+int main()
+{
+  if (std::thread::hardware_concurrency() < 2)
+  {
+    std::cout << "Single CPU core, spinning is disabled!" << std::endl;
+  }
+
+  for (int threads: {2, 4})
+  {
+    for (unsigned spin_count: {0u, 2000u, 20000u})
+    {
+      run(threads, spin_count);
+    }
+  }
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -25,6 +25,9 @@
 
 // see also ../performance_tests/biquad_*.cpp
 
+#include <vector>
+#include <cmath>  // for std::abs()
+
 #include "apf/biquad.h"
 
 #include "catch/catch.hpp"
@@ -49,6 +52,97 @@ SECTION("basic", "only instantiations and very basic stuff")
   auto e = apf::Cascade<apf::BiQuad<float>>(25);
 }
 
+// stable sections (poles at radius 0.9 and 0.5)
+const apf::SosCoefficients<double> coeffs[] = {
+  { 0.5, 0.2, 0.1, -1.2, 0.81 },
+  { 1.0, -0.3, 0.0, 0.4, 0.25 },
+  { 0.8, 0.0, -0.8, -0.9, 0.81 },
+};
+
+// impulse and a few more samples (longer than internal chunk size)
+std::vector<double> input(100);
+input[0] = 1.0;
+input[3] = -0.5;
+input[70] = 0.25;
+
+SECTION("Cascade::execute", "block processing == sample-wise processing")
+{
+  auto a = apf::Cascade<apf::BiQuad<double>>(3);
+  auto b = apf::Cascade<apf::BiQuad<double>>(3);
+  a.set(coeffs, coeffs + 3);
+  b.set(coeffs, coeffs + 3);
+
+  std::vector<float> result(input.size());
+  a.execute(input.begin(), input.end(), result.begin());
+
+  for (size_t i = 0; i < input.size(); ++i)
+  {
+    CHECK(result[i] == static_cast<float>(b(input[i])));
+  }
+}
+
+SECTION("CascadeBank", "each lane == Cascade")
+{
+  auto bank = apf::CascadeBank<double, 3>(3);
+  bank.set(0, coeffs, coeffs + 3);
+  bank.set(1, coeffs + 1, coeffs + 3);
+  // lane 2 stays empty (pass-through)
+
+  auto a = apf::Cascade<apf::BiQuad<double>>(3);
+  auto b = apf::Cascade<apf::BiQuad<double>>(2);
+  a.set(coeffs, coeffs + 3);
+  b.set(coeffs + 1, coeffs + 3);
+
+  std::vector<double> out0(input.size()), out1(input.size())
+    , out2(input.size());
+  // process in two parts to check if states are kept
+  bank.execute(input.begin(), input.begin() + 10
+      , std::array<double*, 3>{{&out0[0], &out1[0], &out2[0]}});
+  bank.execute(input.begin() + 10, input.end()
+      , std::array<double*, 3>{{&out0[10], &out1[10], &out2[10]}});
+
+  for (size_t i = 0; i < input.size(); ++i)
+  {
+    CHECK(out0[i] == Approx(a(input[i])));
+    CHECK(out1[i] == Approx(b(input[i])));
+    CHECK(out2[i] == Approx(input[i]));
+  }
+}
+
+SECTION("LatticeBank", "each lane == Cascade")
+{
+  auto bank = apf::LatticeBank<double, 2>(3);
+  bank.set(0, coeffs, coeffs + 3);
+  // lane 1 stays empty (pass-through)
+
+  auto a = apf::Cascade<apf::BiQuad<double>>(3);
+  a.set(coeffs, coeffs + 3);
+
+  std::vector<double> out0(input.size()), out1(input.size());
+  bank.execute(input.begin(), input.end()
+      , std::array<double*, 2>{{&out0[0], &out1[0]}});
+
+  for (size_t i = 0; i < input.size(); ++i)
+  {
+    CHECK(out0[i] == Approx(a(input[i])));
+    CHECK(out1[i] == Approx(input[i]));
+  }
+}
+
+SECTION("LatticeBank stability", "reflection coefficients are limited")
+{
+  auto bank = apf::LatticeBank<float, 1>(1);
+  // unstable: poles outside of the unit circle
+  auto c = apf::SosCoefficients<double>(1.0, 0.0, 0.0, 0.0, 1.5);
+  bank.set(0, &c, &c + 1);
+
+  std::vector<float> out(input.size());
+  bank.execute(input.begin(), input.end(), std::array<float*, 1>{{&out[0]}});
+
+  // with poles on the unit circle, the output doesn't grow
+  CHECK(std::abs(out.back()) < 2.0f);
+}
+
 } // TEST_CASE
 
 // Settings for Vim (http://www.vim.org/), please do not remove:
@@ -24,6 +24,7 @@
 // Tests for delay line.
 
 #include "apf/blockdelayline.h"
+#include "apf/fractional_delay.h"
 
 #include "catch/catch.hpp"
 
@@ -110,6 +111,54 @@ SECTION("non-causal delay line", "")
   CHECK_RANGE(target, src, 3);
 }
 
+SECTION("fractional delay", "")
+{
+  // Lagrange interpolation of order >= 1 is exact for a linear ramp
+  apf::DelayInterpolator<float> linear(apf::DelayInterpolator<float>::lagrange
+      , 1), cubic(apf::DelayInterpolator<float>::lagrange, 3);
+  apf::BlockDelayLine<float> d(4, 12);
+
+  float ramp[4];
+  for (int block = 0; block < 5; ++block)
+  {
+    for (int i = 0; i < 4; ++i) ramp[i] = float(4 * block + i);
+    d.write_block(ramp);
+  }
+  // the first sample of the current block has the value 16
+
+  float result[4];
+  float expected[4] = { 13.5f, 14.5f, 15.5f, 16.5f };
+
+  CHECK(d.read_block(result, 2.5, 2.5, 1.0f, 1.0f, linear));
+  CHECK_RANGE(result, expected, 4);
+
+  CHECK(d.read_block(result, 2.5, 2.5, 1.0f, 1.0f, cubic));
+  CHECK_RANGE(result, expected, 4);
+
+  // delay ramp from 2 to 3 and weight ramp from 1 to 2
+  CHECK(d.read_block(result, 2.0, 3.0, 1.0f, 2.0f, cubic));
+  float expected2[4] = { 14.0f, 14.75f * 1.25f, 15.5f * 1.5f, 16.25f * 1.75f };
+  CHECK_RANGE(result, expected2, 4);
+
+  CHECK(d.delay_is_valid(0.0, linear));
+  CHECK_FALSE(d.delay_is_valid(0.5, cubic));  // would need a future sample
+  CHECK(d.delay_is_valid(1.0, cubic));
+  CHECK(d.delay_is_valid(11.5, linear));
+  CHECK_FALSE(d.delay_is_valid(12.5, linear));
+  CHECK_FALSE(d.read_block(result, 1.0, 0.5, 1.0f, 1.0f, cubic));
+
+  // windowed sinc has unity gain for constant signals
+  apf::DelayInterpolator<float> sinc(apf::DelayInterpolator<float>::sinc, 7);
+  apf::NonCausalBlockDelayLine<float> nc(4, 12, 4);
+  float ones[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+  for (int block = 0; block < 6; ++block) nc.write_block(ones);
+  CHECK(nc.read_block(result, -0.3, 5.7, 1.0f, 1.0f, sinc));
+  for (int i = 0; i < 4; ++i) CHECK(result[i] == Approx(1.0f));
+
+  CHECK_THROWS_AS(apf::DelayInterpolator<float>(
+        apf::DelayInterpolator<float>::lagrange, 2), std::logic_error);
+}
+
 } // TEST_CASE
 
 // Settings for Vim (http://www.vim.org/), please do not remove:
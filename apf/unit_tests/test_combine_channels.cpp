@@ -28,6 +28,8 @@
 #include "catch/catch.hpp"
 
 #include <vector>
+#include <algorithm>  // for std::transform(), std::fill()
+#include <functional>  // for std::plus
 
 using Item = std::vector<int>;
 
@@ -43,6 +45,52 @@ struct SelectChange
   void update() { /* ... */ }
 };
 
+// Trivial "frequency domain": the identity transform
+class Accumulator
+{
+  public:
+    explicit Accumulator(size_t block_size) : _data(block_size), _empty(true) {}
+
+    void clear() { _empty = true; }
+    bool empty() const { return _empty; }
+
+    void add(const Item& item)
+    {
+      if (_empty) std::fill(_data.begin(), _data.end(), 0);
+      std::transform(item.begin(), item.end(), _data.begin(), _data.begin()
+          , std::plus<int>());
+      _empty = false;
+    }
+
+    int* ifft()
+    {
+      _empty = true;
+      return _data.data();
+    }
+
+  private:
+    Item _data;
+    bool _empty;
+};
+
+struct SelectChangeAccumulate
+{
+  apf::CombineChannelsResult::type select(const Item& item)
+  {
+    _item = &item;
+    return apf::CombineChannelsResult::change;
+  }
+
+  void accumulate(Accumulator& target) { target.add(*_item); }
+
+  void accumulate(Accumulator& target, apf::fade_out_tag)
+  {
+    target.add(*_item);
+  }
+
+  const Item* _item;
+};
+
 class Crossfade
 {
   public:
@@ -115,6 +163,18 @@ SECTION("CombineChannelsCrossfadeCopy", "")
   // TODO: more checks?
 }
 
+SECTION("CombineChannelsCrossfadeAccumulate", "")
+{
+  apf::CombineChannelsCrossfadeAccumulate<L, Item, Crossfade, Accumulator>
+    c(source, target, crossfade);
+
+  c.process(SelectChangeAccumulate());
+
+  CHECK(target[0] == 25);
+  CHECK(target[1] == 35);
+  CHECK(target[2] == 45);
+}
+
 SECTION("CombineChannelsCrossfade", "")
 {
   apf::CombineChannelsCrossfade<L, Item, Crossfade >
@@ -0,0 +1,135 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the Audio Processing Framework (APF).                 *
+ *                                                                            *
+ * The APF is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The APF is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ *                                 http://AudioProcessingFramework.github.com *
+ ******************************************************************************/
+
+// Tests for CommandQueue and SharedData.
+
+#include "apf/commandqueue.h"
+#include "apf/shareddata.h"
+
+#include <atomic>
+#include <cstdlib>  // for std::malloc(), std::free()
+#include "catch/catch.hpp"
+
+namespace
+{
+// number of calls to the global operator new
+// NOTE: atomic because other unit tests allocate from several threads
+std::atomic<size_t> allocations{0};
+}
+
+// NOTE: This is used for all unit tests, but only the counter is added
+void* operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+struct LargeCommand : apf::CommandQueue::Command
+{
+  LargeCommand(int& target) : _target(target) {}
+
+  virtual void execute() { _target = 42; }
+  virtual void cleanup() {}
+
+  int& _target;
+  char _payload[2 * apf::CommandQueue::slot_size];
+};
+
+TEST_CASE("CommandQueue", "Test CommandQueue")
+{
+
+SECTION("pool", "SetCommands don't allocate memory")
+{
+  apf::CommandQueue fifo(16);
+  apf::SharedData<float> data(fifo, 0.0f);
+
+  size_t before = allocations;
+  for (int i = 1; i <= 1000; ++i)
+  {
+    data = float(i);
+    data = float(i) + 0.5f;
+    fifo.process_commands();
+  }
+  fifo.cleanup_commands();
+  size_t after = allocations;
+
+  CHECK(after == before);
+  CHECK(data.get() == 1000.5f);
+}
+
+SECTION("inactive", "commands are executed immediately")
+{
+  apf::CommandQueue fifo(16);
+  CHECK(fifo.deactivate());
+  apf::SharedData<int> data(fifo, 0);
+
+  size_t before = allocations;
+  data = 23;
+  size_t after = allocations;
+
+  CHECK(after == before);
+  CHECK(data.get() == 23);
+}
+
+SECTION("fallback", "large commands and exhausted pool use operator new")
+{
+  apf::CommandQueue fifo(16, 4);
+  apf::SharedData<int> data(fifo, 0);
+
+  size_t before = allocations;
+  for (int i = 1; i <= 10; ++i)
+  {
+    data = i;
+  }
+  size_t after = allocations;
+  CHECK(after == before + 6);
+
+  int target = 0;
+  before = allocations;
+  fifo.emplace<LargeCommand>(target);
+  after = allocations;
+  CHECK(after == before + 1);
+
+  fifo.process_commands();
+  fifo.cleanup_commands();
+  CHECK(data.get() == 10);
+  CHECK(target == 42);
+
+  // the slots are available again
+  before = allocations;
+  for (int i = 1; i <= 4; ++i)
+  {
+    data = i;
+  }
+  after = allocations;
+  CHECK(after == before);
+  fifo.process_commands();
+}
+
+} // TEST_CASE CommandQueue
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
@@ -24,6 +24,7 @@
 // Tests for the Convolver.
 
 #include "apf/convolver.h"
+#include "apf/nonuniform_convolver.h"
 
 #include "catch/catch.hpp"
 
@@ -33,6 +34,7 @@
     CHECK((left)[i] == Approx((right)[i])); }
 
 namespace c = apf::conv;
+namespace nu = apf::conv::nonuniform;
 
 TEST_CASE("Convolver", "Test Convolver")
 {
@@ -241,5 +243,367 @@ SECTION("combinations", "")
 
 } // TEST_CASE
 
+TEST_CASE("multiply_partition", "Compare SIMD kernels with C++ version")
+{
+
+// 24: partition size of block size 12, not a multiple of 16
+for (size_t size: {64u, 24u})
+{
+INFO("size = " << size);
+
+alignas(64) float signal[64], filter[64], expected[64];
+
+for (size_t i = 0; i < size; ++i)
+{
+  signal[i] = static_cast<float>((i * 7) % 13) - 6.0f;
+  filter[i] = 0.25f * static_cast<float>((i * 5) % 11) - 1.0f;
+  expected[i] = static_cast<float>(i % 3);
+}
+
+auto check_kernel = [&] (c::multiply_partition_t kernel)
+{
+  alignas(64) float result[64];
+  for (size_t i = 0; i < 64; ++i)
+  {
+    result[i] = static_cast<float>(i % 3);
+  }
+  kernel(signal, filter, result, size);
+  CHECK_RANGE(result, expected, int(size));
+  // values behind the partition must not be touched
+  for (size_t i = size; i < 64; ++i)
+  {
+    CHECK(result[i] == static_cast<float>(i % 3));
+  }
+};
+
+c::multiply_partition_cpp(signal, filter, expected, size);
+
+SECTION("best " + std::to_string(size), "")
+{
+  check_kernel(c::best_multiply_partition(size));
+}
+
+#ifdef __SSE__
+SECTION("sse " + std::to_string(size), "")
+{
+  check_kernel(c::multiply_partition_sse);
+}
+#endif
+
+#ifdef APF_CONV_RUNTIME_DISPATCH
+SECTION("avx2 " + std::to_string(size), "")
+{
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+  {
+    check_kernel(c::multiply_partition_avx2);
+  }
+}
+
+SECTION("avx512 " + std::to_string(size), "")
+{
+  if (__builtin_cpu_supports("avx512f") && size % 16 == 0)
+  {
+    check_kernel(c::multiply_partition_avx512);
+  }
+}
+#endif
+}
+
+} // TEST_CASE
+
+TEST_CASE("Accumulator", "Compare with time-domain accumulation")
+{
+
+float signal[48], filter1[20], filter2[20];
+
+for (int i = 0; i < 48; ++i) signal[i] = static_cast<float>((i * 7) % 13) - 6.0f;
+for (int i = 0; i < 20; ++i)
+{
+  filter1[i] = static_cast<float>((i * 5) % 11) - 5.0f;
+  filter2[i] = static_cast<float>(i % 4) - 1.5f;
+}
+
+auto partitions = c::min_partitions(8, 20);
+auto input = c::Input(8, partitions);
+auto output1 = c::StaticOutput(input, filter1, filter1 + 20);
+auto output2 = c::StaticOutput(input, filter2, filter2 + 20);
+auto accumulator = c::Accumulator(8);
+
+CHECK(accumulator.empty());
+
+for (int block = 0; block < 6; ++block)
+{
+  input.add_block(signal + 8 * block);
+
+  float expected[8];
+  auto result = output1.convolve(0.5f);
+  std::copy(result, result + 8, expected);
+  result = output2.convolve(2.0f);
+  for (int i = 0; i < 8; ++i) expected[i] += result[i];
+
+  output1.accumulate(accumulator, 0.5f);
+  output2.accumulate(accumulator, 2.0f);
+  CHECK_FALSE(accumulator.empty());
+
+  result = accumulator.ifft();
+  CHECK(accumulator.empty());
+  CHECK_RANGE(result, expected, 8);
+}
+
+float zeros[8] = { 0.0f };
+auto result = accumulator.ifft();
+CHECK_RANGE(result, zeros, 8);
+
+} // TEST_CASE
+
+TEST_CASE("nonuniform::Layout", "Test Layout")
+{
+
+SECTION("uniform", "")
+{
+  auto layout = nu::Layout(64, 4096);
+  CHECK(layout.size() == 1);
+  CHECK(layout[0].block_size == 64);
+  CHECK(layout[0].offset == 0);
+  CHECK(layout[0].partitions == 64);
+  CHECK(layout.filter_size() == 4096);
+}
+
+SECTION("short filter", "")
+{
+  auto layout = nu::Layout(64, 100, 4);
+  CHECK(layout.size() == 1);
+  CHECK(layout[0].partitions == 2);
+
+  CHECK(nu::Layout(64, 0, 4)[0].partitions == 1);
+}
+
+SECTION("doubling", "")
+{
+  auto layout = nu::Layout(64, 4096, 4);
+  REQUIRE(layout.size() == 4);
+  CHECK(layout[0].block_size == 64);
+  CHECK(layout[0].partitions == 4);
+  CHECK(layout[1].block_size == 128);
+  CHECK(layout[1].offset == 256);
+  CHECK(layout[1].partitions == 4);
+  CHECK(layout[1].delay() == 0);
+  CHECK(layout[2].block_size == 256);
+  CHECK(layout[2].offset == 768);
+  CHECK(layout[2].partitions == 5);
+  CHECK(layout[2].delay() == 1);
+  CHECK(layout[3].block_size == 512);
+  CHECK(layout[3].offset == 2048);
+  CHECK(layout[3].partitions == 4);
+  CHECK(layout.filter_size() == 4096);
+
+  for (const auto& segment: layout)
+  {
+    CHECK((segment.offset % segment.block_size) == 0);
+  }
+}
+
+SECTION("one head partition", "")
+{
+  auto layout = nu::Layout(64, 4096, 1);
+  REQUIRE(layout.size() > 2);
+  CHECK(layout[0].partitions == 4);
+
+  for (size_t i = 1; i < layout.size(); ++i)
+  {
+    // Tail segments need one of their own blocks to be computed
+    CHECK(layout[i].offset >= 2 * layout[i].block_size);
+    CHECK((layout[i].offset % layout[i].block_size) == 0);
+  }
+}
+
+SECTION("maximum block size", "")
+{
+  auto layout = nu::Layout(64, 4096, 4, 128);
+  REQUIRE(layout.size() == 2);
+  CHECK(layout[1].block_size == 128);
+  CHECK(layout[1].offset == 256);
+  CHECK(layout[1].partitions == 30);
+}
+
+} // TEST_CASE
+
+TEST_CASE("nonuniform::Convolver", "Compare with uniform Convolver")
+{
+
+const size_t block_size = 8;
+const size_t filter_size = 200;
+const size_t blocks = 60;
+
+auto filter_data = std::vector<float>(filter_size);
+for (size_t i = 0; i < filter_size; ++i)
+{
+  filter_data[i] = float((i * 7) % 13) - 6.0f;
+}
+filter_data[199] = 0.5f;
+
+auto input = std::vector<float>(blocks * block_size);
+for (size_t i = 0; i < input.size(); ++i)
+{
+  input[i] = float((i * 5) % 11) / 10.0f - 0.5f;
+}
+// some silence in between
+std::fill(input.begin() + 100, input.begin() + 180, 0.0f);
+
+auto uniform = c::StaticConvolver(block_size
+    , filter_data.begin(), filter_data.end());
+
+SECTION("StaticConvolver", "")
+{
+  auto layout = nu::Layout(block_size, filter_size, 2);
+  REQUIRE(layout.size() > 2);
+
+  auto conv = nu::StaticConvolver(layout
+      , filter_data.begin(), filter_data.end());
+
+  for (size_t n = 0; n < blocks; ++n)
+  {
+    INFO("block " << n);
+    uniform.add_block(input.begin() + n * block_size);
+    conv.add_block(input.begin() + n * block_size);
+
+    auto expected = uniform.convolve(0.5f);
+    auto result = conv.convolve(0.5f);
+    CHECK_RANGE(result, expected, 8);
+  }
+}
+
+SECTION("StaticConvolver with one head partition", "")
+{
+  auto layout = nu::Layout(block_size, filter_size, 1);
+  REQUIRE(layout.size() > 3);
+
+  auto conv = nu::StaticConvolver(layout
+      , filter_data.begin(), filter_data.end());
+
+  for (size_t n = 0; n < blocks; ++n)
+  {
+    INFO("block " << n);
+    uniform.add_block(input.begin() + n * block_size);
+    conv.add_block(input.begin() + n * block_size);
+
+    auto expected = uniform.convolve();
+    auto result = conv.convolve();
+    CHECK_RANGE(result, expected, 8);
+  }
+}
+
+SECTION("Convolver", "")
+{
+  auto layout = nu::Layout(block_size, filter_size, 3);
+  auto filter = nu::Filter(layout, filter_data.begin(), filter_data.end());
+  auto conv = nu::Convolver(layout);
+  conv.set_filter(filter);
+
+  for (size_t n = 0; n < blocks; ++n)
+  {
+    INFO("block " << n);
+    uniform.add_block(input.begin() + n * block_size);
+    conv.add_block(input.begin() + n * block_size);
+
+    auto expected = uniform.convolve();
+    if (!conv.queues_empty()) conv.rotate_queues();
+    // Calling convolve() twice in one block must not change anything
+    conv.convolve(2.0f);
+    auto result = conv.convolve();
+    CHECK_RANGE(result, expected, 8);
+  }
+  CHECK(conv.queues_empty());
+}
+
+SECTION("Accumulator", "")
+{
+  auto layout = nu::Layout(block_size, filter_size, 2);
+  auto conv = nu::StaticConvolver(layout
+      , filter_data.begin(), filter_data.end());
+  auto accumulator = nu::Accumulator(block_size);
+  auto old_result = nu::Accumulator(block_size);
+
+  for (size_t n = 0; n < blocks; ++n)
+  {
+    INFO("block " << n);
+    uniform.add_block(input.begin() + n * block_size);
+    conv.add_block(input.begin() + n * block_size);
+
+    auto expected = uniform.convolve(1.5f);
+    conv.accumulate(old_result, 0.5f);
+    conv.accumulate(accumulator);
+    accumulator.add(old_result);
+    old_result.clear();
+    auto result = accumulator.ifft();
+    CHECK_RANGE(result, expected, 8);
+  }
+}
+
+SECTION("Convolver with filter change", "")
+{
+  auto layout = nu::Layout(block_size, filter_size, 2);
+  auto zero = nu::Filter(layout);
+  auto filter = nu::Filter(layout, filter_data.begin(), filter_data.end());
+  auto conv = nu::Convolver(layout);
+  conv.set_filter(zero);
+
+  size_t n = 0;
+  for ( ; n < 5; ++n)
+  {
+    conv.add_block(input.begin() + n * block_size);
+    uniform.add_block(input.begin() + n * block_size);
+    uniform.convolve();
+    conv.convolve();
+  }
+
+  conv.set_filter(filter);
+  CHECK_FALSE(conv.queues_empty());
+
+  // After the filter length (and a few blocks more), the result must be the
+  // same as if the filter had been there all the time.
+  for ( ; n < blocks; ++n)
+  {
+    INFO("block " << n);
+    uniform.add_block(input.begin() + n * block_size);
+    conv.add_block(input.begin() + n * block_size);
+
+    if (!conv.queues_empty()) conv.rotate_queues();
+
+    auto expected = uniform.convolve();
+    auto result = conv.convolve();
+    if (n > 5 + filter_size / block_size + 2)
+    {
+      CHECK_RANGE(result, expected, 8);
+    }
+  }
+  CHECK(conv.queues_empty());
+}
+
+SECTION("transform_nested", "")
+{
+  auto layout = nu::Layout(block_size, filter_size, 2);
+  auto filter = nu::Filter(layout, filter_data.begin(), filter_data.end());
+  auto twice = nu::Filter(layout);
+  nu::transform_nested(filter, filter, twice
+      , [] (float a, float b) { return a + b; });
+
+  auto conv1 = nu::StaticConvolver(filter);
+  auto conv2 = nu::StaticConvolver(twice);
+
+  for (size_t n = 0; n < blocks; ++n)
+  {
+    INFO("block " << n);
+    conv1.add_block(input.begin() + n * block_size);
+    conv2.add_block(input.begin() + n * block_size);
+
+    auto expected = conv1.convolve(2.0f);
+    auto result = conv2.convolve();
+    CHECK_RANGE(result, expected, 8);
+  }
+}
+
+} // TEST_CASE
+
 // Settings for Vim (http://www.vim.org/), please do not remove:
 // vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
@@ -25,10 +25,15 @@
 
 #include "apf/mimoprocessor.h"
 
+#include <vector>
+#include <thread>  // for std::this_thread::sleep_for()
+#include <chrono>
+
 #include "catch/catch.hpp"
 
 #include "apf/pointer_policy.h"
 #include "apf/dummy_thread_policy.h"
+#include "apf/posix_thread_policy.h"
 
 struct DummyProcessor : public apf::MimoProcessor<DummyProcessor
                         , apf::pointer_policy<float*>
@@ -42,6 +47,99 @@ struct DummyProcessor : public apf::MimoProcessor<DummyProcessor
   void process() {}
 };
 
+struct CountingProcessor : public apf::MimoProcessor<CountingProcessor
+                           , apf::pointer_policy<float*>
+                           , apf::posix_thread_policy>
+{
+  using _base = apf::MimoProcessor<CountingProcessor
+    , apf::pointer_policy<float*>, apf::posix_thread_policy>;
+
+  struct Counter : ProcessItem<Counter>
+  {
+    Counter() : count(0) {}
+
+    APF_PROCESS(Counter, ProcessItem<Counter>)
+    {
+      ++this->count;
+    }
+
+    int count;
+  };
+
+  CountingProcessor(const apf::parameter_map& p)
+    : _base(p)
+    , items(_fifo)
+  {}
+
+  APF_PROCESS(CountingProcessor, _base)
+  {
+    this->_process_list(items);
+  }
+
+  rtlist_t items;
+};
+
+struct GraphProcessor : public apf::MimoProcessor<GraphProcessor
+                        , apf::pointer_policy<float*>
+                        , apf::posix_thread_policy>
+{
+  using _base = apf::MimoProcessor<GraphProcessor
+    , apf::pointer_policy<float*>, apf::posix_thread_policy>;
+
+  struct Producer : ProcessItem<Producer>
+  {
+    explicit Producer(bool slow_ = false) : count(0), slow(slow_) {}
+
+    APF_PROCESS(Producer, ProcessItem<Producer>)
+    {
+      // Consumers have to go to sleep while waiting
+      if (this->slow)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      ++this->count;
+    }
+
+    int count;
+    bool slow;
+  };
+
+  struct Consumer : ProcessItem<Consumer>
+  {
+    Consumer(const GraphProcessor& p, const Producer& prod)
+      : count(0)
+      , errors(0)
+      , _parent(p)
+      , _producer(prod)
+    {}
+
+    APF_PROCESS(Consumer, ProcessItem<Consumer>)
+    {
+      _parent.wait_for(_producer);
+      if (_producer.count != ++this->count) ++this->errors;
+    }
+
+    int count, errors;
+
+    private:
+      const GraphProcessor& _parent;
+      const Producer& _producer;
+  };
+
+  GraphProcessor(const apf::parameter_map& p)
+    : _base(p)
+    , producers(_fifo)
+    , consumers(_fifo)
+  {}
+
+  APF_PROCESS(GraphProcessor, _base)
+  {
+    this->_process_graph(producers, consumers);
+  }
+
+  rtlist_t producers, consumers;
+};
+
 TEST_CASE("MimoProcessor", "Test MimoProcessor")
 {
 
@@ -54,6 +152,103 @@ SECTION("compilation", "does it compile?")
   DummyProcessor dummy(p);
 }
 
+SECTION("scheduling", "each item is processed exactly once per block")
+{
+  for (bool dynamic: {false, true})
+  {
+    apf::parameter_map p;
+    p.set("sample_rate", 1000);
+    p.set("block_size", 33);
+    p.set("threads", 3);
+    p.set("dynamic_scheduling", dynamic);
+    CountingProcessor processor(p);
+
+    std::vector<CountingProcessor::Counter*> counters;
+    for (int i = 0; i < 20; ++i)
+    {
+      counters.push_back(processor.items.add(new CountingProcessor::Counter));
+    }
+
+    processor.activate();
+    for (int i = 0; i < 10; ++i)
+    {
+      processor.audio_callback(33, nullptr, nullptr);
+    }
+    processor.deactivate();
+
+    for (auto counter: counters)
+    {
+      CHECK(counter->count == 10);
+    }
+  }
+}
+
+SECTION("graph", "items wait for the items they depend on")
+{
+  apf::parameter_map p;
+  p.set("sample_rate", 1000);
+  p.set("block_size", 33);
+  p.set("threads", 3);
+  GraphProcessor processor(p);
+
+  std::vector<GraphProcessor::Consumer*> consumers;
+  for (int i = 0; i < 20; ++i)
+  {
+    auto producer = processor.producers.add(new GraphProcessor::Producer);
+    // consumers depend on producers in reverse order
+    consumers.insert(consumers.begin(), processor.consumers.add(
+          new GraphProcessor::Consumer(processor, *producer)));
+  }
+
+  processor.activate();
+  for (int i = 0; i < 10; ++i)
+  {
+    processor.audio_callback(33, nullptr, nullptr);
+  }
+  processor.deactivate();
+
+  for (auto consumer: consumers)
+  {
+    CHECK(consumer->count == 10);
+    CHECK(consumer->errors == 0);
+  }
+}
+
+SECTION("graph with slow items", "waiting threads go to sleep")
+{
+  for (unsigned spin_count: {0u, 100u})
+  {
+    apf::parameter_map p;
+    p.set("sample_rate", 1000);
+    p.set("block_size", 33);
+    p.set("threads", 4);
+    p.set("spin_count", spin_count);
+    GraphProcessor processor(p);
+
+    std::vector<GraphProcessor::Consumer*> consumers;
+    for (int i = 0; i < 8; ++i)
+    {
+      auto producer = processor.producers.add(
+          new GraphProcessor::Producer(i % 2 == 0));
+      consumers.push_back(processor.consumers.add(
+            new GraphProcessor::Consumer(processor, *producer)));
+    }
+
+    processor.activate();
+    for (int i = 0; i < 10; ++i)
+    {
+      processor.audio_callback(33, nullptr, nullptr);
+    }
+    processor.deactivate();
+
+    for (auto consumer: consumers)
+    {
+      CHECK(consumer->count == 10);
+      CHECK(consumer->errors == 0);
+    }
+  }
+}
+
 // TODO: more tests!
 
 } // TEST_CASE MimoProcessor
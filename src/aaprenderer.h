@@ -69,6 +69,17 @@ class AapRenderer : public SourceToOutput<AapRenderer, LoudspeakerRenderer>
   private:
     int _ambisonics_order;
     bool _in_phase_rendering;
+
+    /// Azimuth (in radians) of each Output, same order as the output list
+    std::vector<float> _loudspeaker_angles;
+    /// Indices of subwoofers in the output list
+    std::vector<size_t> _subwoofers;
+
+    /// Order weight times cos(m * alpha_0) for each order m (outer index)
+    /// and each Output (inner index).
+    std::vector<float> _cos_table;
+    /// Order weight times sin(m * alpha_0), same layout as #_cos_table
+    std::vector<float> _sin_table;
 };
 
 class AapRenderer::Source : public _base::Source
@@ -76,9 +87,27 @@ class AapRenderer::Source : public _base::Source
   public:
     Source(const Params& p)
       : _base::Source(p, p.parent->get_output_list().size(), this)
+      , _weights(p.parent->get_output_list().size())
+      , _cos(size_t(p.parent->_ambisonics_order + 1))
+      , _sin(size_t(p.parent->_ambisonics_order + 1))
     {}
 
+    APF_PROCESS(Source, _base::Source)
+    {
+      // For static scenes, the weights of the last block are re-used
+      if (this->geometry_changed())
+      {
+        _update_geometry_weights();
+      }
+    }
+
     bool get_output_levels(sample_type* first, sample_type* last) const;
+
+  private:
+    void _update_geometry_weights();
+
+    apf::fixed_vector<sample_type> _weights;  // temporary storage
+    apf::fixed_vector<float> _cos, _sin;  // cos(m * theta), sin(m * theta)
 };
 
 class AapRenderer::SourceChannel
@@ -90,6 +119,9 @@ class AapRenderer::SourceChannel
 
     const Source& source;
 
+    /// Weight without source volume, only updated if source.geometry_changed()
+    sample_type geometry_weight = 0;
+
     using iterator = decltype(source.begin());
 
     iterator begin() const { return source.begin(); }
@@ -183,9 +215,14 @@ AapRenderer::load_reproduction_setup()
 
   for (const auto& out: rtlist_proxy<Output>(this->get_output_list()))
   {
+    // WARNING: The reference offset is currently broken!
+    _loudspeaker_angles.push_back(
+        apf::math::deg2rad(out.position.orientation().azimuth));
+
     if (out.model == Loudspeaker::subwoofer)
     {
       // TODO: something
+      _subwoofers.push_back(_loudspeaker_angles.size() - 1);
     }
     else  // loudspeaker type == normal
     {
@@ -207,80 +244,170 @@ AapRenderer::load_reproduction_setup()
 
   VERBOSE("Using Ambisonics order " << _ambisonics_order << ".");
 
-  // TODO: more things?
-}
-
-apf::CombineChannelsResult::type
-AapRenderer::RenderFunction::select(SourceChannel& in)
-{
-  // TODO: take loudspeaker weight into account (for misplaced loudspeakers)?
-
-  using apf::math::deg2rad;
-
-  float two_times_order = 2 * _out.parent._ambisonics_order;
-
-  auto weighting_factor = sample_type();
-
-  if (_out.model == Loudspeaker::normal)
+  // The panning functions are written as Fourier series (for each order m
+  // up to the Ambisonics order N):
+  //
+  //   in-phase: cos^2N(x/2) = sum_m w_m cos(m x)
+  //     with w_0 = binomial(2N, N) / 2^2N
+  //     and  w_m = 2 binomial(2N, N-m) / 2^2N
+  //
+  //   basic: sin((2N+1) x/2) / ((2N+1) sin(x/2)) = sum_m w_m cos(m x)
+  //     with w_0 = 1 / (2N+1)
+  //     and  w_m = 2 / (2N+1)
+  //
+  // With x = alpha_0 - theta_pw, cos(m x) is split into
+  // cos(m alpha_0) cos(m theta_pw) + sin(m alpha_0) sin(m theta_pw).
+  // The loudspeaker-dependent part is stored in tables (together with w_m),
+  // the source-dependent part is obtained with a recurrence relation.
+
+  auto order = size_t(_ambisonics_order);
+
+  std::vector<double> order_weights(order + 1);
+
+  if (_in_phase_rendering)
   {
-    // WARNING: The reference offset is currently broken!
-
-    float alpha_0  = deg2rad((_out.position).orientation().azimuth);
-    float theta_pw = deg2rad(((in.source.position -
-            _out.parent.state.reference_position).orientation()
-          - _out.parent.state.reference_orientation).azimuth);
-
-    // TODO: wrap angles?
-
-    if (_out.parent._in_phase_rendering)
+    // binomial(2N, N) / 2^2N = prod_k (2k-1) / 2k
+    double w_0 = 1.0;
+    for (size_t k = 1; k <= order; ++k)
     {
-      weighting_factor = std::pow(std::cos((alpha_0 - theta_pw) / 2)
-          , two_times_order);
+      w_0 *= (2.0 * k - 1.0) / (2.0 * k);
     }
-    else
+
+    // binomial(2N, N-m) / binomial(2N, N-m+1) = (N-m+1) / (N+m)
+    order_weights[0] = w_0;
+    double ratio = 1.0;
+    for (size_t m = 1; m <= order; ++m)
     {
-      // check numerical stability
-      if (std::abs(std::sin((alpha_0 - theta_pw) / 2)) < 0.0001f)
-      {
-        weighting_factor = 1;
-      }
-      else
-      {
-        weighting_factor
-          = std::sin((two_times_order + 1) * (alpha_0 - theta_pw) / 2) /
-           ((two_times_order + 1) * std::sin((alpha_0 - theta_pw) / 2));
-      }
+      ratio *= double(order - m + 1) / double(order + m);
+      order_weights[m] = 2.0 * w_0 * ratio;
     }
   }
   else
   {
-    // TODO: subwoofer gets weighting factor 1.0?
-    weighting_factor = 1;
+    order_weights[0] = 1.0 / (2.0 * order + 1.0);
+    for (size_t m = 1; m <= order; ++m)
+    {
+      order_weights[m] = 2.0 / (2.0 * order + 1.0);
+    }
   }
 
+  size_t outputs = _loudspeaker_angles.size();
+
+  _cos_table.resize((order + 1) * outputs);
+  _sin_table.resize((order + 1) * outputs);
+
+  for (size_t m = 0; m <= order; ++m)
+  {
+    for (size_t i = 0; i < outputs; ++i)
+    {
+      double angle = double(m) * _loudspeaker_angles[i];
+      _cos_table[m * outputs + i] = float(order_weights[m] * std::cos(angle));
+      _sin_table[m * outputs + i] = float(order_weights[m] * std::sin(angle));
+    }
+  }
+}
+
+/** Calculate the weights for all Outputs at once.
+ * Only two trigonometric functions are evaluated per Source, cos(m theta_pw)
+ * and sin(m theta_pw) are obtained with the Chebyshev recurrence
+ *   cos(m x) = 2 cos(x) cos((m-1) x) - cos((m-2) x) (same for sin()).
+ * The remaining loops only depend on the tables created in
+ * load_reproduction_setup() and can be vectorized by the compiler.
+ **/
+void
+AapRenderer::Source::_update_geometry_weights()
+{
+  // TODO: take loudspeaker weight into account (for misplaced loudspeakers)?
+
+  using apf::math::deg2rad;
+
   // TODO: centralize distance attenuation
 
+  auto distance_weight = sample_type();
+
   // no distance attenuation for plane waves 
-  if (in.source.model == ::Source::plane)
+  if (this->model == ::Source::plane)
   {
-    auto ampl_ref = _out.parent.state.amplitude_reference_distance;
-    weighting_factor *= 0.5f / ampl_ref;  // 1/r
-    //weighting_factor *= 0.25f / sqrt(ampl_ref);  // 1/sqrt(r)
+    auto ampl_ref = this->parent.state.amplitude_reference_distance;
+    distance_weight = 0.5f / ampl_ref;  // 1/r
+    //distance_weight = 0.25f / sqrt(ampl_ref);  // 1/sqrt(r)
   }
   else
   {
     auto source_distance
-      = (in.source.position - _out.parent.state.reference_position).length();
+      = (this->position - this->parent.state.reference_position).length();
 
     // no volume increase for sources closer than 0.5m to reference position
     source_distance = std::max(source_distance, 0.5f);
 
-    weighting_factor *= 0.5f / source_distance;  // 1/r
-    //weighting_factor *= 0.25f / sqrt(source_distance);  // 1/sqrt(r)
+    distance_weight = 0.5f / source_distance;  // 1/r
+    //distance_weight = 0.25f / sqrt(source_distance);  // 1/sqrt(r)
+  }
+
+  // WARNING: The reference offset is currently broken!
+
+  float theta_pw = deg2rad(((this->position
+          - this->parent.state.reference_position).orientation()
+        - this->parent.state.reference_orientation).azimuth);
+
+  size_t order = _cos.size() - 1;
+
+  // Recurrence in double precision to avoid accumulation of rounding errors
+  double two_cos_theta = 2.0 * std::cos(double(theta_pw));
+  double cos_m1 = 1.0, cos_m2 = std::cos(double(theta_pw));  // m=0, m=-1
+  double sin_m1 = 0.0, sin_m2 = -std::sin(double(theta_pw));
+  for (size_t m = 0; m <= order; ++m)
+  {
+    _cos[m] = float(cos_m1);
+    _sin[m] = float(sin_m1);
+
+    double cos_next = two_cos_theta * cos_m1 - cos_m2;
+    double sin_next = two_cos_theta * sin_m1 - sin_m2;
+    cos_m2 = cos_m1;
+    cos_m1 = cos_next;
+    sin_m2 = sin_m1;
+    sin_m1 = sin_next;
+  }
+
+  sample_type* weights = _weights.data();
+  size_t size = _weights.size();
+
+  std::fill(weights, weights + size, sample_type());
+
+  for (size_t m = 0; m <= order; ++m)
+  {
+    const float* cos_table = &this->parent._cos_table[m * size];
+    const float* sin_table = &this->parent._sin_table[m * size];
+    float cos_m = _cos[m], sin_m = _sin[m];
+
+    for (size_t i = 0; i < size; ++i)
+    {
+      weights[i] += cos_table[i] * cos_m + sin_table[i] * sin_m;
+    }
   }
 
+  for (size_t i = 0; i < size; ++i)
+  {
+    weights[i] *= distance_weight;
+  }
+
+  // TODO: subwoofer gets weighting factor 1.0?
+  for (auto i: this->parent._subwoofers)
+  {
+    weights[i] = distance_weight;
+  }
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    this->sourcechannels[i].geometry_weight = weights[i];
+  }
+}
+
+apf::CombineChannelsResult::type
+AapRenderer::RenderFunction::select(SourceChannel& in)
+{
   // Apply source volume, mute, ...
-  weighting_factor *= in.source.weighting_factor;
+  auto weighting_factor = in.geometry_weight * in.source.weighting_factor;
 
   in.stored_weight = weighting_factor;
 
@@ -32,10 +32,9 @@
 
 #include "rendererbase.h"
 #include "apf/iterator.h"  // for apf::cast_proxy, apf::make_cast_proxy()
-#include "apf/convolver.h"  // for apf::conv::*
-#include "apf/container.h"  // for apf::fixed_matrix
-#include "apf/sndfiletools.h"  // for apf::load_sndfile
+#include "apf/nonuniform_convolver.h"  // for apf::conv::nonuniform::*
 #include "apf/combine_channels.h"  // for apf::raised_cosine_fade, ...
+#include "filtercache.h"  // for FilterCache
 
 namespace ssr
 {
@@ -57,7 +56,7 @@ class BinauralRenderer : public SourceToOutput<BinauralRenderer, RendererBase>
     BinauralRenderer(const apf::parameter_map& params)
       : _base(params)
       , _fade(this->block_size())
-      , _partitions(0)
+      , _frequency_domain(params.get("frequency_domain_accumulation", false))
     {}
 
     void load_reproduction_setup();
@@ -68,29 +67,27 @@ class BinauralRenderer : public SourceToOutput<BinauralRenderer, RendererBase>
     }
 
   private:
-    using hrtf_set_t = apf::fixed_vector<apf::conv::Filter>;
-
     void _load_hrtfs(const std::string& filename, size_t size);
 
-    static bool _cmp_abs(sample_type left, sample_type right)
-    {
-      return std::abs(left) < std::abs(right);
-    }
-
     apf::raised_cosine_fade<sample_type> _fade;
-    size_t _partitions;
+    bool _frequency_domain;  // accumulate outputs in frequency domain
     size_t _angles;  // Number of angles in HRIR file
-    std::unique_ptr<hrtf_set_t> _hrtfs;
-    std::unique_ptr<apf::conv::Filter> _neutral_filter;
+    FilterCache::pointer _hrtfs;  // shared with other renderers
+    std::unique_ptr<apf::conv::nonuniform::Filter> _neutral_filter;
 };
 
-class BinauralRenderer::SourceChannel : public apf::conv::Output
-                                      , public apf::has_begin_and_end<float*>
+class BinauralRenderer::SourceChannel
+                                  : public apf::conv::nonuniform::Output
+                                  , public apf::has_begin_and_end<float*>
 {
   public:
-    SourceChannel(const apf::conv::Input& input)
-      : apf::conv::Output(input)
-      , temporary_hrtf(input.block_size(), input.partitions())
+    SourceChannel(const apf::conv::nonuniform::Input& input
+        , bool frequency_domain)
+      : apf::conv::nonuniform::Output(input)
+      , temporary_hrtf(input.layout())
+      , old_result(frequency_domain
+          ? new apf::conv::nonuniform::Accumulator(input.block_size())
+          : nullptr)
       , _block_size(input.block_size())
     {}
 
@@ -105,7 +102,17 @@ class BinauralRenderer::SourceChannel : public apf::conv::Output
       this->convolve_and_more(this->weight);
     }
 
-    apf::conv::Filter temporary_hrtf;
+    void accumulate_old(sample_type old_weight)
+    {
+      assert(old_result);
+      old_result->clear();
+      this->accumulate(*old_result, old_weight);
+    }
+
+    apf::conv::nonuniform::Filter temporary_hrtf;
+
+    /// Result with the old filter (only for frequency-domain accumulation)
+    std::unique_ptr<apf::conv::nonuniform::Accumulator> old_result;
 
     sample_type weight;
     apf::CombineChannelsResult::type crossfade_mode;
@@ -117,9 +124,13 @@ class BinauralRenderer::SourceChannel : public apf::conv::Output
 void
 BinauralRenderer::_load_hrtfs(const std::string& filename, size_t size)
 {
-  auto hrir_file = apf::load_sndfile(filename, this->sample_rate(), 0);
+  _hrtfs = FilterCache::get({filename, size_t(this->sample_rate())
+      , size_t(this->block_size()), size
+      , this->params.get("nonuniform_partitions", 0u)
+      , this->params.get("nonuniform_max_block_size", 0u)}
+      , this->params.get("filter_cache_dir", ""));
 
-  const size_t no_of_channels = hrir_file.channels();
+  const size_t no_of_channels = _hrtfs->channels();
 
   if (no_of_channels % 2 != 0)
   {
@@ -128,43 +139,14 @@ BinauralRenderer::_load_hrtfs(const std::string& filename, size_t size)
 
   _angles = no_of_channels / 2;
 
-  // TODO: handle size > hrir_file.frames()
-
-  if (size == 0) size = hrir_file.frames();
-
-  // Deinterleave channels and transform to FFT domain
-
-  auto transpose = apf::fixed_matrix<float>(size, no_of_channels);
-
-  size = hrir_file.readf(transpose.data(), size);
-
-  _partitions = apf::conv::min_partitions(this->block_size(), size);
-
-  auto temp = apf::conv::Transform(this->block_size());
-
-  _hrtfs.reset(new hrtf_set_t(no_of_channels, this->block_size(), _partitions));
-
-  auto target = _hrtfs->begin();
-  for (const auto& slice: transpose.slices)
-  {
-    temp.prepare_filter(slice.begin(), slice.end(), *target++);
-  }
-
   // prepare neutral filter (dirac impulse) for interpolation around the head
 
-  // get index of absolute maximum in first channel (frontal direcion, left)
-  apf::fixed_matrix<sample_type>::slice_iterator maximum
-    = std::max_element(transpose.slices.begin()->begin()
-      , transpose.slices.begin()->end(), _cmp_abs);
-
-  int index = std::distance(transpose.slices.begin()->begin(), maximum);
-
-  auto impulse = apf::fixed_vector<sample_type>(index + 1);
+  // index of absolute maximum in first channel (frontal direcion, left)
+  auto impulse = apf::fixed_vector<sample_type>(_hrtfs->peak_index + 1);
   impulse.back() = 1;
 
-  _neutral_filter.reset(new apf::conv::Filter(this->block_size()
+  _neutral_filter.reset(new apf::conv::nonuniform::Filter(_hrtfs->layout
         , impulse.begin(), impulse.end()));
-  // Number of partitions may be different from _hrtfs!
 }
 
 class BinauralRenderer::RenderFunction
@@ -184,6 +166,19 @@ class BinauralRenderer::RenderFunction
       _in->update();
     }
 
+    void accumulate(apf::conv::nonuniform::Accumulator& target)
+    {
+      assert(_in);
+      _in->accumulate(target, _in->weight);
+    }
+
+    void accumulate(apf::conv::nonuniform::Accumulator& target
+        , apf::fade_out_tag)
+    {
+      assert(_in && _in->old_result);
+      target.add(*_in->old_result);
+    }
+
   private:
     SourceChannel* _in;
 };
@@ -194,17 +189,36 @@ class BinauralRenderer::Output : public _base::Output
     Output(const Params& p)
       : _base::Output(p)
       , _combiner(this->sourcechannels, this->buffer, this->parent._fade)
-    {}
+    {
+      if (this->parent._frequency_domain)
+      {
+        _accumulator.reset(new accumulator_t(this->sourcechannels
+              , this->buffer, this->parent._fade));
+      }
+    }
 
     APF_PROCESS(Output, _base::Output)
     {
-      _combiner.process(RenderFunction());
+      if (_accumulator)
+      {
+        _accumulator->process(RenderFunction());
+      }
+      else
+      {
+        _combiner.process(RenderFunction());
+      }
     }
 
   private:
+    using accumulator_t = apf::CombineChannelsCrossfadeAccumulate<
+      apf::cast_proxy<SourceChannel, sourcechannels_t>, buffer_type
+      , apf::raised_cosine_fade<sample_type>
+      , apf::conv::nonuniform::Accumulator>;
+
     apf::CombineChannelsCrossfadeCopy<apf::cast_proxy<SourceChannel
       , sourcechannels_t>, buffer_type
       , apf::raised_cosine_fade<sample_type>> _combiner;
+    std::unique_ptr<accumulator_t> _accumulator;
 };
 
 void BinauralRenderer::load_reproduction_setup()
@@ -238,7 +252,8 @@ void BinauralRenderer::load_reproduction_setup()
   this->add(params);
 }
 
-class BinauralRenderer::Source : public apf::conv::Input, public _base::Source
+class BinauralRenderer::Source : public apf::conv::nonuniform::Input
+                               , public _base::Source
 {
   private:
     void _process();
@@ -246,8 +261,8 @@ class BinauralRenderer::Source : public apf::conv::Input, public _base::Source
   public:
     Source(const Params& p)
       // TODO: assert that p.parent != 0?
-      : apf::conv::Input(p.parent->block_size(), p.parent->_partitions)
-      , _base::Source(p, 2, *this)
+      : apf::conv::nonuniform::Input(p.parent->_hrtfs->layout)
+      , _base::Source(p, 2, *this, p.parent->_frequency_domain)
       , _hrtf_index(size_t(-1))
       , _interp_factor(-1.0f)
       , _weight(0.0f)
@@ -356,6 +371,12 @@ void BinauralRenderer::Source::_process()
     {
       // No need to convolve
     }
+    else if (_input.parent._frequency_domain)
+    {
+      // The filter doesn't change in the "constant" case, the result is
+      // accumulated later in the Output
+      if (crossfade_mode != constant) channel.accumulate_old(_weight.old());
+    }
     else
     {
       channel.convolve_and_more(_weight.old());
@@ -366,7 +387,7 @@ void BinauralRenderer::Source::_process()
     if (hrtf_changed)
     {
       // left and right channels are interleaved
-      auto& hrtf = (*_input.parent._hrtfs)[2 * _hrtf_index + i];
+      auto& hrtf = _input.parent._hrtfs->filters[2 * _hrtf_index + i];
 
       if (_interp_factor == 0)
       {
@@ -375,7 +396,7 @@ void BinauralRenderer::Source::_process()
       else
       {
         // Interpolate between selected HRTF and neutral filter (Dirac)
-        apf::conv::transform_nested(hrtf
+        apf::conv::nonuniform::transform_nested(hrtf
             , *_input.parent._neutral_filter, channel.temporary_hrtf
             , [this] (sample_type one, sample_type two)
               {
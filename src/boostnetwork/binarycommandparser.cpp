@@ -0,0 +1,152 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+
+/// @file
+/// BinaryCommandParser class (implementation).
+
+#include "ssr_global.h" // for ERROR()
+#include "binarycommandparser.h"
+#include "binaryprotocol.h"
+#include "commandparser.h"
+#include "publisher.h"
+
+using namespace ssr::binaryprotocol;
+
+/** ctor.
+ * @param controller
+ * @param xml_parser used for frames containing XML requests
+ **/
+ssr::BinaryCommandParser::BinaryCommandParser(Publisher& controller
+    , CommandParser& xml_parser)
+  : _controller(controller)
+  , _xml_parser(xml_parser)
+{}
+
+/** Parse all complete frames in a buffer and map to Controller.
+ * All frames of one call are applied in one transaction.
+ * @param first beginning of the received data, on return it points to the
+ *   first byte which was not yet parsed.
+ * @param last end of the received data
+ * @return number of bytes which are missing to complete the next frame, zero
+ *   on a protocol error (the connection should be closed).
+ **/
+size_t
+ssr::BinaryCommandParser::parse(const char*& first, const char* last)
+{
+  ScopedTransaction transaction(_controller);
+
+  for (;;)
+  {
+    auto available = size_t(last - first);
+    if (available < header_size) return header_size - available;
+
+    uint32_t size;
+    Reader(first, last).read(size);
+
+    if (size > max_payload_size)
+    {
+      ERROR("Binary frame too large (" << size << " bytes)!");
+      return 0;
+    }
+    if (available < header_size + size)
+    {
+      return header_size + size - available;
+    }
+
+    auto payload = first + header_size;
+    if (!_parse_frame(static_cast<unsigned char>(first[4]), payload
+          , payload + size))
+    {
+      return 0;
+    }
+    first = payload + size;
+  }
+}
+
+bool
+ssr::BinaryCommandParser::_parse_frame(unsigned char type
+    , const char* first, const char* last)
+{
+  Reader payload(first, last);
+  id_t id = 0;
+  float x, y, z = 0.0f;
+  bool ok = true;
+
+  switch (type)
+  {
+    case xml:
+      _xml_parser.parse_cmd(first, last);
+      break;
+
+    case source_position:
+      ok = payload.read(id) && payload.read(x) && payload.read(y)
+        && (payload.begin() == payload.end() || payload.read(z));
+      if (ok) _controller.set_source_position(id, Position(x, y, z));
+      break;
+
+    case source_orientation:
+      ok = payload.read(id) && payload.read(x);
+      if (ok) _controller.set_source_orientation(id, Orientation(x));
+      break;
+
+    case source_gain:
+      ok = payload.read(id) && payload.read(x);
+      if (ok) _controller.set_source_gain(id, x);
+      break;
+
+    case source_mute:
+      {
+        bool mute;
+        ok = payload.read(id) && payload.read(mute);
+        if (ok) _controller.set_source_mute(id, mute);
+      }
+      break;
+
+    case reference_position:
+      ok = payload.read(x) && payload.read(y)
+        && (payload.begin() == payload.end() || payload.read(z));
+      if (ok) _controller.set_reference_position(Position(x, y, z));
+      break;
+
+    case reference_orientation:
+      ok = payload.read(x);
+      if (ok) _controller.set_reference_orientation(Orientation(x));
+      break;
+
+    default:
+      ERROR("Unknown binary message type: " << int(type));
+      return false;
+  }
+
+  // payload too short or non-finite float, see Reader
+  if (!ok) ERROR("Invalid binary message (type " << int(type) << ")!");
+  return ok;
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -0,0 +1,66 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+
+/// @file
+/// BinaryCommandParser class (definition).
+
+#ifndef SSR_BINARYCOMMANDPARSER_H
+#define SSR_BINARYCOMMANDPARSER_H
+
+#include <cstddef>  // for size_t
+
+namespace ssr
+{
+
+struct Publisher;
+class CommandParser;
+
+/** Parses frames of the binary network protocol and maps to Controller.
+ * @see binaryprotocol.h for the message layout.
+ **/
+class BinaryCommandParser
+{
+  public:
+    BinaryCommandParser(Publisher& controller, CommandParser& xml_parser);
+
+    size_t parse(const char*& first, const char* last);
+
+  private:
+    bool _parse_frame(unsigned char type, const char* first, const char* last);
+
+    Publisher& _controller;
+    /// Used for @c xml frames
+    CommandParser& _xml_parser;
+};
+
+}  // namespace ssr
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -0,0 +1,198 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+
+/// @file
+/// Message layout of the binary network protocol.
+
+#ifndef SSR_BINARYPROTOCOL_H
+#define SSR_BINARYPROTOCOL_H
+
+#include <cmath>  // for std::isfinite()
+#include <cstdint>  // for uint8_t, uint32_t
+#include <cstring>  // for std::memcpy()
+#include <string>
+
+namespace ssr
+{
+
+/** Binary network protocol.
+ * A client switches its connection to the binary protocol by sending the
+ * (zero-terminated) handshake() string instead of an XML request.
+ * The server answers with the same string and from then on all messages in
+ * both directions are frames of the form
+ *
+ *   <tt>uint32 size | uint8 type | payload (size bytes)</tt>
+ *
+ * All numbers are little-endian, @c float is IEEE 754 single precision.
+ * Payloads of the different message types:
+ *
+ * - @c xml: XML request/update (without terminating zero)
+ * - @c source_position: <tt>uint32 id, float x, float y [, float z]</tt>
+ * - @c source_orientation: <tt>uint32 id, float azimuth</tt>
+ * - @c source_gain: <tt>uint32 id, float gain</tt> (linear)
+ * - @c source_mute: <tt>uint32 id, uint8 mute</tt>
+ * - @c reference_position: <tt>float x, float y [, float z]</tt>
+ * - @c reference_orientation: <tt>float azimuth</tt>
+ * - @c source_level: <tt>uint32 id, float level</tt>
+ *   (linear, only sent by the server)
+ * - @c master_level: <tt>float level</tt> (linear, only sent by the server)
+ *
+ * Values in brackets are optional (zero if not given), the server only sends
+ * them if they are non-zero.
+ * Frames which are too short or contain a non-finite @c float are treated as
+ * protocol error.
+ *
+ * Everything which has no binary message (e.g. new sources, scene loading) is
+ * sent as @c xml frame.
+ **/
+namespace binaryprotocol
+{
+
+enum message_t : uint8_t
+{
+  xml = 0,
+  source_position = 1,
+  source_orientation = 2,
+  source_gain = 3,
+  source_mute = 4,
+  reference_position = 5,
+  reference_orientation = 6,
+  source_level = 7,
+  master_level = 8,
+};
+
+/// Zero-terminated message to switch a connection to the binary protocol
+inline const char* handshake() { return "SSR-BINARY-1"; }
+
+/// Size of the frame header (size and type)
+const size_t header_size = 5;
+
+/// Larger frames are treated as protocol error
+const uint32_t max_payload_size = 1 << 20;
+
+/// Assemble a frame, the size field is written by frame().
+class Writer
+{
+  public:
+    explicit Writer(message_t type, size_t reserve = 16)
+      : _data(header_size, '\0')
+    {
+      _data.reserve(header_size + reserve);
+      _data[4] = static_cast<char>(type);
+    }
+
+    Writer& operator<<(uint32_t value)
+    {
+      char bytes[4] = { char(value), char(value >> 8), char(value >> 16)
+        , char(value >> 24) };
+      _data.append(bytes, 4);
+      return *this;
+    }
+
+    Writer& operator<<(float value)
+    {
+      uint32_t bits;
+      std::memcpy(&bits, &value, 4);
+      return *this << bits;
+    }
+
+    Writer& operator<<(bool value)
+    {
+      _data.push_back(value ? '\1' : '\0');
+      return *this;
+    }
+
+    Writer& operator<<(const std::string& value)
+    {
+      _data.append(value);
+      return *this;
+    }
+
+    /// Fill in the size field and return the whole frame.
+    std::string& frame()
+    {
+      auto size = static_cast<uint32_t>(_data.size() - header_size);
+      for (size_t i = 0; i < 4; ++i) _data[i] = char(size >> (8 * i));
+      return _data;
+    }
+
+  private:
+    std::string _data;
+};
+
+/// Read values from a payload, all functions return @b false on underflow.
+/// Non-finite floats (NaN, infinity) are rejected as well.
+class Reader
+{
+  public:
+    Reader(const char* first, const char* last)
+      : _first(first)
+      , _last(last)
+    {}
+
+    bool read(uint32_t& value)
+    {
+      if (_last - _first < 4) return false;
+      auto bytes = reinterpret_cast<const unsigned char*>(_first);
+      value = uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8
+        | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+      _first += 4;
+      return true;
+    }
+
+    bool read(float& value)
+    {
+      uint32_t bits;
+      if (!this->read(bits)) return false;
+      std::memcpy(&value, &bits, 4);
+      return std::isfinite(value);
+    }
+
+    bool read(bool& value)
+    {
+      if (_first == _last) return false;
+      value = *_first++ != '\0';
+      return true;
+    }
+
+    const char* begin() const { return _first; }
+    const char* end() const { return _last; }
+
+  private:
+    const char* _first;
+    const char* _last;
+};
+
+}  // namespace binaryprotocol
+
+}  // namespace ssr
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -28,6 +28,7 @@
 /// CommandParser class (implementation).
 
 #include <cassert>
+#include <sstream>
 
 #include "ssr_global.h" // for ERROR()
 #include "commandparser.h"
@@ -40,452 +41,563 @@ using namespace apf::str;
 
 /** ctor.
  * @param controller 
+ * @param subscriber subscriber of the client, without it, level
+ *   subscriptions are ignored
  **/
-ssr::CommandParser::CommandParser(Publisher& controller)
+ssr::CommandParser::CommandParser(Publisher& controller
+    , LevelSubscriber* subscriber)
   : _controller(controller)
+  , _subscriber(subscriber)
 {}
 
 /// dtor.
 ssr::CommandParser::~CommandParser() {}
 
-/** Parse a XML string and map to Controller.
- * @param cmd XML string. 
+/** Call a function for each child element of the current element.
+ * The function must consume the child element (including its end tag).
+ * @return @b false on error or if the function returned @b false
+ **/
+template<typename F>
+bool
+ssr::CommandParser::_for_each_child(F f)
+{
+  for (;;)
+  {
+    auto event = _xml.next();
+    if (event == XmlPullParser::end_element) return true;
+    if (event != XmlPullParser::start_element) return _syntax_error();
+    if (!f()) return false;
+  }
+}
+
+/// Skip the current element, @return @b false on syntax error
+bool
+ssr::CommandParser::_skip()
+{
+  if (_xml.skip() == XmlPullParser::end_element) return true;
+  return _syntax_error();
+}
+
+bool
+ssr::CommandParser::_syntax_error()
+{
+  ERROR("Syntax error in network message!");
+  return false;
+}
+
+/// Read attributes of a @c position element, @c z is optional.
+/// @return @b false if @c x or @c y is missing or a value is invalid
+bool
+ssr::CommandParser::_get_position(Position& position)
+{
+  auto z = _xml.attribute("z");
+  position.z = 0.0f;
+  return _xml.attribute("x").get(position.x)
+    && _xml.attribute("y").get(position.y)
+    && (!z || z.get(position.z));
+}
+
+/** Parse a XML request and map to Controller.
+ * The request is parsed in place, without building a document tree.
+ * All changes of the request are applied in one transaction.
+ * @param first beginning of the XML string
+ * @param last end of the XML string (the terminating zero is not included)
  **/
 void
-ssr::CommandParser::parse_cmd(std::string& cmd)
+ssr::CommandParser::parse_cmd(const char* first, const char* last)
 {
-  XMLParser xp;
-  XMLParser::doc_t doc1 = xp.load_string(cmd);
-  if (!doc1)
+  _xml.reset(first, last);
+
+  auto event = _xml.next();
+  if (event != XmlPullParser::start_element || !_xml.is("request"))
   {
-    ERROR("Unable to load string! (\"" << cmd << "\")");
+    ERROR("Unable to load string! (\"" << std::string(first, last) << "\")");
     return;
   }
 
-  XMLParser::xpath_t result1 = doc1->eval_xpath("/request");
+  ScopedTransaction transaction(_controller);
 
-  if (!result1)
+  _for_each_child([this] ()
   {
-    ERROR("XPath: no result!");
-    return;
+    if (_xml.is("source")) return _parse_source();
+    if (_xml.is("reference")) return _parse_reference(false);
+    if (_xml.is("reference_offset")) return _parse_reference(true);
+    if (_xml.is("delete")) return _parse_delete();
+    if (_xml.is("scene")) return _parse_scene();
+    if (_xml.is("state")) return _parse_state();
+    if (_xml.is("levels")) return _parse_levels();
+    return _skip();
+  });
+}
+
+bool
+ssr::CommandParser::_parse_source()
+{
+  // Attributes are only valid until the first child is parsed
+  auto volume_attr = _xml.attribute("volume");
+  auto mute_attr = _xml.attribute("mute");
+  auto name_attr = _xml.attribute("name");
+  auto properties_file_attr = _xml.attribute("properties_file");
+  auto model_attr = _xml.attribute("model");
+  auto port_attr = _xml.attribute("port");
+  auto file_attr = _xml.attribute("file");
+  auto channel_attr = _xml.attribute("channel");
+
+  bool new_source = false;
+  if (!_xml.attribute("new").get(new_source))
+  {
+    new_source = false;
   }
-  XMLParser::Node node1 = result1->node(); // get first (and only?) node.
 
-  for (XMLParser::Node i = node1.child(); !!i; ++i)
+  id_t id = 0; // ugly ...
+  if (!new_source)
   {
-    if (i == "source")
+    if (!_xml.attribute("id").get(id))
     {
-      bool new_source = false;
-      if (!S2A (i.get_attribute("new"), new_source))
-      {
-        new_source = false;
-      }
-
-      id_t id = 0; // ugly ...
-      if (!new_source)
-      {
-        if (!S2A(i.get_attribute("id"),id))
-        {
-          ERROR("No source ID specified!");
-          return;
-        }
-      }
+      ERROR("No source ID specified!");
+      return false;
+    }
+  }
 
-      Position position;
-      Orientation orientation;
-      bool position_fixed = false, orientation_fixed = false;
+  Position position;
+  Orientation orientation;
+  bool position_fixed = false, orientation_fixed = false;
 
-      for (XMLParser::Node inner_loop = i.child(); !!inner_loop; ++inner_loop)
+  bool ok = _for_each_child([&] ()
+  {
+    if (_xml.is("position"))
+    {
+      if (_get_position(position))
       {
-        if (inner_loop == "position")
-        {
-          if (S2A(inner_loop.get_attribute("x"), position.x)
-              && S2A(inner_loop.get_attribute("y"), position.y))
-          {
-            if (!new_source)
-            {
-              _controller.set_source_position(id, position);
-              VERBOSE2("set source position: id = " << id << ", " << position);
-            }
-            else
-            {
-              // position is used later for _controller.new_source(...)
-            }
-          }
-          else
-          {
-            position = Position();
-          }
-
-          if (S2A(inner_loop.get_attribute("fixed"), position_fixed))
-          {
-            if (!new_source)
-            {
-              _controller.set_source_position_fixed(id, position_fixed);
-              VERBOSE2("set source position fixed: id = " << id << ", fixed = "
-                  << A2S(position_fixed));
-            }
-          }
-          else
-          {
-            position_fixed = false;
-          }
-        }
-        else if (inner_loop == "orientation")
+        if (!new_source)
         {
-          if (S2A(inner_loop.get_attribute("azimuth"), orientation.azimuth))
-          {
-            if (!new_source)
-            {
-              _controller.set_source_orientation(id, orientation);
-              VERBOSE2("set source orientation: id = " << id << ", "
-                  << orientation);
-            }
-            else
-            {
-              // orientation is used later for _controller.new_source(...)
-            }
-          }
-          else
-          {
-            orientation = Orientation();
-          }
-          // source orientation_fixed is not yet implemented!
-          /*
-          if (S2A(inner_loop.get_attribute("fixed"),
-          orientation_fixed))
-          {
-          if (!new_source)
-          {
-          _controller.set_source_orientation_fix(id, orientation_fixed);
-          VERBOSE2("set source orientation fixed");
-          }
-          }
-          else
-          {
-          orientation_fixed = false;
-          }
-          */
+          _controller.set_source_position(id, position);
+          VERBOSE2("set source position: id = " << id << ", " << position);
         }
-      }//for (XMLParser:...
-
-      float volume;
-      if (S2A(i.get_attribute("volume"),volume))
-      {
-        // volume is given in dB in the network messages
-        volume = apf::math::dB2linear(volume);
-        if (!new_source)
+        else
         {
-          _controller.set_source_gain(id, volume);
-          VERBOSE2("set source volume: id = " << id
-              << ", volume (linear) = " << volume);
+          // position is used later for _controller.new_source(...)
         }
       }
       else
       {
-        volume = 1.0; // linear
+        position = Position();
       }
 
-      bool muted;
-      if (S2A(i.get_attribute("mute"), muted))
+      if (_xml.attribute("fixed").get(position_fixed))
       {
         if (!new_source)
         {
-          _controller.set_source_mute(id, muted);
-          VERBOSE2("set source mute mode: id = " << id
-              << ", mute = " << A2S(muted));
+          _controller.set_source_position_fixed(id, position_fixed);
+          VERBOSE2("set source position fixed: id = " << id << ", fixed = "
+              << A2S(position_fixed));
         }
       }
       else
       {
-        muted = false;
-      }
-      std::string name = i.get_attribute("name");
-      if (!name.empty() && !new_source)
-      {
-        _controller.set_source_name(id,name);
-        VERBOSE2("set source name: id = " << id << ", name = " << name);
+        position_fixed = false;
       }
-
-      std::string properties_file = i.get_attribute("properties_file");
-      if (!properties_file.empty() && !new_source)
-      {
-        _controller.set_source_properties_file(id,properties_file);
-        VERBOSE2("set source properties file name: id = " << id
-            << ", file = " << properties_file);
-      }
-
-      Source::model_t model = Source::model_t();
-      if (S2A(i.get_attribute("model"),model))
+    }
+    else if (_xml.is("orientation"))
+    {
+      if (_xml.attribute("azimuth").get(orientation.azimuth))
       {
         if (!new_source)
         {
-          _controller.set_source_model(id,model);
-          VERBOSE2("set source model: id = " << id << ", model = " << model);
+          _controller.set_source_orientation(id, orientation);
+          VERBOSE2("set source orientation: id = " << id << ", "
+              << orientation);
+        }
+        else
+        {
+          // orientation is used later for _controller.new_source(...)
         }
       }
       else
       {
-        model = Source::point;
+        orientation = Orientation();
       }
+      // source orientation_fixed is not yet implemented!
+    }
+    return _skip();
+  });
+  if (!ok) return false;
 
-      std::string port_name = i.get_attribute("port");
-      if (!port_name.empty() && !new_source)
-      {
-        _controller.set_source_port_name(id,port_name);
-        VERBOSE2("set source port  name: id = " << id
-            << ", port = " << port_name);
-      }
+  float volume;
+  if (volume_attr.get(volume))
+  {
+    // volume is given in dB in the network messages
+    volume = apf::math::dB2linear(volume);
+    if (!new_source)
+    {
+      _controller.set_source_gain(id, volume);
+      VERBOSE2("set source volume: id = " << id
+          << ", volume (linear) = " << volume);
+    }
+  }
+  else
+  {
+    volume = 1.0; // linear
+  }
 
-      std::string file_or_port_name = port_name;
+  bool muted;
+  if (mute_attr.get(muted))
+  {
+    if (!new_source)
+    {
+      _controller.set_source_mute(id, muted);
+      VERBOSE2("set source mute mode: id = " << id
+          << ", mute = " << A2S(muted));
+    }
+  }
+  else
+  {
+    muted = false;
+  }
+  std::string name = name_attr.str();
+  if (!name.empty() && !new_source)
+  {
+    _controller.set_source_name(id,name);
+    VERBOSE2("set source name: id = " << id << ", name = " << name);
+  }
 
-      std::string file_name = i.get_attribute("file");
-      if (!file_name.empty() && !new_source)
-      {
-        ERROR("Cannot set file name! This works only for new sources.");
-      }
-      if (!file_name.empty() && !port_name.empty())
-      {
-        ERROR("Either file name or port name can be set, not both!");
-      }
-      if (new_source && file_name.empty() && port_name.empty())
-      {
-        ERROR("Either file name or port name must be specified!");
-      }
+  std::string properties_file = properties_file_attr.str();
+  if (!properties_file.empty() && !new_source)
+  {
+    _controller.set_source_properties_file(id,properties_file);
+    VERBOSE2("set source properties file name: id = " << id
+        << ", file = " << properties_file);
+  }
 
-      int channel = 0;
-      if (S2A(i.get_attribute("channel"), channel))
-      {
-        assert(channel >= 0);
+  Source::model_t model = Source::model_t();
+  if (model_attr.get(model))
+  {
+    if (!new_source)
+    {
+      _controller.set_source_model(id,model);
+      VERBOSE2("set source model: id = " << id << ", model = " << model);
+    }
+  }
+  else
+  {
+    model = Source::point;
+  }
 
-        if (file_name.empty())
-        {
-          ERROR("'channel' is only allowed if a file name is also specified!");
-          channel = 0;
-        }
-        else
-        {
-          file_or_port_name = file_name;
-        }
-      }
-      else if (!file_name.empty())
-      {
-        file_or_port_name = file_name;
-        channel = 1;
-      }
+  std::string port_name = port_attr.str();
+  if (!port_name.empty() && !new_source)
+  {
+    _controller.set_source_port_name(id,port_name);
+    VERBOSE2("set source port  name: id = " << id
+        << ", port = " << port_name);
+  }
 
-      if (new_source)
-      {
-        if (file_or_port_name == "")
-        {
-          ERROR("Either file name or port name must be specified!");
-        }
-        else
-        {
-          VERBOSE2("Creating source with following properties:"
-              "\nname: " << name <<
-              "\nmodel: " << model <<
-              "\nfile_or_port_name: " << file_or_port_name <<
-              "\nchannel: " << channel <<
-              "\nposition: " << position <<
-              "\nposition_fixed: " << A2S(position_fixed) <<
-              "\norientation: " << orientation <<
-              "\norientation_fixed: " << A2S(orientation_fixed) <<
-              "\nvolume (linear): " << volume <<
-              "\nmuted: " << A2S(muted) <<
-              "\nproperties_file: " << properties_file <<
-              "\n");
-
-          _controller.new_source(name, model, file_or_port_name, channel,
-              position, position_fixed, orientation, orientation_fixed,
-              volume, muted, properties_file);
-        }
-      }
+  std::string file_or_port_name = port_name;
 
-    } // if (source)
-    else if (i == "reference")
+  std::string file_name = file_attr.str();
+  if (!file_name.empty() && !new_source)
+  {
+    ERROR("Cannot set file name! This works only for new sources.");
+  }
+  if (!file_name.empty() && !port_name.empty())
+  {
+    ERROR("Either file name or port name can be set, not both!");
+  }
+  if (new_source && file_name.empty() && port_name.empty())
+  {
+    ERROR("Either file name or port name must be specified!");
+  }
+
+  int channel = 0;
+  if (channel_attr.get(channel))
+  {
+    assert(channel >= 0);
+
+    if (file_name.empty())
     {
-      for (XMLParser::Node inner_loop = i.child(); !!inner_loop; ++inner_loop)
+      ERROR("'channel' is only allowed if a file name is also specified!");
+      channel = 0;
+    }
+    else
+    {
+      file_or_port_name = file_name;
+    }
+  }
+  else if (!file_name.empty())
+  {
+    file_or_port_name = file_name;
+    channel = 1;
+  }
+
+  if (new_source)
+  {
+    if (file_or_port_name == "")
+    {
+      ERROR("Either file name or port name must be specified!");
+    }
+    else
+    {
+      VERBOSE2("Creating source with following properties:"
+          "\nname: " << name <<
+          "\nmodel: " << model <<
+          "\nfile_or_port_name: " << file_or_port_name <<
+          "\nchannel: " << channel <<
+          "\nposition: " << position <<
+          "\nposition_fixed: " << A2S(position_fixed) <<
+          "\norientation: " << orientation <<
+          "\norientation_fixed: " << A2S(orientation_fixed) <<
+          "\nvolume (linear): " << volume <<
+          "\nmuted: " << A2S(muted) <<
+          "\nproperties_file: " << properties_file <<
+          "\n");
+
+      _controller.new_source(name, model, file_or_port_name, channel,
+          position, position_fixed, orientation, orientation_fixed,
+          volume, muted, properties_file);
+    }
+  }
+  return true;
+}
+
+/// @param offset if @b true, the reference offset is changed
+bool
+ssr::CommandParser::_parse_reference(bool offset)
+{
+  return _for_each_child([this, offset] ()
+  {
+    if (_xml.is("position"))
+    {
+      Position position;
+      if (_get_position(position))
       {
-        if (inner_loop == "position")
+        if (offset)
         {
-          float x, y;
-          if (S2A(inner_loop.get_attribute("x"), x)
-              && S2A(inner_loop.get_attribute("y"), y))
-          {
-            _controller.set_reference_position(Position(x,y));
-            VERBOSE2("set reference position: " << Position(x,y));
-          }
-          else ERROR("Invalid reference position!");
+          _controller.set_reference_offset_position(position);
+          VERBOSE2("set reference offset position: " << position);
         }
-        else if (inner_loop == "orientation")
+        else
         {
-          float azimuth;
-          if (S2A(inner_loop.get_attribute("azimuth"), azimuth))
-          {
-            _controller.set_reference_orientation(Orientation(azimuth));
-            VERBOSE2("set reference orientation: " << Orientation(azimuth));
-          }
-          else ERROR("Invalid reference orientation!");
+          _controller.set_reference_position(position);
+          VERBOSE2("set reference position: " << position);
         }
       }
-    } // if (reference)
-    else if (i == "reference_offset")
+      else if (offset) ERROR("Invalid reference offset position!");
+      else ERROR("Invalid reference position!");
+    }
+    else if (_xml.is("orientation"))
     {
-      for (XMLParser::Node inner_loop = i.child(); !!inner_loop; ++inner_loop)
+      float azimuth;
+      if (_xml.attribute("azimuth").get(azimuth))
       {
-        if (inner_loop == "position")
+        if (offset)
         {
-          float x, y;
-          if (S2A(inner_loop.get_attribute("x"), x)
-              && S2A(inner_loop.get_attribute("y"), y))
-          {
-            _controller.set_reference_offset_position(Position(x,y));
-            VERBOSE2("set reference offset position: " << Position(x,y));
-          }
-          else ERROR("Invalid reference offset position!");
+          _controller.set_reference_offset_orientation(Orientation(azimuth));
+          VERBOSE2("set reference offset orientation: "
+              << Orientation(azimuth));
         }
-        else if (inner_loop == "orientation")
+        else
         {
-          float azimuth;
-          if (S2A(inner_loop.get_attribute("azimuth"), azimuth))
-          {
-            _controller.set_reference_offset_orientation(Orientation(azimuth));
-            VERBOSE2("set reference offset orientation: " << Orientation(azimuth));
-          }
-          else ERROR("Invalid reference offset orientation!");
+          _controller.set_reference_orientation(Orientation(azimuth));
+          VERBOSE2("set reference orientation: " << Orientation(azimuth));
         }
       }
-    } // if (reference_offset)
-    else if (i == "delete")
+      else if (offset) ERROR("Invalid reference offset orientation!");
+      else ERROR("Invalid reference orientation!");
+    }
+    return _skip();
+  });
+}
+
+bool
+ssr::CommandParser::_parse_delete()
+{
+  return _for_each_child([this] ()
+  {
+    if (_xml.is("source"))
     {
-      for (XMLParser::Node inner_loop = i.child(); !!inner_loop; ++inner_loop)
+      id_t id;
+      if (_xml.attribute("id").get(id))
       {
-        if (inner_loop == "source")
-        {
-          id_t id;
-          if (S2A(inner_loop.get_attribute("id"),id))
-          {
-            // if (id == 0) {} //_controller.delete_all_sources();
-            // else {}//_controller.delete_source(id);
-            _controller.delete_source(id);
-          }
-          else ERROR("Cannot read source ID!");
-        }
-        else {}
-      }// for ()
-    }// else if (delete)
-    else if (i== "scene")
-    {
-      // if both save and load are requested, first save, then load.
-      // TODO: or make save and load exclusive? That's maybe better ...
+        _controller.delete_source(id);
+      }
+      else ERROR("Cannot read source ID!");
+    }
+    return _skip();
+  });
+}
 
-      // save scene
+bool
+ssr::CommandParser::_parse_scene()
+{
+  // if both save and load are requested, first save, then load.
+  // TODO: or make save and load exclusive? That's maybe better ...
 
-      std::string save_scene = i.get_attribute("save");
-      if (save_scene != "")
-      {
-        _controller.save_scene_as_XML(save_scene);
-      }
+  // save scene
 
-      // load scene
+  std::string save_scene = _xml.attribute("save").str();
+  if (save_scene != "")
+  {
+    _controller.save_scene_as_XML(save_scene);
+  }
 
-      std::string load_scene = i.get_attribute("load");
-      if (load_scene != "")
-      {
-        _controller.load_scene(load_scene);
-      }
+  // load scene
 
-      std::string volume_str = i.get_attribute("volume");
-      float volume;
-      if (volume_str == "")
-      {
-        // do nothing
-      }
-      else if (S2A(volume_str, volume))
-      {
-        // volume is given in dB in the network messages
-        _controller.set_master_volume(apf::math::dB2linear(volume));
-        VERBOSE2("set master volume: " << volume << " dB");
-      }
-      else ERROR("Invalid Volume Setting! (\"" << volume_str << "\")");
+  std::string load_scene = _xml.attribute("load").str();
+  if (load_scene != "")
+  {
+    _controller.load_scene(load_scene);
+  }
 
-      bool clear_scene;
-      if (S2A(i.get_attribute("clear"), clear_scene) && clear_scene)
-      {
-        _controller.delete_all_sources();
-      }
-    }
-    else if (i == "state")
-    {
-      // start/stop audio processing
+  auto volume_attr = _xml.attribute("volume");
+  float volume;
+  if (volume_attr.empty())
+  {
+    // do nothing
+  }
+  else if (volume_attr.get(volume))
+  {
+    // volume is given in dB in the network messages
+    _controller.set_master_volume(apf::math::dB2linear(volume));
+    VERBOSE2("set master volume: " << volume << " dB");
+  }
+  else ERROR("Invalid Volume Setting! (\"" << volume_attr.str() << "\")");
 
-      std::string processing= i.get_attribute("processing");
-      if (processing == "start")
-      {
-        _controller.start_processing();
-      }
-      else if (processing == "stop")
-      {
-        _controller.stop_processing();
-      }
-      else if (processing != "")
-      {
-        ERROR("Invalid value for \"processing\": " << processing);
-      }
+  bool clear_scene;
+  if (_xml.attribute("clear").get(clear_scene) && clear_scene)
+  {
+    _controller.delete_all_sources();
+  }
+  return _skip();
+}
 
-      // start/stop/rewind transport
+bool
+ssr::CommandParser::_parse_state()
+{
+  // start/stop audio processing
 
-      std::string transport = i.get_attribute("transport");
-      if (transport == "start")
-      {
-        _controller.transport_start();
-      }
-      else if (transport == "stop")
-      {
-        _controller.transport_stop();
-      }
-      else if (transport == "rewind")
-      {
-        _controller.transport_locate(0);
-      }
-      else if (transport != "")
-      {
-        ERROR("Invalid value for \"transport\": " << transport);
-      }
+  std::string processing = _xml.attribute("processing").str();
+  if (processing == "start")
+  {
+    _controller.start_processing();
+  }
+  else if (processing == "stop")
+  {
+    _controller.stop_processing();
+  }
+  else if (processing != "")
+  {
+    ERROR("Invalid value for \"processing\": " << processing);
+  }
 
-      // jump to a certain time
+  // start/stop/rewind transport
 
-      std::string seek = i.get_attribute("seek");
+  std::string transport = _xml.attribute("transport").str();
+  if (transport == "start")
+  {
+    _controller.transport_start();
+  }
+  else if (transport == "stop")
+  {
+    _controller.transport_stop();
+  }
+  else if (transport == "rewind")
+  {
+    _controller.transport_locate(0);
+  }
+  else if (transport != "")
+  {
+    ERROR("Invalid value for \"transport\": " << transport);
+  }
 
-      // seek can be in format h:mm:ss.x or "xx.x h|min|s|ms" just in seconds
-      // decimals are optional
-      // multiple whitespace is allowed before and after.
+  // jump to a certain time
 
-      float time;
-      if (string2time(seek, time))
-      {
-        _controller.transport_locate(time);
-      }
-      else if (seek != "")
-      {
-        ERROR("Couldn't get the time out of the \"seek\" attribute (\""
-            << seek << "\").");
-      }
+  std::string seek = _xml.attribute("seek").str();
 
-      // reset tracker
+  // seek can be in format h:mm:ss.x or "xx.x h|min|s|ms" just in seconds
+  // decimals are optional
+  // multiple whitespace is allowed before and after.
 
-      std::string tracker = i.get_attribute("tracker");
-      if (tracker == "reset")
-      {
-        _controller.calibrate_client();
-      }
-      else if (tracker != "")
-      {
-        ERROR("Invalid value for \"tracker\": " << tracker);
-      }
+  float time;
+  if (string2time(seek, time))
+  {
+    _controller.transport_locate(time);
+  }
+  else if (seek != "")
+  {
+    ERROR("Couldn't get the time out of the \"seek\" attribute (\""
+        << seek << "\").");
+  }
+
+  // reset tracker
+
+  std::string tracker = _xml.attribute("tracker").str();
+  if (tracker == "reset")
+  {
+    _controller.calibrate_client();
+  }
+  else if (tracker != "")
+  {
+    ERROR("Invalid value for \"tracker\": " << tracker);
+  }
+  return _skip();
+}
+
+/** Change the level subscription of the client.
+ * Attributes which are not given keep their current value.
+ * - @c sources: "all", "none" or a list of source IDs
+ * - @c master: send master level
+ * - @c outputs: send per-loudspeaker output levels
+ * - @c threshold: minimum change (in dB) before a level is sent again
+ **/
+bool
+ssr::CommandParser::_parse_levels()
+{
+  if (!_subscriber) return _skip();
+
+  LevelSubscription subscription = _subscriber->level_subscription();
+
+  std::string sources = _xml.attribute("sources").str();
+  if (sources == "all")
+  {
+    subscription.all_sources = true;
+    subscription.sources.clear();
+  }
+  else if (sources != "")
+  {
+    std::set<id_t> ids;
+    std::istringstream iss(sources);
+    id_t id;
+    while (iss >> id) ids.insert(id);
+    if (sources == "none" || (iss.eof() && !ids.empty()))
+    {
+      subscription.all_sources = false;
+      subscription.sources.swap(ids);
     }
+    else ERROR("Invalid source IDs for levels: \"" << sources << "\"");
   }
+
+  bool flag;
+  auto master_attr = _xml.attribute("master");
+  if (master_attr.get(flag)) subscription.master = flag;
+  else if (!master_attr.empty()) ERROR("Invalid value for \"master\"!");
+
+  auto outputs_attr = _xml.attribute("outputs");
+  if (outputs_attr.get(flag)) subscription.outputs = flag;
+  else if (!outputs_attr.empty()) ERROR("Invalid value for \"outputs\"!");
+
+  float threshold;
+  auto threshold_attr = _xml.attribute("threshold");
+  if (threshold_attr.get(threshold) && threshold >= 0.0f)
+  {
+    subscription.threshold = threshold;
+  }
+  else if (!threshold_attr.empty())
+  {
+    ERROR("Invalid level threshold! (\"" << threshold_attr.str() << "\")");
+  }
+
+  _subscriber->subscribe_levels(subscription);
+  VERBOSE2("changed level subscription");
+  return _skip();
 }
 
 #if 0
@@ -35,7 +35,10 @@
 #include <string>
 
 #include "ssr_global.h"
-#include "xmlparser.h"
+#include "xmlpullparser.h"
+#include "levelsubscription.h"
+
+struct Position;
 
 namespace ssr
 {
@@ -46,17 +49,34 @@ struct Publisher;
  * This class is the bridge between the network interface and the Controller.
  * Incoming XML messages (in ASDF-format) are parsed and the appropriate 
  * functions of Controller called.  
+ * Elements are dispatched while they are parsed, no document tree is built.
  **/
 class CommandParser
 {
   public:
-    CommandParser(Publisher& controller);
+    CommandParser(Publisher& controller
+        , LevelSubscriber* subscriber = nullptr);
     ~CommandParser();
 
-    void parse_cmd(std::string &cmd);
+    void parse_cmd(const char* first, const char* last);
     //void parse_cmd_old(std::string &cmd)
   private:
+    template<typename F> bool _for_each_child(F f);
+    bool _skip();
+    bool _syntax_error();
+    bool _get_position(Position& position);
+    bool _parse_source();
+    bool _parse_reference(bool offset);
+    bool _parse_delete();
+    bool _parse_scene();
+    bool _parse_state();
+    bool _parse_levels();
+
     Publisher& _controller;
+    /// Receives level subscriptions of the client, may be @c nullptr
+    LevelSubscriber* _subscriber;
+    /// Re-used for all messages to avoid allocations
+    XmlPullParser _xml;
     //Subscriber& _scene;
 };
 
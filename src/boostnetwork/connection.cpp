@@ -27,20 +27,32 @@
 /// @file
 /// Connection class (implementation). 
 
+#include <algorithm>  // for std::find(), std::equal()
+#include <cstring>  // for std::strlen()
 #include <boost/bind.hpp>
 
 #include "connection.h"
+#include "binaryprotocol.h"
 #include "publisher.h"
 
 /// ctor
 ssr::Connection::Connection(boost::asio::io_service &io_service
-    , Publisher &controller)
+    , Publisher &controller, int update_interval)
   : _socket(io_service)
   , _timer(io_service)
+  , _flush_timer(io_service)
+  , _strand(io_service)
+  , _update_interval(update_interval)
+  , _queued_bytes(0)
+  , _flush_scheduled(false)
+  , _writing(false)
+  , _closed(false)
   , _controller(controller)
   , _subscriber(*this)
-  , _commandparser(controller)
+  , _commandparser(controller, &_subscriber)
+  , _binarycommandparser(controller, _commandparser)
   , _is_subscribed(false)
+  , _binary(false)
 {}
 
 /// dtor
@@ -53,23 +65,33 @@ ssr::Connection::~Connection()
 /** Get an instance of Connection.
  * @param io_service 
  * @param controller used to (un)subscribe and get the actual Scene
+ * @param update_interval milliseconds between two writes to the socket
  * @return ptr to Connection
  **/
 ssr::Connection::pointer
 ssr::Connection::create(boost::asio::io_service &io_service
-    , Publisher& controller)
+    , Publisher& controller, int update_interval)
 {
-  return pointer(new Connection(io_service, controller));
+  return pointer(new Connection(io_service, controller, update_interval));
 }
 
 /** Start the connection.
+ * Like all other handlers, this runs in the strand of the Connection.
+ **/
+void
+ssr::Connection::start()
+{
+  _strand.dispatch(boost::bind(&Connection::open, shared_from_this()));
+}
+
+/** Open the connection.
  * - Subscribe this instance of Connection to the Controller.
  * - Send the actual scene over the network.
  * - Start reading incoming messages.
  * - Initialize the timer.
  **/
 void
-ssr::Connection::start()
+ssr::Connection::open()
 {
   // ok... this Connection object is activated.
   // now we can connect the NetworkSubscriber.
@@ -86,8 +108,8 @@ ssr::Connection::start()
 
   // intialize the timer
   _timer.expires_from_now(boost::posix_time::milliseconds(100));
-  _timer.async_wait(boost::bind(&Connection::timeout_handler, shared_from_this()
-        , boost::asio::placeholders::error));
+  _timer.async_wait(_strand.wrap(boost::bind(&Connection::timeout_handler
+          , shared_from_this(), boost::asio::placeholders::error)));
 }
 
 /** Send levels on timeout.
@@ -99,14 +121,14 @@ ssr::Connection::start()
 void
 ssr::Connection::timeout_handler(const boost::system::error_code &e)
 {
-  if (e) return;
+  if (e || !_socket.is_open()) return;
 
   _subscriber.send_levels();
 
   // Set timer again.
   _timer.expires_from_now(boost::posix_time::milliseconds(100));
-  _timer.async_wait(boost::bind(&Connection::timeout_handler, shared_from_this()
-        , boost::asio::placeholders::error));
+  _timer.async_wait(_strand.wrap(boost::bind(&Connection::timeout_handler
+          , shared_from_this(), boost::asio::placeholders::error)));
 }
 
 /// Start reading from socket. 
@@ -114,72 +136,361 @@ void
 ssr::Connection::start_read()
 {
   async_read_until(_socket, _streambuf, '\0'
-      , boost::bind(&Connection::read_handler, shared_from_this()
+      , _strand.wrap(boost::bind(&Connection::read_handler, shared_from_this()
         , boost::asio::placeholders::error
-        , boost::asio::placeholders::bytes_transferred));
+        , boost::asio::placeholders::bytes_transferred)));
 }
 
-/// Forward string from socket to CommandParser.
+/** Forward strings from socket to CommandParser.
+ * All complete messages in the buffer are parsed in place.
+ * If a message is the handshake of the binary protocol, it is answered and
+ * the connection is switched to binary frames in both directions.
+ **/
 void
 ssr::Connection::read_handler(const boost::system::error_code &error
     , size_t size)
 {
-  if (!error)
+  (void) size;
+  // the socket is closed by stop(), data which was already received is dropped
+  if (error || !_socket.is_open())
+  {
+    this->stop();
+    return;
+  }
+
+  auto data = _streambuf.data();
+  auto begin = boost::asio::buffer_cast<const char*>(data);
+  auto end = begin + boost::asio::buffer_size(data);
+  auto first = begin;
+
+  for (;;)
+  {
+    auto last = std::find(first, end, '\0');
+    if (last == end) break;
+
+    auto handshake = binaryprotocol::handshake();
+    if (size_t(last - first) == std::strlen(handshake)
+        && std::equal(first, last, handshake))
+    {
+      std::string answer(first, last);
+      _streambuf.consume(size_t(last + 1 - begin));
+      this->switch_to_binary(answer);
+      this->start_binary_read();
+      return;
+    }
+
+    _commandparser.parse_cmd(first, last);
+    first = last + 1;
+  }
+  _streambuf.consume(size_t(first - begin));
+
+  this->start_read();
+}
+
+/** Parse all complete binary frames and read (at least) the rest of the next
+ * frame from the socket.
+ **/
+void
+ssr::Connection::start_binary_read()
+{
+  auto data = _streambuf.data();
+  auto first = boost::asio::buffer_cast<const char*>(data);
+  auto begin = first;
+  size_t missing = _binarycommandparser.parse(first
+      , first + boost::asio::buffer_size(data));
+  _streambuf.consume(size_t(first - begin));
+
+  if (missing == 0)
   {
-    std::istream input_stream(&_streambuf);
-    std::string  packet_string;
-    getline(input_stream, packet_string, '\0');
-    (void) size;
-    //cout << "size= " << size << endl;
-    //cout << "line: " << packet_string << endl;
+    this->stop();  // protocol error
+    return;
+  }
 
-    _commandparser.parse_cmd(packet_string);
+  boost::asio::async_read(_socket, _streambuf
+      , boost::asio::transfer_at_least(missing)
+      , _strand.wrap(boost::bind(&Connection::binary_read_handler
+        , shared_from_this(), boost::asio::placeholders::error
+        , boost::asio::placeholders::bytes_transferred)));
+}
 
-    this->start_read();
+/// Forward binary frames from socket to BinaryCommandParser.
+void
+ssr::Connection::binary_read_handler(const boost::system::error_code &error
+    , size_t size)
+{
+  (void) size;
+  if (!error && _socket.is_open())
+  {
+    this->start_binary_read();
   }
   else
   {
-    _timer.cancel();
+    this->stop();
+  }
+}
+
+/** Answer the handshake and switch to the binary protocol.
+ * Property updates which are still waiting are sent before the answer, all
+ * later messages are binary frames.
+ * @param answer handshake string
+ **/
+void
+ssr::Connection::switch_to_binary(std::string &answer)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto& entry: _latest)
+  {
+    _queued_bytes += entry.second.size();
+    _queue.emplace_back();
+    _queue.back().swap(entry.second);
+  }
+  _latest.clear();
+  answer += '\0';
+  _queued_bytes += answer.size();
+  _queue.emplace_back();
+  _queue.back().swap(answer);
+  _binary = true;
+  this->schedule_flush();
+}
+
+/** Unsubscribe from the Controller, cancel timers and close the socket.
+ * Pending reads and writes are aborted, the Connection is destroyed when the
+ * last handler has finished.  Calling this more than once doesn't harm.
+ **/
+void
+ssr::Connection::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _queue.clear();
+    _latest.clear();
+  }
+  if (_is_subscribed)
+  {
+    _controller.unsubscribe(&_subscriber);
+    _is_subscribed = false;
+  }
+  _timer.cancel();
+  _flush_timer.cancel();
+
+  boost::system::error_code ignored;
+  _socket.shutdown(socket_t::shutdown_both, ignored);
+  _socket.close(ignored);
+}
+
+/** Convert a string to a message in the current protocol.
+ * This must be called with the lock held.
+ * @param writestring XML string
+ * @param[out] message zero-terminated string or @c xml frame
+ **/
+void
+ssr::Connection::wire(std::string &writestring, std::string &message) const
+{
+  if (_binary)
+  {
+    binaryprotocol::Writer writer(binaryprotocol::xml, writestring.size());
+    writer << writestring;
+    message.swap(writer.frame());
+  }
+  else
+  {
+    message.assign(writestring);
+    message += '\0';
   }
 }
 
 /** Write to socket.
+ * The string is sent in order with all other written strings.
+ * In binary mode, it is sent as @c xml frame.
  * @param writestring: String to be send over the network. 
  **/
 void
 ssr::Connection::write(std::string &writestring)
 {
-  // Create a Copy of this string.
-  // Put into shared_ptr bound to the callback
-  // handler. This is sufficient to make it
-  // be destroyed on exit.
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::string message;
+  this->wire(writestring, message);
+  this->enqueue(message);
+}
 
-  boost::shared_ptr<std::string> str_ptr(new std::string(writestring + '\0'));
+/** Write a frame of the binary protocol to socket.
+ * @param frame: Complete frame (including header), it is moved from.
+ **/
+void
+ssr::Connection::write_frame(std::string &frame)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  this->enqueue(frame);
+}
+
+/** Send the value of a property.
+ * If a value of the same property (and id) is still waiting, it is replaced.
+ * Values are sent after the strings passed to write().
+ * @param property the type of the value
+ * @param id source id (or 0)
+ * @param writestring: XML string (see write())
+ **/
+void
+ssr::Connection::update(property_t property, id_t id
+    , std::string &writestring)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_closed) return;
+  this->wire(writestring, _latest[key_t(property, id)]);
+  this->schedule_flush();
+}
+
+/// Like update(), but with a frame of the binary protocol.
+void
+ssr::Connection::update_frame(property_t property, id_t id
+    , std::string &frame)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_closed) return;
+  _latest[key_t(property, id)].swap(frame);
+  this->schedule_flush();
+}
+
+/** Drop waiting property values of a source.
+ * @param id source id, 0 means all sources
+ **/
+void
+ssr::Connection::forget_source(id_t id)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto entry = _latest.begin(); entry != _latest.end(); )
+  {
+    if (entry->first.first < reference_position
+        && (id == 0 || entry->first.second == id))
+    {
+      entry = _latest.erase(entry);
+    }
+    else
+    {
+      ++entry;
+    }
+  }
+}
+
+/// Append to the ordered queue, this must be called with the lock held.
+void
+ssr::Connection::enqueue(std::string &message)
+{
+  if (_closed) return;
+
+  _queued_bytes += message.size();
+  _queue.emplace_back();
+  _queue.back().swap(message);
+
+  if (_queued_bytes > _max_queued_bytes)
+  {
+    ERROR("Network client doesn't read its messages, dropping it!");
+    _closed = true;
+    _queue.clear();
+    _latest.clear();
+    _strand.post(boost::bind(&Connection::stop, shared_from_this()));
+    return;
+  }
+  this->schedule_flush();
+}
+
+/// Request a flush, this must be called with the lock held.
+void
+ssr::Connection::schedule_flush()
+{
+  if (_flush_scheduled || _writing || _closed) return;
+  _flush_scheduled = true;
+  // Timers and the socket must only be used within the strand
+  _strand.post(boost::bind(&Connection::start_flush_timer
+        , shared_from_this()));
+}
 
-  boost::asio::async_write(_socket, boost::asio::buffer(*str_ptr)
-      , boost::bind(&Connection::write_handler, shared_from_this(), str_ptr
+void
+ssr::Connection::start_flush_timer()
+{
+  if (_update_interval > 0)
+  {
+    _flush_timer.expires_from_now(
+        boost::posix_time::milliseconds(_update_interval));
+    _flush_timer.async_wait(_strand.wrap(boost::bind(&Connection::flush_handler
+          , shared_from_this(), boost::asio::placeholders::error)));
+  }
+  else
+  {
+    this->flush();
+  }
+}
+
+void
+ssr::Connection::flush_handler(const boost::system::error_code &error)
+{
+  if (error)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _flush_scheduled = false;
+    return;
+  }
+  this->flush();
+}
+
+/// Send all queued messages and property values with one gather-write.
+void
+ssr::Connection::flush()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _flush_scheduled = false;
+  if (_writing || _closed) return;
+
+  _outgoing.clear();
+  for (auto& message: _queue)
+  {
+    _outgoing.emplace_back();
+    _outgoing.back().swap(message);
+  }
+  _queue.clear();
+  _queued_bytes = 0;
+  for (auto& entry: _latest)
+  {
+    _outgoing.emplace_back();
+    _outgoing.back().swap(entry.second);
+  }
+  _latest.clear();
+
+  if (_outgoing.empty()) return;
+
+  _buffers.clear();
+  for (const auto& message: _outgoing)
+  {
+    _buffers.push_back(boost::asio::buffer(message));
+  }
+  _writing = true;
+  boost::asio::async_write(_socket, _buffers
+      , _strand.wrap(boost::bind(&Connection::write_handler, shared_from_this()
         , boost::asio::placeholders::error
-        , boost::asio::placeholders::bytes_transferred));
+        , boost::asio::placeholders::bytes_transferred)));
 }
 
-/** Empty callback handler.  
- *
- * @param str_ptr String passed to Connection::write 
+/** Callback handler of flush().
+ * Everything which was queued in the meantime is sent with the next flush.
  * @param error error code
  * @param bytes_transferred self explanatory 
- *
- * @todo Check if we can delete this function.
  **/
 void
-ssr::Connection::write_handler(boost::shared_ptr<std::string> str_ptr
-    , const boost::system::error_code &error, size_t bytes_transferred)
+ssr::Connection::write_handler(const boost::system::error_code &error
+    , size_t bytes_transferred)
 {
-  (void) str_ptr;
-  (void) error;
   (void) bytes_transferred;
-  // Dont do nothing. we could check for error and stuff.
-  // the shared_ptr was just used to keep the string alive and
-  // destroy it now.
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _writing = false;
+    if (!error)
+    {
+      if (!_queue.empty() || !_latest.empty()) this->schedule_flush();
+      return;
+    }
+  }
+  this->stop();
 }
 
 // Settings for Vim (http://www.vim.org/), please do not remove:
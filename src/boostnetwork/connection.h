@@ -34,19 +34,34 @@
 #include <config.h> // for ENABLE_*
 #endif
 
+#include <atomic>
 #include <boost/asio.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <deque>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
 
 #include "networksubscriber.h"
 #include "commandparser.h"
+#include "binarycommandparser.h"
 
 namespace ssr
 {
 
 struct Publisher;
 
-/// Connection class.
+/** Connection class.
+ * Outgoing messages are queued and sent with one gather-write per update
+ * interval. Only one write is in flight at a time, while it is pending,
+ * further updates of the same property replace each other
+ * (see update()). Slow clients therefore only miss intermediate values.
+ * All handlers run in the strand of the Connection, so messages of one client
+ * are handled in order, while other clients are served by other threads.
+ * The Controller is accessed via the SynchronizedPublisher of the Server,
+ * only the calls to it are serialized across connections.
+ **/
 class Connection : public boost::enable_shared_from_this<Connection>
 {
   public:
@@ -54,11 +69,36 @@ class Connection : public boost::enable_shared_from_this<Connection>
     typedef boost::shared_ptr<Connection> pointer;
     typedef boost::asio::ip::tcp::socket socket_t;
 
+    /// Properties of which only the latest value is sent, see update()
+    enum property_t
+    {
+      source_position,
+      source_orientation,
+      source_gain,
+      source_mute,
+      source_output_levels,
+      source_level,
+      // all source properties have to be listed above
+      reference_position,
+      reference_orientation,
+      reference_offset_position,
+      reference_offset_orientation,
+      master_volume,
+      master_level
+    };
+
     static pointer create(boost::asio::io_service &io_service
-        , Publisher &controller);
+        , Publisher &controller, int update_interval);
 
     void start();
     void write(std::string &writestring);
+    void write_frame(std::string &frame);
+    void update(property_t property, id_t id, std::string &writestring);
+    void update_frame(property_t property, id_t id, std::string &frame);
+    void forget_source(id_t id);
+
+    /// @return @b true if the client switched to the binary protocol
+    bool binary() const { return _binary; }
 
     /// @return Reference to socket
     socket_t& socket() { return _socket; }
@@ -66,21 +106,60 @@ class Connection : public boost::enable_shared_from_this<Connection>
     ~Connection();
 
   private:
-    Connection(boost::asio::io_service &io_service, Publisher &controller);
+    Connection(boost::asio::io_service &io_service, Publisher &controller
+        , int update_interval);
 
+    void open();
     void start_read();
     void read_handler(const boost::system::error_code &error, size_t size);
-    void write_handler(boost::shared_ptr<std::string> str_ptr
-        , const boost::system::error_code &error, size_t bytes_transferred);
+    void start_binary_read();
+    void binary_read_handler(const boost::system::error_code &error
+        , size_t size);
+    void switch_to_binary(std::string &answer);
+    void stop();
+
+    void wire(std::string &writestring, std::string &message) const;
+    void enqueue(std::string &message);
+    void schedule_flush();
+    void start_flush_timer();
+    void flush_handler(const boost::system::error_code &error);
+    void flush();
+    void write_handler(const boost::system::error_code &error
+        , size_t bytes_transferred);
 
     void timeout_handler(const boost::system::error_code &e);
 
+    typedef std::pair<int, id_t> key_t;
+
+    /// A client is dropped if this many bytes are waiting in the queue
+    static const size_t _max_queued_bytes = 16 * 1024 * 1024;
+
     /// TCP/IP socket
     socket_t _socket;
     /// Buffer for incoming messages.  
     boost::asio::streambuf _streambuf;
     /// @see Connection::timeout_handler
     boost::asio::deadline_timer _timer;
+    /// @see Connection::start_flush_timer
+    boost::asio::deadline_timer _flush_timer;
+    /// Serializes all handlers, the io_service is run by several threads
+    boost::asio::io_service::strand _strand;
+    /// Milliseconds between two writes, 0 means as soon as possible
+    int _update_interval;
+
+    /// Protects the members below, they are accessed by the NetworkSubscriber
+    std::mutex _mutex;
+    /// Messages which are sent in order
+    std::deque<std::string> _queue;
+    size_t _queued_bytes;
+    /// Latest values of properties, sent after the queued messages
+    std::map<key_t, std::string> _latest;
+    /// Messages of the current write, buffers point into them
+    std::vector<std::string> _outgoing;
+    std::vector<boost::asio::const_buffer> _buffers;
+    bool _flush_scheduled;
+    bool _writing;
+    bool _closed;
 
     /// Reference to Controller
     Publisher &_controller;
@@ -88,8 +167,12 @@ class Connection : public boost::enable_shared_from_this<Connection>
     NetworkSubscriber _subscriber;
     /// Commandparser obj 
     CommandParser _commandparser;
+    /// Parser for the binary protocol, see binaryprotocol.h
+    BinaryCommandParser _binarycommandparser;
 
     bool _is_subscribed;
+    /// Written within the strand, read by the NetworkSubscriber
+    std::atomic<bool> _binary;
 };
 
 }  // namespace ssr
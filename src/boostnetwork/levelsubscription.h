@@ -0,0 +1,77 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// Level subscription of a network client (definition).
+
+#ifndef SSR_LEVELSUBSCRIPTION_H
+#define SSR_LEVELSUBSCRIPTION_H
+
+#include <set>
+
+#include "ssr_global.h"  // for id_t
+
+namespace ssr
+{
+
+/// Which signal levels a client wants to receive, see NetworkSubscriber
+struct LevelSubscription
+{
+  LevelSubscription()
+    : all_sources(true)
+    , master(false)
+    , outputs(true)
+    , threshold(1.0f)
+  {}
+
+  bool all_sources;  ///< if @b false, only the levels of @c sources are sent
+  std::set<id_t> sources;
+  bool master;  ///< master level
+  bool outputs;  ///< per-loudspeaker output levels of the sources
+  float threshold;  ///< minimum change (in dB) before a level is sent again
+};
+
+/** Abstract interface to the level subscription of a client.
+ * It is implemented by the NetworkSubscriber and changed by the
+ * CommandParser, which therefore doesn't depend on the network connection.
+ **/
+struct LevelSubscriber
+{
+  virtual ~LevelSubscriber() {}
+
+  /// @return current subscription
+  virtual LevelSubscription level_subscription() = 0;
+  /// Replace the subscription
+  virtual void subscribe_levels(const LevelSubscription& subscription) = 0;
+};
+
+}  // namespace ssr
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -27,12 +27,38 @@
 /// @file
 /// NetworkSubscriber class (implementation). 
 
+#include <algorithm>  // for std::max()
+#include <cmath>  // for std::abs()
+#include <limits>
+
 #include "networksubscriber.h"
 #include "apf/stringtools.h"
 #include "apf/math.h" // for linear2dB()
 #include "connection.h"
+#include "binaryprotocol.h"
 
 using apf::str::A2S;
+namespace bin = ssr::binaryprotocol;
+
+namespace
+{
+
+/// Lower levels (in dB) are treated as silence
+const float level_floor = -100.0f;
+
+/// "Sent" level of values which have not been sent yet
+const float not_sent = std::numeric_limits<float>::infinity();
+
+/// Attributes of a @c position element, @c z is only sent if non-zero
+std::string position_attributes(const Position& position)
+{
+  std::string result = "x='" + A2S(position.x) + "' y='" + A2S(position.y)
+    + "'";
+  if (position.z != 0) result += " z='" + A2S(position.z) + "'";
+  return result;
+}
+
+}
 
 // temporary hack:
 //static bool previous_state = false;
@@ -40,6 +66,7 @@ using apf::str::A2S;
 ssr::NetworkSubscriber::NetworkSubscriber(Connection &connection)
   : _connection(connection)
   , _master_level(0.0)
+  , _sent_master_level(not_sent)
 {}
 
 ssr::NetworkSubscriber::~NetworkSubscriber() {}
@@ -50,18 +77,97 @@ ssr::NetworkSubscriber::update_all_clients(std::string str)
   _connection.write(str);
 }
 
+/** Send the subscribed signal levels which changed since they were last sent.
+ * Each level is sent separately, so that a pending level of one source is
+ * only replaced by a newer level of the same source (see Connection::update()).
+ **/
 void
 ssr::NetworkSubscriber::send_levels()
 {
-  source_level_map_t::iterator i;
-  std::string ms = "<update>";
-  for (i=_source_levels.begin(); i!=_source_levels.end(); i++)
+  std::lock_guard<std::mutex> lock(_level_mutex);
+
+  if (_level_subscription.master
+      && _level_changed(_master_level, _sent_master_level))
   {
-    ms += ("<source id='" + A2S((*i).first) + "' level='"
-        + A2S(apf::math::linear2dB((*i).second)) + "'/>");
+    if (_connection.binary())
+    {
+      bin::Writer writer(bin::master_level);
+      writer << _master_level;
+      _connection.update_frame(Connection::master_level, 0, writer.frame());
+    }
+    else
+    {
+      std::string ms = "<update><master level='"
+        + A2S(_sent_master_level) + "'/></update>";
+      _connection.update(Connection::master_level, 0, ms);
+    }
   }
-  ms += "</update>";
-  update_all_clients(ms);
+
+  for (const auto& level: _source_levels)
+  {
+    if (!_wants_levels_of(level.first)) continue;
+
+    auto sent = _sent_source_levels.emplace(level.first, not_sent).first;
+    if (!_level_changed(level.second, sent->second)) continue;
+
+    if (_connection.binary())
+    {
+      bin::Writer writer(bin::source_level);
+      writer << uint32_t(level.first) << level.second;
+      _connection.update_frame(Connection::source_level, level.first
+          , writer.frame());
+    }
+    else
+    {
+      std::string ms = "<update><source id='" + A2S(level.first)
+        + "' level='" + A2S(sent->second) + "'/></update>";
+      _connection.update(Connection::source_level, level.first, ms);
+    }
+  }
+}
+
+/** Change the level subscription of the client.
+ * All subscribed levels are sent again with the next send_levels().
+ **/
+void
+ssr::NetworkSubscriber::subscribe_levels(
+    const LevelSubscription& subscription)
+{
+  std::lock_guard<std::mutex> lock(_level_mutex);
+  _level_subscription = subscription;
+  _sent_source_levels.clear();
+  _sent_output_levels.clear();
+  _sent_master_level = not_sent;
+}
+
+ssr::LevelSubscription
+ssr::NetworkSubscriber::level_subscription()
+{
+  std::lock_guard<std::mutex> lock(_level_mutex);
+  return _level_subscription;
+}
+
+/** Check if a level changed by more than the threshold since it was sent.
+ * @param level current level (linear)
+ * @param sent last sent level (in dB), updated if @b true is returned
+ **/
+bool
+ssr::NetworkSubscriber::_level_changed(float level, float& sent) const
+{
+  float level_dB = std::max(apf::math::linear2dB(level), level_floor);
+  if (std::abs(level_dB - sent) > _level_subscription.threshold)
+  {
+    sent = level_dB;
+    return true;
+  }
+  return false;
+}
+
+bool
+ssr::NetworkSubscriber::_wants_levels_of(id_t id) const
+{
+  return _level_subscription.all_sources
+    || _level_subscription.sources.count(id);
 }
 
 // Subscriber interface
@@ -84,7 +190,13 @@ ssr::NetworkSubscriber::new_source(id_t id)
 void
 ssr::NetworkSubscriber::delete_source(id_t id)
 {
-  _source_levels.erase(id);
+  {
+    std::lock_guard<std::mutex> lock(_level_mutex);
+    _source_levels.erase(id);
+    _sent_source_levels.erase(id);
+    _sent_output_levels.erase(id);
+  }
+  _connection.forget_source(id);
   std::string ms = "<update><delete><source id='" + A2S(id) + "' />" +
     + "</delete></update>";
   update_all_clients(ms);
@@ -93,7 +205,13 @@ ssr::NetworkSubscriber::delete_source(id_t id)
 void
 ssr::NetworkSubscriber::delete_all_sources()
 {
-  _source_levels.clear();
+  {
+    std::lock_guard<std::mutex> lock(_level_mutex);
+    _source_levels.clear();
+    _sent_source_levels.clear();
+    _sent_output_levels.clear();
+  }
+  _connection.forget_source(0);
   std::string ms = "<update><delete><source id='0'/></delete></update>";
   update_all_clients(ms);
 }
@@ -101,9 +219,17 @@ ssr::NetworkSubscriber::delete_all_sources()
 bool
 ssr::NetworkSubscriber::set_source_position(id_t id, const Position& position)
 {
-  std::string ms = "<update><source id='" + A2S(id) + "'><position x='"
-    + A2S(position.x) + "' y='" + A2S(position.y) + "'/></source></update>";
-  update_all_clients(ms);
+  if (_connection.binary())
+  {
+    bin::Writer writer(bin::source_position);
+    writer << uint32_t(id) << position.x << position.y;
+    if (position.z != 0) writer << position.z;
+    _connection.update_frame(Connection::source_position, id, writer.frame());
+    return true;
+  }
+  std::string ms = "<update><source id='" + A2S(id) + "'><position "
+    + position_attributes(position) + "/></source></update>";
+  _connection.update(Connection::source_position, id, ms);
   return true;
 }
 
@@ -120,27 +246,49 @@ bool
 ssr::NetworkSubscriber::set_source_orientation(id_t id
     , const Orientation& orientation)
 {
+  if (_connection.binary())
+  {
+    bin::Writer writer(bin::source_orientation);
+    writer << uint32_t(id) << orientation.azimuth;
+    _connection.update_frame(Connection::source_orientation, id
+        , writer.frame());
+    return true;
+  }
   std::string ms = "<update><source id='" + A2S(id) + "'><orientation azimuth='"
     + A2S(orientation.azimuth) + "'/></source></update>";
-  update_all_clients(ms);
+  _connection.update(Connection::source_orientation, id, ms);
   return true;
 }
 
 bool
 ssr::NetworkSubscriber::set_source_gain(id_t id, const float& gain)
 {
+  if (_connection.binary())
+  {
+    bin::Writer writer(bin::source_gain);
+    writer << uint32_t(id) << gain;
+    _connection.update_frame(Connection::source_gain, id, writer.frame());
+    return true;
+  }
   std::string ms = "<update><source id='"
     + A2S(id) + "' volume='" + A2S(apf::math::linear2dB(gain)) + "'/></update>";
-  update_all_clients(ms);
+  _connection.update(Connection::source_gain, id, ms);
   return true;
 }
 
 bool
 ssr::NetworkSubscriber::set_source_mute(id_t id, const bool& mute)
 {
+  if (_connection.binary())
+  {
+    bin::Writer writer(bin::source_mute);
+    writer << uint32_t(id) << mute;
+    _connection.update_frame(Connection::source_mute, id, writer.frame());
+    return true;
+  }
   std::string ms = "<update><source id='" + A2S(id) + "' mute='" + A2S(mute)
     + "'/></update>";
-  update_all_clients(ms);
+  _connection.update(Connection::source_mute, id, ms);
   return true;
 }
 
@@ -233,25 +381,41 @@ ssr::NetworkSubscriber::set_source_file_length(id_t id, const long int& length)
 void
 ssr::NetworkSubscriber::set_reference_position(const Position& position)
 {
-  std::string ms = "<update><reference><position x='" + A2S(position.x)
-    + "' y='" + A2S(position.y) + "'/></reference></update>";
-  update_all_clients(ms);
+  if (_connection.binary())
+  {
+    bin::Writer writer(bin::reference_position);
+    writer << position.x << position.y;
+    if (position.z != 0) writer << position.z;
+    _connection.update_frame(Connection::reference_position, 0, writer.frame());
+    return;
+  }
+  std::string ms = "<update><reference><position "
+    + position_attributes(position) + "/></reference></update>";
+  _connection.update(Connection::reference_position, 0, ms);
 }
 
 void
 ssr::NetworkSubscriber::set_reference_orientation(const Orientation& orientation)
 {
+  if (_connection.binary())
+  {
+    bin::Writer writer(bin::reference_orientation);
+    writer << orientation.azimuth;
+    _connection.update_frame(Connection::reference_orientation, 0
+        , writer.frame());
+    return;
+  }
   std::string ms = "<update><reference><orientation azimuth='"
     + A2S(orientation.azimuth) + "'/></reference></update>";
-  update_all_clients(ms);
+  _connection.update(Connection::reference_orientation, 0, ms);
 }
 
 void
 ssr::NetworkSubscriber::set_reference_offset_position(const Position& position)
 {
-  std::string ms = "<update><reference_offset><position x='" + A2S(position.x)
-    + "' y='" + A2S(position.y) + "'/></reference_offset></update>";
-  update_all_clients(ms);
+  std::string ms = "<update><reference_offset><position "
+    + position_attributes(position) + "/></reference_offset></update>";
+  _connection.update(Connection::reference_offset_position, 0, ms);
 }
 
 void
@@ -259,20 +423,41 @@ ssr::NetworkSubscriber::set_reference_offset_orientation(const Orientation& orie
 {
   std::string ms = "<update><reference_offset><orientation azimuth='"
     + A2S(orientation.azimuth) + "'/></reference_offset></update>";
-  update_all_clients(ms);
+  _connection.update(Connection::reference_offset_orientation, 0, ms);
 }
 
 void
 ssr::NetworkSubscriber::set_master_volume(float volume)
 {
   std::string ms = "<update><scene volume='" + A2S(apf::math::linear2dB(volume))    + "'/></update>";
-  update_all_clients(ms);
+  _connection.update(Connection::master_volume, 0, ms);
 }
 
 void
 ssr::NetworkSubscriber::set_source_output_levels(id_t id, float* first
     , float* last)
 {
+  std::lock_guard<std::mutex> lock(_level_mutex);
+
+  if (!_level_subscription.outputs || !_wants_levels_of(id)) return;
+
+  auto& sent = _sent_output_levels[id];
+  sent.resize(std::distance(first, last), not_sent);
+
+  bool changed = false;
+  auto sent_level = sent.begin();
+  for (auto level = first; level != last; ++level, ++sent_level)
+  {
+    changed = _level_changed(*level, *sent_level) || changed;
+  }
+  if (!changed) return;
+  // all levels are sent, so all of them are stored
+  sent_level = sent.begin();
+  for (auto level = first; level != last; ++level, ++sent_level)
+  {
+    *sent_level = std::max(apf::math::linear2dB(*level), level_floor);
+  }
+
   std::string ms = "<update><source id='" + A2S(id) + "' output_level='";
 
   for ( ; first != last; ++first)
@@ -281,7 +466,7 @@ ssr::NetworkSubscriber::set_source_output_levels(id_t id, float* first
     ms += " ";
   }
   ms += "'/></update>";
-  update_all_clients(ms);
+  _connection.update(Connection::source_output_levels, id, ms);
 }
 
 void
@@ -327,6 +512,7 @@ ssr::NetworkSubscriber::set_sample_rate(int sr)
 void
 ssr::NetworkSubscriber::set_master_signal_level(float level)
 {
+  std::lock_guard<std::mutex> lock(_level_mutex);
   _master_level = level;
   //std::string ms = "<update><master level='" + A2S(level) +
   //  "'/></update>";
@@ -336,10 +522,8 @@ ssr::NetworkSubscriber::set_master_signal_level(float level)
 bool
 ssr::NetworkSubscriber::set_source_signal_level(const id_t id, const float& level)
 {
+  std::lock_guard<std::mutex> lock(_level_mutex);
   _source_levels[id] = level;
-  std::string ms = "<update><source id='" + A2S(id) + "' level='" + A2S(level)
-    + "'/></update>";
-  //update_all_clients(ms);
   return true;
 }
 
@@ -31,7 +31,11 @@
 #define SSR_NETWORKSUBSCRIBER_H
 
 #include "subscriber.h"
+#include "levelsubscription.h"
 #include <map>
+#include <mutex>
+#include <set>
+#include <vector>
 
 namespace ssr
 {
@@ -42,11 +46,18 @@ class Connection;
  * This Subscriber turns function calls to the Subscriber interface into 
  * strings (XML-messages in ASDF format) and sends it over a Connection to
  * connected clients.  
+ * If the client switched to the binary protocol, positions, orientations,
+ * gains, mute states and levels are sent as binary frames instead.
+ * Frequently changing values are passed to Connection::update(), only their
+ * latest value is sent.
+ * Signal levels are only sent for the subscribed sources (see
+ * subscribe_levels()) and only if they changed by more than the threshold
+ * since they were last sent.
  *
  * @todo There will be a set of flags, which can filter certain
  * events. But this will be done by deriving.
  **/
-class NetworkSubscriber : public Subscriber
+class NetworkSubscriber : public Subscriber, public LevelSubscriber
 {
   public:
     NetworkSubscriber(Connection &connection);
@@ -56,6 +67,8 @@ class NetworkSubscriber : public Subscriber
     //	only sends string to one connection.
     void update_all_clients(std::string str);
     void send_levels();
+    virtual void subscribe_levels(const LevelSubscription& subscription);
+    virtual LevelSubscription level_subscription();
 
     // Subscriber Interface
     virtual void set_loudspeakers(const Loudspeaker::container_t& loudspeakers);
@@ -93,11 +106,23 @@ class NetworkSubscriber : public Subscriber
     virtual bool set_source_signal_level(const id_t id, const float& level);
 
   private:
+    bool _level_changed(float level, float& sent) const;
+    bool _wants_levels_of(id_t id) const;
+
     Connection &_connection;
 
+    /// Protects the level members, they are used by the Controller and the
+    /// network thread
+    std::mutex                   _level_mutex;
+    LevelSubscription            _level_subscription;
+
     typedef std::map<id_t,float> source_level_map_t;
     source_level_map_t           _source_levels;
+    /// Last sent levels (in dB)
+    source_level_map_t           _sent_source_levels;
+    std::map<id_t, std::vector<float>> _sent_output_levels;
     float                        _master_level;
+    float                        _sent_master_level;
 };
 
 }  // namespace ssr
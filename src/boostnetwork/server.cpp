@@ -27,15 +27,19 @@
 /// @file
 /// Server class (implementation).
 
+#include <algorithm>  // for std::max()
+
 #include "server.h"
 #include <boost/bind.hpp>
 
-ssr::Server::Server(Publisher& controller, int port)
+ssr::Server::Server(Publisher& controller, int port, int update_interval
+    , int threads)
   : _controller(controller)
   , _io_service()
   , _acceptor(_io_service
       , boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port))
-  , _network_thread(0)
+  , _update_interval(update_interval)
+  , _threads(threads)
 {}
 
 ssr::Server::~Server()
@@ -47,7 +51,7 @@ void
 ssr::Server::start_accept()
 {
   Connection::pointer new_connection = Connection::create(_io_service
-      , _controller);
+      , _controller, _update_interval);
 
   _acceptor.async_accept(new_connection->socket()
       , boost::bind(&Server::handle_accept, this, new_connection
@@ -68,25 +72,35 @@ ssr::Server::handle_accept(Connection::pointer new_connection
 void
 ssr::Server::start()
 {
-  _network_thread = new boost::thread(boost::bind(&Server::run, this));
+  int threads = _threads;
+  if (threads <= 0)
+  {
+    threads = std::max(1u, boost::thread::hardware_concurrency());
+  }
+
+  start_accept();
+  for (int i = 0; i < threads; ++i)
+  {
+    _network_threads.create_thread(boost::bind(&Server::run, this));
+  }
+  VERBOSE2("Started " << threads << " network thread(s).");
 }
 
 void
 ssr::Server::stop()
 {
-  VERBOSE2("Stopping network thread ...");
-  if (_network_thread)
+  VERBOSE2("Stopping network threads ...");
+  if (_network_threads.size() > 0)
   {
     _io_service.stop();
-    _network_thread->join();
+    _network_threads.join_all();
   }
-  VERBOSE2("Network thread stopped.");
+  VERBOSE2("Network threads stopped.");
 }
 
 void
 ssr::Server::run()
 {
-  start_accept();
   _io_service.run();
 }
 
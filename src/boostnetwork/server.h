@@ -40,17 +40,23 @@
 #include <iostream>
 
 #include "connection.h"
+#include "synchronizedpublisher.h"
 
 namespace ssr
 {
 
 struct Publisher;
 
-/// Server class. 
+/** Server class.
+ * The io_service is run by a pool of threads, all handlers of a Connection
+ * are serialized by its strand. Calls to the Controller are serialized across
+ * all connections by a SynchronizedPublisher.
+ **/
 class Server
 {
   public:
-    Server(Publisher& controller, int port);
+    Server(Publisher& controller, int port, int update_interval
+        , int threads = 1);
     ~Server();
     void start();
     void stop();
@@ -61,10 +67,15 @@ class Server
     void handle_accept(Connection::pointer new_connection
         , const boost::system::error_code &error);
 
-    Publisher& _controller;
+    /// Wraps the Controller, which is not thread-safe
+    SynchronizedPublisher _controller;
     boost::asio::io_service _io_service;
     boost::asio::ip::tcp::acceptor _acceptor;
-    boost::thread *_network_thread;
+    boost::thread_group _network_threads;
+    /// Milliseconds between two writes to a client, see Connection
+    int _update_interval;
+    /// Number of threads running the io_service, 0: one per CPU core
+    int _threads;
 };
 
 }  // namespace ssr
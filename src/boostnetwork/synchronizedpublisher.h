@@ -0,0 +1,303 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// SynchronizedPublisher class (definition).
+
+#ifndef SSR_SYNCHRONIZEDPUBLISHER_H
+#define SSR_SYNCHRONIZEDPUBLISHER_H
+
+#include <mutex>
+
+#include "publisher.h"
+
+namespace ssr
+{
+
+/** Publisher which serializes all calls to another Publisher.
+ * The Controller is not thread-safe, but the Server calls it from several
+ * network threads.  Only the calls themselves are serialized, receiving and
+ * parsing of requests and sending of updates happen in parallel.
+ * @warning Subscribers of the wrapped Publisher must not call it (via this
+ *   class) from within their Subscriber functions.
+ **/
+class SynchronizedPublisher : public Publisher
+{
+  public:
+    explicit SynchronizedPublisher(Publisher& publisher)
+      : _publisher(publisher)
+    {}
+
+    virtual bool load_scene(const std::string& scene_file_name)
+    {
+      _lock_t lock(_mutex);
+      return _publisher.load_scene(scene_file_name);
+    }
+
+    virtual bool save_scene_as_XML(const std::string& filename) const
+    {
+      _lock_t lock(_mutex);
+      return _publisher.save_scene_as_XML(filename);
+    }
+
+    virtual void start_processing()
+    {
+      _lock_t lock(_mutex);
+      _publisher.start_processing();
+    }
+
+    virtual void stop_processing()
+    {
+      _lock_t lock(_mutex);
+      _publisher.stop_processing();
+    }
+
+    virtual void new_source(const std::string& name, Source::model_t model
+        , const std::string& file_or_port_name, int channel
+        , const Position& position, const bool pos_fix
+        , const Orientation& orientation, const bool or_fix
+        , const float gain, const bool mute_state
+        , const std::string& properties_file)
+    {
+      _lock_t lock(_mutex);
+      _publisher.new_source(name, model, file_or_port_name, channel, position
+          , pos_fix, orientation, or_fix, gain, mute_state, properties_file);
+    }
+
+    virtual void begin_transaction()
+    {
+      _lock_t lock(_mutex);
+      _publisher.begin_transaction();
+    }
+
+    virtual void end_transaction()
+    {
+      _lock_t lock(_mutex);
+      _publisher.end_transaction();
+    }
+
+    virtual void delete_source(id_t id)
+    {
+      _lock_t lock(_mutex);
+      _publisher.delete_source(id);
+    }
+
+    virtual void delete_all_sources()
+    {
+      _lock_t lock(_mutex);
+      _publisher.delete_all_sources();
+    }
+
+    virtual void set_source_position(id_t id, const Position& position)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_position(id, position);
+    }
+
+    virtual void set_source_orientation(id_t id
+        , const Orientation& orientation)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_orientation(id, orientation);
+    }
+
+    virtual void set_source_gain(id_t id, float gain)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_gain(id, gain);
+    }
+
+    virtual void set_source_mute(id_t id, bool mute)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_mute(id, mute);
+    }
+
+    virtual void set_source_signal_level(const id_t id, const float level)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_signal_level(id, level);
+    }
+
+    virtual void set_source_name(id_t id, const std::string& name)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_name(id, name);
+    }
+
+    virtual void set_source_properties_file(id_t id, const std::string& name)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_properties_file(id, name);
+    }
+
+    virtual void set_source_model(id_t id, Source::model_t model)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_model(id, model);
+    }
+
+    virtual void set_source_port_name(id_t id, const std::string& port_name)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_port_name(id, port_name);
+    }
+
+    virtual void set_source_position_fixed(id_t id, const bool fix)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_source_position_fixed(id, fix);
+    }
+
+    virtual void set_reference_position(const Position& position)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_reference_position(position);
+    }
+
+    virtual void set_reference_orientation(const Orientation& orientation)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_reference_orientation(orientation);
+    }
+
+    virtual void set_reference_offset_position(const Position& position)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_reference_offset_position(position);
+    }
+
+    virtual void set_reference_offset_orientation(
+        const Orientation& orientation)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_reference_offset_orientation(orientation);
+    }
+
+    virtual void set_master_volume(float volume)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_master_volume(volume);
+    }
+
+    virtual void set_amplitude_reference_distance(float distance)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_amplitude_reference_distance(distance);
+    }
+
+    virtual void set_master_signal_level(float level)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_master_signal_level(level);
+    }
+
+    virtual void set_cpu_load(const float load)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_cpu_load(load);
+    }
+
+    virtual void publish_sample_rate(const int sample_rate)
+    {
+      _lock_t lock(_mutex);
+      _publisher.publish_sample_rate(sample_rate);
+    }
+
+    virtual std::string get_renderer_name() const
+    {
+      _lock_t lock(_mutex);
+      return _publisher.get_renderer_name();
+    }
+
+    virtual bool show_head() const
+    {
+      _lock_t lock(_mutex);
+      return _publisher.show_head();
+    }
+
+    virtual void transport_start()
+    {
+      _lock_t lock(_mutex);
+      _publisher.transport_start();
+    }
+
+    virtual void transport_stop()
+    {
+      _lock_t lock(_mutex);
+      _publisher.transport_stop();
+    }
+
+    virtual bool transport_locate(float time_in_sec)
+    {
+      _lock_t lock(_mutex);
+      return _publisher.transport_locate(time_in_sec);
+    }
+
+    virtual void calibrate_client()
+    {
+      _lock_t lock(_mutex);
+      _publisher.calibrate_client();
+    }
+
+    virtual void set_processing_state(bool state)
+    {
+      _lock_t lock(_mutex);
+      _publisher.set_processing_state(state);
+    }
+
+    virtual void subscribe(Subscriber* subscriber)
+    {
+      _lock_t lock(_mutex);
+      _publisher.subscribe(subscriber);
+    }
+
+    virtual void unsubscribe(Subscriber* subscriber)
+    {
+      _lock_t lock(_mutex);
+      _publisher.unsubscribe(subscriber);
+    }
+
+    virtual std::string get_scene_as_XML() const
+    {
+      _lock_t lock(_mutex);
+      return _publisher.get_scene_as_XML();
+    }
+
+  private:
+    using _lock_t = std::lock_guard<std::mutex>;
+
+    Publisher& _publisher;
+    mutable std::mutex _mutex;
+};
+
+}  // namespace ssr
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -0,0 +1,556 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+
+/// @file
+/// Incremental XML parser for network messages.
+
+#ifndef SSR_XMLPULLPARSER_H
+#define SSR_XMLPULLPARSER_H
+
+#include <cmath>  // for std::pow()
+#include <cstdint>  // for uint64_t
+#include <cstdlib>  // for std::strtoul()
+#include <cstring>  // for std::strlen(), std::memcmp()
+#include <limits>  // for std::numeric_limits
+#include <string>
+#include <vector>
+
+#include "apf/stringtools.h"  // for S2A()
+
+namespace ssr
+{
+
+/** Pull parser for the XML subset used in network messages.
+ * The parser works directly on a character buffer (which must stay valid
+ * while it is used), no tree is built and no memory is allocated once the
+ * internal vectors have grown to their final size.
+ * Names and attribute values are ranges in the original buffer.
+ *
+ * Supported are elements, attributes (with single or double quotes),
+ * character references and the predefined entities.
+ * Text content, comments, processing instructions and DOCTYPE declarations
+ * are skipped.
+ *
+ * Unlike a DOM parser, syntax errors are only detected when they are reached,
+ * everything before has already been reported.
+ **/
+class XmlPullParser
+{
+  public:
+    enum event_t
+    {
+      start_element,  ///< opening tag, name() and attribute() are valid
+      end_element,  ///< closing tag (also generated for empty elements)
+      end_of_input,  ///< all elements are closed and the input is exhausted
+      error  ///< syntax error, parsing cannot be continued
+    };
+
+    /// Attribute value, a range of the input buffer
+    class Attribute
+    {
+      public:
+        Attribute(const char* first = nullptr, const char* last = nullptr)
+          : _first(first)
+          , _last(last)
+        {}
+
+        /// @return @b false if the attribute was not found
+        explicit operator bool() const { return _first != nullptr; }
+
+        bool empty() const { return _first == _last; }
+
+        /// Value with resolved entities, empty if not found
+        std::string str() const;
+
+        /// Convert value, same rules as apf::str::S2A()
+        template<typename T>
+        bool get(T& output) const
+        {
+          return *this && apf::str::S2A(this->str(), output);
+        }
+
+        // Fast conversions without creating a std::string
+        bool get(float& output) const;
+        bool get(unsigned& output) const;
+        bool get(int& output) const;
+        bool get(bool& output) const;
+
+      private:
+        bool _get_digits(uint64_t& value, const char*& pos, int& digits
+            , int& dropped) const;
+
+        const char* _first;
+        const char* _last;
+    };
+
+    XmlPullParser() : _pos(nullptr), _last(nullptr) {}
+
+    /// Start parsing a new buffer
+    void reset(const char* first, const char* last)
+    {
+      _pos = first;
+      _last = last;
+      _open.clear();
+      _attributes.clear();
+      _pending_end = false;
+    }
+
+    event_t next();
+
+    /// Skip the rest of the current element (including its end tag)
+    event_t skip();
+
+    /// Name of the current element
+    std::string name() const { return std::string(_name_first, _name_last); }
+
+    /// Compare name of the current element
+    bool is(const char* name) const
+    {
+      auto length = size_t(_name_last - _name_first);
+      return std::strlen(name) == length
+        && std::memcmp(name, _name_first, length) == 0;
+    }
+
+    /// Get attribute of the current element
+    Attribute attribute(const char* name) const
+    {
+      auto length = std::strlen(name);
+      for (const auto& attr: _attributes)
+      {
+        if (size_t(attr.name_last - attr.name_first) == length
+            && std::memcmp(name, attr.name_first, length) == 0)
+        {
+          return attr.value;
+        }
+      }
+      return Attribute();
+    }
+
+    /// Number of currently open elements
+    size_t depth() const { return _open.size(); }
+
+  private:
+    struct _Range { const char* first; const char* last; };
+    struct _Attr { const char* name_first; const char* name_last;
+      Attribute value; };
+
+    static bool _is_space(char ch)
+    {
+      return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+    }
+
+    static bool _is_name_char(char ch)
+    {
+      return !_is_space(ch) && ch != '/' && ch != '>' && ch != '='
+        && ch != '<' && ch != '\0';
+    }
+
+    void _skip_space() { while (_pos != _last && _is_space(*_pos)) ++_pos; }
+    bool _skip_past(const char* terminator);
+    event_t _start_tag();
+    event_t _end_tag();
+
+    const char* _pos;
+    const char* _last;
+    const char* _name_first;
+    const char* _name_last;
+    bool _pending_end;  ///< end_element for an empty element is due
+    std::vector<_Range> _open;
+    std::vector<_Attr> _attributes;
+};
+
+inline XmlPullParser::event_t
+XmlPullParser::next()
+{
+  if (_pending_end)
+  {
+    _pending_end = false;
+    _name_first = _open.back().first;
+    _name_last = _open.back().last;
+    _open.pop_back();
+    return end_element;
+  }
+
+  for (;;)
+  {
+    // Skip text
+    while (_pos != _last && *_pos != '<') ++_pos;
+
+    if (_pos == _last) return _open.empty() ? end_of_input : error;
+
+    ++_pos;
+    if (_pos == _last) return error;
+
+    if (*_pos == '/') return _end_tag();
+    if (*_pos == '?')
+    {
+      if (!_skip_past("?>")) return error;
+    }
+    else if (*_pos == '!')
+    {
+      if (_last - _pos >= 3 && _pos[1] == '-' && _pos[2] == '-')
+      {
+        if (!_skip_past("-->")) return error;
+      }
+      else if (!_skip_past(">")) return error;
+    }
+    else return _start_tag();
+  }
+}
+
+inline XmlPullParser::event_t
+XmlPullParser::skip()
+{
+  auto target = _open.size() - 1;
+  for (;;)
+  {
+    auto event = this->next();
+    if (event == error || event == end_of_input) return error;
+    if (event == end_element && _open.size() == target) return end_element;
+  }
+}
+
+inline bool
+XmlPullParser::_skip_past(const char* terminator)
+{
+  auto length = std::strlen(terminator);
+  for (; size_t(_last - _pos) >= length; ++_pos)
+  {
+    if (std::memcmp(_pos, terminator, length) == 0)
+    {
+      _pos += length;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline XmlPullParser::event_t
+XmlPullParser::_start_tag()
+{
+  _name_first = _pos;
+  while (_pos != _last && _is_name_char(*_pos)) ++_pos;
+  _name_last = _pos;
+  if (_name_first == _name_last) return error;
+
+  _attributes.clear();
+
+  for (;;)
+  {
+    _skip_space();
+    if (_pos == _last) return error;
+
+    if (*_pos == '>')
+    {
+      ++_pos;
+      _open.push_back({_name_first, _name_last});
+      return start_element;
+    }
+    if (*_pos == '/')
+    {
+      if (++_pos == _last || *_pos != '>') return error;
+      ++_pos;
+      _open.push_back({_name_first, _name_last});
+      _pending_end = true;
+      return start_element;
+    }
+
+    _Attr attr;
+    attr.name_first = _pos;
+    while (_pos != _last && _is_name_char(*_pos)) ++_pos;
+    attr.name_last = _pos;
+    if (attr.name_first == attr.name_last) return error;
+
+    _skip_space();
+    if (_pos == _last || *_pos != '=') return error;
+    ++_pos;
+    _skip_space();
+    if (_pos == _last || (*_pos != '"' && *_pos != '\'')) return error;
+
+    char quote = *_pos++;
+    auto value_first = _pos;
+    while (_pos != _last && *_pos != quote) ++_pos;
+    if (_pos == _last) return error;
+    attr.value = Attribute(value_first, _pos);
+    ++_pos;
+
+    _attributes.push_back(attr);
+  }
+}
+
+inline XmlPullParser::event_t
+XmlPullParser::_end_tag()
+{
+  ++_pos;  // skip '/'
+  _name_first = _pos;
+  while (_pos != _last && _is_name_char(*_pos)) ++_pos;
+  _name_last = _pos;
+  _skip_space();
+  if (_pos == _last || *_pos != '>') return error;
+  ++_pos;
+
+  if (_open.empty()) return error;
+  auto length = size_t(_name_last - _name_first);
+  if (size_t(_open.back().last - _open.back().first) != length
+      || std::memcmp(_open.back().first, _name_first, length) != 0)
+  {
+    return error;
+  }
+  _open.pop_back();
+  return end_element;
+}
+
+inline std::string
+XmlPullParser::Attribute::str() const
+{
+  std::string result;
+  result.reserve(size_t(_last - _first));
+
+  for (auto pos = _first; pos != _last; ++pos)
+  {
+    if (*pos != '&')
+    {
+      result.push_back(*pos);
+      continue;
+    }
+
+    auto end = pos;
+    while (end != _last && *end != ';') ++end;
+    if (end == _last)
+    {
+      result.append(pos, _last);
+      break;
+    }
+
+    std::string entity(pos + 1, end);
+    if (entity == "amp") result.push_back('&');
+    else if (entity == "lt") result.push_back('<');
+    else if (entity == "gt") result.push_back('>');
+    else if (entity == "quot") result.push_back('"');
+    else if (entity == "apos") result.push_back('\'');
+    else if (entity.size() > 1 && entity[0] == '#')
+    {
+      bool hex = entity[1] == 'x';
+      char* digits_end;
+      unsigned long code = std::strtoul(entity.c_str() + (hex ? 2 : 1)
+          , &digits_end, hex ? 16 : 10);
+      // encode as UTF-8
+      if (*digits_end != '\0' || code == 0 || code > 0x10FFFF)
+      {
+        result.append(pos, end + 1);  // invalid, keep as is
+      }
+      else if (code < 0x80)
+      {
+        result.push_back(char(code));
+      }
+      else if (code < 0x800)
+      {
+        result.push_back(char(0xC0 | (code >> 6)));
+        result.push_back(char(0x80 | (code & 0x3F)));
+      }
+      else if (code < 0x10000)
+      {
+        result.push_back(char(0xE0 | (code >> 12)));
+        result.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        result.push_back(char(0x80 | (code & 0x3F)));
+      }
+      else
+      {
+        result.push_back(char(0xF0 | (code >> 18)));
+        result.push_back(char(0x80 | ((code >> 12) & 0x3F)));
+        result.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        result.push_back(char(0x80 | (code & 0x3F)));
+      }
+    }
+    else
+    {
+      result.append(pos, end + 1);  // unknown entity, keep as is
+    }
+    pos = end;
+  }
+  return result;
+}
+
+/** Read decimal digits, at most 18 significant digits are used.
+ * @param digits number of significant digits (leading zeros don't count)
+ * @param dropped number of digits which didn't fit into @p value
+ **/
+inline bool
+XmlPullParser::Attribute::_get_digits(uint64_t& value, const char*& pos
+    , int& digits, int& dropped) const
+{
+  auto start = pos;
+  for (; pos != _last && *pos >= '0' && *pos <= '9'; ++pos)
+  {
+    if (value == 0 && *pos == '0') continue;  // leading zero
+    if (digits < 18)
+    {
+      value = value * 10 + uint64_t(*pos - '0');
+    }
+    else
+    {
+      ++dropped;
+    }
+    ++digits;
+  }
+  return pos != start;
+}
+
+inline bool
+XmlPullParser::Attribute::get(float& output) const
+{
+  if (!*this) return false;
+  auto pos = _first;
+  while (pos != _last && _is_space(*pos)) ++pos;
+
+  bool negative = false;
+  if (pos != _last && (*pos == '-' || *pos == '+')) negative = *pos++ == '-';
+
+  uint64_t mantissa = 0;
+  int digits = 0, dropped = 0;
+  bool ok = _get_digits(mantissa, pos, digits, dropped);
+  int exponent = dropped;
+
+  if (pos != _last && *pos == '.')
+  {
+    auto fraction = ++pos;
+    int fraction_dropped = 0;
+    if (_get_digits(mantissa, pos, digits, fraction_dropped)) ok = true;
+    exponent -= int(pos - fraction) - fraction_dropped;
+  }
+  if (!ok) return false;
+
+  if (pos != _last && (*pos == 'e' || *pos == 'E'))
+  {
+    ++pos;
+    bool negative_exponent = false;
+    if (pos != _last && (*pos == '-' || *pos == '+'))
+    {
+      negative_exponent = *pos++ == '-';
+    }
+    uint64_t value = 0;
+    int exponent_digits = 0, exponent_dropped = 0;
+    if (!_get_digits(value, pos, exponent_digits, exponent_dropped))
+    {
+      return false;
+    }
+    if (value > 1000 || exponent_dropped) value = 1000;
+    exponent += negative_exponent ? -int(value) : int(value);
+  }
+
+  while (pos != _last && _is_space(*pos)) ++pos;
+  if (pos != _last) return false;
+
+  double result = double(mantissa);
+  if (mantissa == 0)
+  {
+    // no multiplication, 0 * inf would be NaN
+  }
+  else if (exponent < 0)
+  {
+    result /= std::pow(10.0, -exponent);  // exact for small exponents
+  }
+  else if (exponent > 0)
+  {
+    result *= std::pow(10.0, exponent);
+  }
+  // out of range (including inf)
+  if (result > std::numeric_limits<float>::max()) return false;
+  output = float(negative ? -result : result);
+  return true;
+}
+
+inline bool
+XmlPullParser::Attribute::get(unsigned& output) const
+{
+  if (!*this) return false;
+  auto pos = _first;
+  while (pos != _last && _is_space(*pos)) ++pos;
+  if (pos != _last && *pos == '+') ++pos;
+
+  uint64_t value = 0;
+  int digits = 0, dropped = 0;
+  if (!_get_digits(value, pos, digits, dropped) || digits > 10) return false;
+  while (pos != _last && _is_space(*pos)) ++pos;
+  if (pos != _last || value > unsigned(-1)) return false;
+
+  output = unsigned(value);
+  return true;
+}
+
+inline bool
+XmlPullParser::Attribute::get(int& output) const
+{
+  if (!*this) return false;
+  auto pos = _first;
+  while (pos != _last && _is_space(*pos)) ++pos;
+  bool negative = false;
+  if (pos != _last && (*pos == '-' || *pos == '+')) negative = *pos++ == '-';
+
+  uint64_t value = 0;
+  int digits = 0, dropped = 0;
+  if (!_get_digits(value, pos, digits, dropped) || digits > 10) return false;
+  while (pos != _last && _is_space(*pos)) ++pos;
+  if (pos != _last || value > uint64_t(1u << 31) - (negative ? 0 : 1))
+  {
+    return false;
+  }
+
+  output = negative ? int(-int64_t(value)) : int(value);
+  return true;
+}
+
+inline bool
+XmlPullParser::Attribute::get(bool& output) const
+{
+  if (!*this) return false;
+  auto first = _first, last = _last;
+  while (first != last && _is_space(*first)) ++first;
+  while (first != last && _is_space(*(last - 1))) --last;
+
+  auto length = size_t(last - first);
+  if ((length == 1 && *first == '1')
+      || (length == 4 && std::memcmp(first, "true", 4) == 0))
+  {
+    output = true;
+  }
+  else if ((length == 1 && *first == '0')
+      || (length == 5 && std::memcmp(first, "false", 5) == 0))
+  {
+    output = false;
+  }
+  else return false;
+  return true;
+}
+
+}  // namespace ssr
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -32,9 +32,9 @@
 
 #include "rendererbase.h"
 
-#include "apf/convolver.h"  // for apf::conv::*
-#include "apf/sndfiletools.h"  // for apf::load_sndfile
+#include "apf/nonuniform_convolver.h"  // for apf::conv::nonuniform::*
 #include "apf/combine_channels.h"  // for apf::raised_cosine_fade, ...
+#include "filtercache.h"  // for FilterCache
 
 namespace ssr
 {
@@ -56,6 +56,7 @@ class BrsRenderer : public SourceToOutput<BrsRenderer, RendererBase>
     BrsRenderer(const apf::parameter_map& params)
       : _base(params)
       , _fade(this->block_size())
+      , _frequency_domain(params.get("frequency_domain_accumulation", false))
     {}
 
     void load_reproduction_setup();
@@ -67,21 +68,35 @@ class BrsRenderer : public SourceToOutput<BrsRenderer, RendererBase>
 
   private:
     apf::raised_cosine_fade<sample_type> _fade;
+    bool _frequency_domain;  // accumulate outputs in frequency domain
 };
 
 struct BrsRenderer::SourceChannel : apf::has_begin_and_end<sample_type*>
-                                  , apf::conv::Output
+                                  , apf::conv::nonuniform::Output
 {
-  explicit SourceChannel(const apf::conv::Input& in)
-    : apf::conv::Output(in)
+  SourceChannel(const apf::conv::nonuniform::Input& in, bool frequency_domain)
+    : apf::conv::nonuniform::Output(in)
+    , old_result(frequency_domain
+        ? new apf::conv::nonuniform::Accumulator(in.block_size())
+        : nullptr)
   {}
 
   // out-of-class definition because of cyclic dependencies with Source
   void update();
   void convolve_and_more(sample_type weight);
 
+  void accumulate_old(sample_type old_weight)
+  {
+    assert(old_result);
+    old_result->clear();
+    this->accumulate(*old_result, old_weight);
+  }
+
   apf::CombineChannelsResult::type crossfade_mode;
   sample_type new_weighting_factor;
+
+  /// Result with the old filter (only for frequency-domain accumulation)
+  std::unique_ptr<apf::conv::nonuniform::Accumulator> old_result;
 };
 
 class BrsRenderer::Source : public _base::Source
@@ -92,11 +107,14 @@ class BrsRenderer::Source : public _base::Source
       , _weighting_factor(-1.0f)
       , _brtf_index(size_t(-1))
     {
-      SndfileHandle ir_file
-        = apf::load_sndfile(p.get<std::string>("properties_file")
-            , this->parent.sample_rate(), 0);
+      _brtf_set = FilterCache::get({p.get<std::string>("properties_file")
+          , size_t(this->parent.sample_rate())
+          , size_t(this->parent.block_size()), 0
+          , this->parent.params.get("nonuniform_partitions", 0u)
+          , this->parent.params.get("nonuniform_max_block_size", 0u)}
+          , this->parent.params.get("filter_cache_dir", ""));
 
-      size_t no_of_channels = ir_file.channels();
+      size_t no_of_channels = _brtf_set->channels();
 
       if (no_of_channels % 2 != 0)
       {
@@ -106,36 +124,14 @@ class BrsRenderer::Source : public _base::Source
 
       _angles = no_of_channels / 2;
 
-      size_t size = ir_file.frames();
-
-      using matrix_t = apf::fixed_matrix<sample_type>;
-
-      auto ir_data = matrix_t(size, no_of_channels);
-
-      // TODO: check return value?
-      ir_file.readf(ir_data.data(), size);
-
-      size_t block_size = this->parent.block_size();
-
-      auto temp = apf::conv::Transform(block_size);
-
-      size_t partitions = apf::conv::min_partitions(block_size, size);
-
-      _brtf_set.reset(new brtf_set_t(no_of_channels, block_size, partitions));
-
-      auto target = _brtf_set->begin();
-      for (const auto& slice: ir_data.slices)
-      {
-        temp.prepare_filter(slice.begin(), slice.end(), *target++);
-      }
-
-      assert(target == _brtf_set->end());
-
-      _convolver_input.reset(new apf::conv::Input(block_size, partitions));
+      _convolver_input.reset(
+          new apf::conv::nonuniform::Input(_brtf_set->layout));
 
       this->sourcechannels.reserve(2);
-      this->sourcechannels.emplace_back(*_convolver_input);
-      this->sourcechannels.emplace_back(*_convolver_input);
+      this->sourcechannels.emplace_back(*_convolver_input
+          , this->parent._frequency_domain);
+      this->sourcechannels.emplace_back(*_convolver_input
+          , this->parent._frequency_domain);
     }
 
     APF_PROCESS(Source, _base::Source)
@@ -189,6 +185,15 @@ class BrsRenderer::Source : public _base::Source
         {
           // No need to convolve with old values
         }
+        else if (this->parent._frequency_domain)
+        {
+          // The filter doesn't change in the "constant" case, the result is
+          // accumulated later in the Output
+          if (crossfade_mode != constant)
+          {
+            this->sourcechannels[i].accumulate_old(_weighting_factor.old());
+          }
+        }
         else
         {
           this->sourcechannels[i].convolve_and_more(_weighting_factor.old());
@@ -199,7 +204,8 @@ class BrsRenderer::Source : public _base::Source
         if (_brtf_index.changed())
         {
           // left and right channels are interleaved
-          this->sourcechannels[i].set_filter((*_brtf_set)[2 * _brtf_index + i]);
+          this->sourcechannels[i].set_filter(
+              _brtf_set->filters[2 * _brtf_index + i]);
         }
 
         this->sourcechannels[i].crossfade_mode = crossfade_mode;
@@ -210,13 +216,12 @@ class BrsRenderer::Source : public _base::Source
     }
 
   private:
-    using brtf_set_t = apf::fixed_vector<apf::conv::Filter>;
-    std::unique_ptr<brtf_set_t> _brtf_set;
+    FilterCache::pointer _brtf_set;  // shared with other sources
 
     apf::BlockParameter<sample_type> _weighting_factor;
     apf::BlockParameter<size_t> _brtf_index;
 
-    std::unique_ptr<apf::conv::Input> _convolver_input;
+    std::unique_ptr<apf::conv::nonuniform::Input> _convolver_input;
 
     size_t _angles;  // Number of angles in BRIR file
 };
@@ -249,6 +254,19 @@ class BrsRenderer::RenderFunction
       _in->update();
     }
 
+    void accumulate(apf::conv::nonuniform::Accumulator& target)
+    {
+      assert(_in);
+      _in->accumulate(target, _in->new_weighting_factor);
+    }
+
+    void accumulate(apf::conv::nonuniform::Accumulator& target
+        , apf::fade_out_tag)
+    {
+      assert(_in && _in->old_result);
+      target.add(*_in->old_result);
+    }
+
   private:
     SourceChannel* _in;
 };
@@ -259,17 +277,36 @@ class BrsRenderer::Output : public _base::Output
     Output(const Params& p)
       : _base::Output(p)
       , _combiner(this->sourcechannels, this->buffer, this->parent._fade)
-    {}
+    {
+      if (this->parent._frequency_domain)
+      {
+        _accumulator.reset(new accumulator_t(this->sourcechannels
+              , this->buffer, this->parent._fade));
+      }
+    }
 
     APF_PROCESS(Output, _base::Output)
     {
-      _combiner.process(RenderFunction());
+      if (_accumulator)
+      {
+        _accumulator->process(RenderFunction());
+      }
+      else
+      {
+        _combiner.process(RenderFunction());
+      }
     }
 
   private:
+    using accumulator_t = apf::CombineChannelsCrossfadeAccumulate<
+      apf::cast_proxy<SourceChannel, sourcechannels_t>, buffer_type
+      , apf::raised_cosine_fade<sample_type>
+      , apf::conv::nonuniform::Accumulator>;
+
     apf::CombineChannelsCrossfadeCopy<apf::cast_proxy<SourceChannel
       , sourcechannels_t>, buffer_type
       , apf::raised_cosine_fade<sample_type>> _combiner;
+    std::unique_ptr<accumulator_t> _accumulator;
 };
 
 void
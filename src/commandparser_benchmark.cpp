@@ -0,0 +1,244 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+
+/// @file
+/// Throughput of the network CommandParser.
+///
+/// A buffer with many pipelined (zero-terminated) requests, as sent by
+/// head-trackers and GUIs, is parsed with the CommandParser (which works in
+/// place, see XmlPullParser) and with a libxml2 document plus XPath query per
+/// message (XMLParser, as used before).
+/// Usage: commandparser-benchmark [number of messages]
+
+#include <algorithm>  // for std::find()
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "apf/stringtools.h"  // for S2A()
+#include "commandparser.h"
+#include "publisher.h"
+#include "xmlparser.h"
+
+using apf::str::S2A;
+
+namespace
+{
+
+/// Counts changes, everything else is ignored
+struct CountingPublisher : ssr::Publisher
+{
+  size_t changes = 0;
+
+  virtual bool load_scene(const std::string&) { return true; }
+  virtual bool save_scene_as_XML(const std::string&) const { return true; }
+  virtual void start_processing() {}
+  virtual void stop_processing() {}
+  virtual void new_source(const std::string&, Source::model_t
+      , const std::string&, int, const Position&, const bool
+      , const Orientation&, const bool, const float, const bool
+      , const std::string&) {}
+  virtual void begin_transaction() {}
+  virtual void end_transaction() {}
+  virtual void delete_source(ssr::id_t) {}
+  virtual void delete_all_sources() {}
+  virtual void set_source_position(ssr::id_t, const Position&) { ++changes; }
+  virtual void set_source_orientation(ssr::id_t, const Orientation&)
+  {
+    ++changes;
+  }
+  virtual void set_source_gain(ssr::id_t, float) { ++changes; }
+  virtual void set_source_mute(ssr::id_t, bool) { ++changes; }
+  virtual void set_source_signal_level(const ssr::id_t, const float) {}
+  virtual void set_source_name(ssr::id_t, const std::string&) {}
+  virtual void set_source_properties_file(ssr::id_t, const std::string&) {}
+  virtual void set_source_model(ssr::id_t, Source::model_t) {}
+  virtual void set_source_port_name(ssr::id_t, const std::string&) {}
+  virtual void set_source_position_fixed(ssr::id_t, const bool) {}
+  virtual void set_reference_position(const Position&) { ++changes; }
+  virtual void set_reference_orientation(const Orientation&) { ++changes; }
+  virtual void set_reference_offset_position(const Position&) {}
+  virtual void set_reference_offset_orientation(const Orientation&) {}
+  virtual void set_master_volume(float) {}
+  virtual void set_amplitude_reference_distance(float) {}
+  virtual void set_master_signal_level(float) {}
+  virtual void set_cpu_load(const float) {}
+  virtual void publish_sample_rate(const int) {}
+  virtual std::string get_renderer_name() const { return ""; }
+  virtual bool show_head() const { return false; }
+  virtual void transport_start() {}
+  virtual void transport_stop() {}
+  virtual bool transport_locate(float) { return true; }
+  virtual void calibrate_client() {}
+  virtual void set_processing_state(bool) {}
+  virtual void subscribe(ssr::Subscriber*) {}
+  virtual void unsubscribe(ssr::Subscriber*) {}
+  virtual std::string get_scene_as_XML() const { return ""; }
+};
+
+/// The way requests were parsed before: document, XPath, node walk
+void parse_with_dom(const std::string& cmd, ssr::Publisher& controller)
+{
+  XMLParser xp;
+  auto doc = xp.load_string(cmd);
+  if (!doc) return;
+  auto result = doc->eval_xpath("/request");
+  if (!result) return;
+
+  XMLParser::Node root = result->node();
+  for (auto i = root.child(); !!i; ++i)
+  {
+    if (i == "source")
+    {
+      ssr::id_t id;
+      if (!S2A(i.get_attribute("id"), id)) return;
+      for (auto inner = i.child(); !!inner; ++inner)
+      {
+        Position position;
+        Orientation orientation;
+        if (inner == "position"
+            && S2A(inner.get_attribute("x"), position.x)
+            && S2A(inner.get_attribute("y"), position.y))
+        {
+          controller.set_source_position(id, position);
+        }
+        else if (inner == "orientation"
+            && S2A(inner.get_attribute("azimuth"), orientation.azimuth))
+        {
+          controller.set_source_orientation(id, orientation);
+        }
+      }
+      float volume;
+      if (S2A(i.get_attribute("volume"), volume))
+      {
+        controller.set_source_gain(id, volume);
+      }
+    }
+    else if (i == "reference")
+    {
+      for (auto inner = i.child(); !!inner; ++inner)
+      {
+        float azimuth;
+        if (inner == "orientation"
+            && S2A(inner.get_attribute("azimuth"), azimuth))
+        {
+          controller.set_reference_orientation(Orientation(azimuth));
+        }
+      }
+    }
+  }
+}
+
+template<typename F>
+double seconds(F f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  size_t messages = 200000;
+  if (argc > 1 && !S2A(argv[1], messages))
+  {
+    std::cerr << "Usage: " << argv[0] << " [number of messages]\n";
+    return 1;
+  }
+
+  // Pipelined requests, as they arrive in one socket read
+  std::string buffer;
+  for (size_t i = 0; i < messages; ++i)
+  {
+    auto number = apf::str::A2S(i % 1000);
+    switch (i % 3)
+    {
+      case 0:
+        buffer += "<request><source id='" + apf::str::A2S(i % 64 + 1)
+          + "'><position x='1." + number + "' y='-2.5" + number
+          + "'/></source></request>";
+        break;
+      case 1:
+        buffer += "<request><reference><orientation azimuth='" + number
+          + ".25'/></reference></request>";
+        break;
+      default:
+        buffer += "<request><source id='" + apf::str::A2S(i % 64 + 1)
+          + "' volume='-" + number + "'><orientation azimuth='" + number
+          + "'/></source></request>";
+    }
+    buffer += '\0';
+  }
+
+  CountingPublisher dom_publisher, pull_publisher;
+
+  auto dom_time = seconds([&] ()
+  {
+    size_t first = 0;
+    for (size_t last; (last = buffer.find('\0', first)) != std::string::npos
+        ; first = last + 1)
+    {
+      // Connection::read_handler() used to copy each message
+      parse_with_dom(buffer.substr(first, last - first), dom_publisher);
+    }
+  });
+
+  ssr::CommandParser parser(pull_publisher);
+  auto pull_time = seconds([&] ()
+  {
+    auto first = buffer.data();
+    auto end = first + buffer.size();
+    for (const char* last; (last = std::find(first, end, '\0')) != end
+        ; first = last + 1)
+    {
+      parser.parse_cmd(first, last);
+    }
+  });
+
+  if (dom_publisher.changes != pull_publisher.changes)
+  {
+    std::cerr << "Different number of changes: " << dom_publisher.changes
+      << " vs. " << pull_publisher.changes << std::endl;
+    return 1;
+  }
+
+  std::cout << messages << " messages, " << buffer.size() << " bytes\n"
+    << "libxml2 document + XPath: " << messages / dom_time
+    << " messages/s\n"
+    << "CommandParser (in place): " << messages / pull_time
+    << " messages/s\n"
+    << "speedup: " << dom_time / pull_time << std::endl;
+  return 0;
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
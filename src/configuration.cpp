@@ -143,6 +143,8 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
   conf.ip_server = false;
 #endif
   conf.server_port = 4711;
+  conf.server_update_interval = 10;
+  conf.server_threads = 0;
 
   conf.freewheeling = false;
   conf.scene_file_name = "";
@@ -158,11 +160,26 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
 
   conf.renderer_params.set("amplitude_reference_distance", 3);  // meters
 
+  // distribute sources/outputs to audio threads dynamically
+  conf.renderer_params.set("dynamic_scheduling", false);
+
+  // for convolution-based renderers (binaural, BRS, generic, WFS prefilter)
+  // "0" means uniformly partitioned convolution
+  conf.renderer_params.set("nonuniform_partitions", 0);
+  conf.renderer_params.set("nonuniform_max_block_size", 0); // "0": no limit
+  // one IFFT per output instead of one per source and output
+  conf.renderer_params.set("frequency_domain_accumulation", false);
+  // directory for transformed impulse responses, "" means no caching
+  conf.renderer_params.set("filter_cache_dir", "");
+
   // for WFS renderer
   conf.renderer_params.set("prefilter_file"
       , SSR_DATA_DIR"/default_wfs_prefilter.wav");
   conf.renderer_params.set("delayline_size", 100000); // in samples
   conf.renderer_params.set("initial_delay", 1000);    // in samples
+  // "none", "lagrange" or "sinc" (for fractional delays)
+  conf.renderer_params.set("delay_interpolation", "none");
+  conf.renderer_params.set("delay_interpolation_order", 3);  // must be odd
 
   // for binaural renderer
   conf.renderer_params.set("hrir_size", 0); // "0" means use all that are there
@@ -171,6 +188,11 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
   // for AAP renderer
   conf.renderer_params.set("ambisonics_order", 0); // "0" means use maximum that makes sense
   conf.renderer_params.set("in_phase", false);
+
+  // for NFC-HOA renderer
+  // filter update interval for moving sources in samples, 0 means block size
+  conf.renderer_params.set("hoa_update_interval", 1);
+  conf.renderer_params.set("hoa_single_precision", false);
   conf.tracker = "";
 
   // USB ports have to be checked first!
@@ -209,8 +231,19 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
 "    --hrirs=FILE       Load the HRIRs for binaural renderer from FILE\n"
 "    --hrir-size=VALUE  Maximum IR length (binaural and BRS renderer)\n"
 "    --prefilter=FILE   Load WFS prefilter from FILE\n"
+"    --delay-interpolation=TYPE  Fractional delays in WFS renderer,\n"
+"                       TYPE: none (default), lagrange or sinc\n"
+"    --nonuniform-partitions=N  Use non-uniformly partitioned convolution\n"
+"                       with N partitions per block size (default: uniform)\n"
+"    --fd-accumulation  Accumulate convolution results in frequency domain\n"
+"                       (binaural, BRS and generic renderer)\n"
+"    --filter-cache=DIR Store transformed impulse responses in DIR\n"
+"                       (binaural, BRS and generic renderer)\n"
 "-o, --ambisonics-order=VALUE Ambisonics order to use (default: maximum)\n"
 "    --in-phase-rendering     Use in-phase rendering for Ambisonics\n"
+"    --hoa-update-interval=N  Update NFC-HOA filters of moving sources\n"
+"                       every N samples (default: 1)\n"
+"    --hoa-single-precision   Use single precision NFC-HOA filters\n"
 "\n"
 "JACK options:\n"
 "-n, --name=NAME        Set JACK client name to NAME\n"
@@ -224,6 +257,7 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
 "-c, --config=FILE      Read configuration from FILE\n"
 "-s, --setup=FILE       Load reproduction setup from FILE\n"
 "    --threads=N        Number of audio threads (default N=auto)\n"
+"    --dynamic-scheduling  Distribute work dynamically to audio threads\n"
 "-r, --record=FILE      Record the audio output of the renderer to FILE\n"
 #ifndef ENABLE_ECASOUND
 "                       (disabled at compile time!)\n"
@@ -237,6 +271,13 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
 "-i, --ip-server[=PORT] Start IP server (default on)\n"
 "                       A port can be specified: --ip-server=5555\n"
 "-I, --no-ip-server     Don't start IP server\n"
+"    --network-update-interval=MS\n"
+"                       Minimum time between two updates sent to a network\n"
+"                       client, only the latest values are sent "
+                                                        "(default: 10 ms)\n"
+"    --network-threads=N\n"
+"                       Number of threads serving the network clients\n"
+"                       (default: 0, one per CPU core)\n"
 #else
 "-i, --ip-server        Start IP server (not enabled at compile time!)\n"
 "-I, --no-ip-server     Don't start IP server (default)\n"
@@ -292,8 +333,14 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
     {"hrirs",        required_argument, nullptr,  0 },
     {"hrir-size",    required_argument, nullptr,  0 },
     {"prefilter",    required_argument, nullptr,  0 },
+    {"delay-interpolation", required_argument, nullptr, 0 },
+    {"nonuniform-partitions", required_argument, nullptr, 0 },
+    {"fd-accumulation", no_argument,    nullptr,  0 },
+    {"filter-cache", required_argument, nullptr,  0 },
     {"ambisonics-order",required_argument,nullptr,'o'},
     {"in-phase-rendering", no_argument, nullptr,  0 },
+    {"hoa-update-interval", required_argument, nullptr, 0 },
+    {"hoa-single-precision", no_argument, nullptr, 0 },
 
     {"name",         required_argument, nullptr, 'n'},
     {"input-prefix", required_argument, nullptr,  0 },
@@ -303,11 +350,14 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
     {"config",       required_argument, nullptr, 'c'},
     {"setup",        required_argument, nullptr, 's'},
     {"threads",      required_argument, nullptr,  0 },
+    {"dynamic-scheduling", no_argument, nullptr,  0 },
     {"record",       required_argument, nullptr, 'r'},
     {"loop",         no_argument,       nullptr,  0 },
     {"master-volume-correction", required_argument, nullptr, 0},
     {"ip-server",    optional_argument, nullptr, 'i'},
     {"no-ip-server", no_argument,       nullptr, 'I'},
+    {"network-update-interval", required_argument, nullptr, 0 },
+    {"network-threads", required_argument, nullptr, 0 },
     {"gui",          no_argument,       nullptr, 'g'},
     {"no-gui",       no_argument,       nullptr, 'G'},
     {"tracker",      required_argument, nullptr, 't'},
@@ -351,10 +401,36 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
         {
           conf.renderer_params.set("prefilter_file", optarg);
         }
+        else if (strcmp("delay-interpolation", longopts[longindex].name) == 0)
+        {
+          conf.renderer_params.set("delay_interpolation", optarg);
+        }
+        else if (strcmp("nonuniform-partitions", longopts[longindex].name) == 0)
+        {
+          conf.renderer_params.set("nonuniform_partitions", optarg);
+          assert(conf.renderer_params.get("nonuniform_partitions", 0) >= 0);
+        }
+        else if (strcmp("fd-accumulation", longopts[longindex].name) == 0)
+        {
+          conf.renderer_params.set("frequency_domain_accumulation", true);
+        }
+        else if (strcmp("filter-cache", longopts[longindex].name) == 0)
+        {
+          conf.renderer_params.set("filter_cache_dir", optarg);
+        }
         else if (strcmp("in-phase-rendering", longopts[longindex].name) == 0)
         {
           conf.renderer_params.set("in_phase", true);
         }
+        else if (strcmp("hoa-update-interval", longopts[longindex].name) == 0)
+        {
+          conf.renderer_params.set("hoa_update_interval", optarg);
+          assert(conf.renderer_params.get("hoa_update_interval", 0) >= 0);
+        }
+        else if (strcmp("hoa-single-precision", longopts[longindex].name) == 0)
+        {
+          conf.renderer_params.set("hoa_single_precision", true);
+        }
         else if (strcmp("input-prefix", longopts[longindex].name) == 0)
         {
           conf.input_port_prefix = optarg;
@@ -367,6 +443,10 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
         {
           conf.renderer_params.set("threads", optarg);
         }
+        else if (strcmp("dynamic-scheduling", longopts[longindex].name) == 0)
+        {
+          conf.renderer_params.set("dynamic_scheduling", true);
+        }
         else if (strcmp("loop", longopts[longindex].name) == 0)
         {
           conf.loop = true;
@@ -375,6 +455,22 @@ ssr::conf_struct ssr::configuration(int& argc, char* argv[])
         {
           conf.renderer_params.set("master_volume_correction", optarg);
         }
+        else if (strcmp("network-update-interval", longopts[longindex].name)
+            == 0)
+        {
+          if (!S2A(optarg, conf.server_update_interval))
+          {
+            ERROR("Invalid network update interval specified!");
+          }
+        }
+        else if (strcmp("network-threads", longopts[longindex].name) == 0)
+        {
+          if (!S2A(optarg, conf.server_threads) || conf.server_threads < 0)
+          {
+            ERROR("Invalid number of network threads specified!");
+            conf.server_threads = 0;
+          }
+        }
         else if (strcmp("tracker-port", longopts[longindex].name) == 0)
         {
           conf.tracker_ports = optarg;
@@ -648,6 +744,24 @@ int ssr::load_config_file(const char *filename, conf_struct& conf){
     {
       conf.renderer_params.set("threads", value);
     }
+    else if (!strcmp(key, "THREAD_SPIN_COUNT"))
+    {
+      conf.renderer_params.set("spin_count", value);
+      assert(conf.renderer_params.get("spin_count", 0) >= 0);
+    }
+    else if (!strcmp(key, "DYNAMIC_SCHEDULING"))
+    {
+      if (!strcasecmp(value, "true"))
+      {
+        conf.renderer_params.set("dynamic_scheduling", true);
+      }
+      else if (!strcasecmp(value, "false"))
+      {
+        conf.renderer_params.set("dynamic_scheduling", false);
+      }
+      else ERROR("I don't understand the option '" << value
+          << "' for dynamic scheduling.");
+    }
     else if (!strcmp(key, "MASTER_VOLUME_CORRECTION"))
     {
       conf.renderer_params.set("master_volume_correction", value);
@@ -698,6 +812,15 @@ int ssr::load_config_file(const char *filename, conf_struct& conf){
       conf.renderer_params.set("initial_delay", value);
       assert(conf.renderer_params.get<int>("initial_delay") >= 0);
     }
+    else if (!strcmp(key, "DELAY_INTERPOLATION"))
+    {
+      conf.renderer_params.set("delay_interpolation", value);
+    }
+    else if (!strcmp(key, "DELAY_INTERPOLATION_ORDER"))
+    {
+      conf.renderer_params.set("delay_interpolation_order", value);
+      assert(conf.renderer_params.get<int>("delay_interpolation_order") >= 1);
+    }
     else if (!strcmp(key, "HRIR_FILE_NAME"))
     {
       conf.renderer_params.set("hrir_file"
@@ -708,6 +831,34 @@ int ssr::load_config_file(const char *filename, conf_struct& conf){
       conf.renderer_params.set("hrir_size", value);
       assert(conf.renderer_params.get("hrir_size", 0) >= 1);
     }
+    else if (!strcmp(key, "NONUNIFORM_PARTITIONS"))
+    {
+      conf.renderer_params.set("nonuniform_partitions", value);
+      assert(conf.renderer_params.get("nonuniform_partitions", 0) >= 0);
+    }
+    else if (!strcmp(key, "NONUNIFORM_MAX_BLOCK_SIZE"))
+    {
+      conf.renderer_params.set("nonuniform_max_block_size", value);
+      assert(conf.renderer_params.get("nonuniform_max_block_size", 0) >= 0);
+    }
+    else if (!strcmp(key, "FD_ACCUMULATION"))
+    {
+      if (!strcasecmp(value, "true"))
+      {
+        conf.renderer_params.set("frequency_domain_accumulation", true);
+      }
+      else if (!strcasecmp(value, "false"))
+      {
+        conf.renderer_params.set("frequency_domain_accumulation", false);
+      }
+      else ERROR("I don't understand the option '" << value
+          << "' for frequency-domain accumulation.");
+    }
+    else if (!strcmp(key, "FILTER_CACHE_DIR"))
+    {
+      conf.renderer_params.set("filter_cache_dir"
+          , make_path_relative_to_current_dir(value, filename));
+    }
     else if (!strcmp(key, "AMBISONICS_ORDER"))
     {
       conf.renderer_params.set("ambisonics_order", atoi(value));
@@ -721,6 +872,24 @@ int ssr::load_config_file(const char *filename, conf_struct& conf){
       else ERROR("I don't understand the option '" << value
           << "' for in-phase rendering.");
     }
+    else if (!strcmp(key, "HOA_UPDATE_INTERVAL"))
+    {
+      conf.renderer_params.set("hoa_update_interval", value);
+      assert(conf.renderer_params.get("hoa_update_interval", 0) >= 0);
+    }
+    else if (!strcmp(key, "HOA_SINGLE_PRECISION"))
+    {
+      if (!strcasecmp(value, "true"))
+      {
+        conf.renderer_params.set("hoa_single_precision", true);
+      }
+      else if (!strcasecmp(value, "false"))
+      {
+        conf.renderer_params.set("hoa_single_precision", false);
+      }
+      else ERROR("I don't understand the option '" << value
+          << "' for NFC-HOA single precision.");
+    }
     else if (!strcmp(key, "INPUT_PREFIX"))
     {
       conf.input_port_prefix = value;
@@ -757,6 +926,18 @@ int ssr::load_config_file(const char *filename, conf_struct& conf){
       conf.server_port = atoi(value);
       #endif
     }
+    else if (!strcmp(key, "NETWORK_UPDATE_INTERVAL"))
+    {
+      #ifdef ENABLE_IP_INTERFACE
+      conf.server_update_interval = atoi(value);
+      #endif
+    }
+    else if (!strcmp(key, "NETWORK_THREADS"))
+    {
+      #ifdef ENABLE_IP_INTERFACE
+      conf.server_threads = atoi(value);
+      #endif
+    }
     else if (!strcmp(key, "VERBOSE"))
     {
       ssr::verbose = atoi(value);
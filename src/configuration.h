@@ -59,6 +59,8 @@ struct conf_struct
   std::string path_to_scene_menu;       ///< path to scene_menu.conf
 
   int server_port;                      ///< listening port
+  int server_update_interval;           ///< ms between network updates
+  int server_threads;                   ///< 0: one per CPU core
   /// size of delay line (in samples)
   int wfs_delayline_size;
   /// maximum negative delay (in samples, wfs_initial_delay >= 0)
@@ -150,6 +150,9 @@ class Controller : public Publisher
         , const float gain = 1.0f, const bool muted = false
         , const std::string& properties_file = "");
 
+    virtual void begin_transaction();
+    virtual void end_transaction();
+
     virtual void delete_source(id_t id);
     /// delete all sources in all subscribers
     virtual void delete_all_sources();
@@ -393,7 +396,8 @@ Controller<Renderer>::Controller(int argc, char* argv[])
   if (_conf.ip_server)
   {
     VERBOSE("Starting IP Server with port " << _conf.server_port);
-    _network_interface.reset(new Server(*this, _conf.server_port));
+    _network_interface.reset(new Server(*this, _conf.server_port
+          , _conf.server_update_interval, _conf.server_threads));
     _network_interface->start();
   }
 #endif // ENABLE_IP_INTERFACE
@@ -610,8 +614,8 @@ struct PositionPlusBool : Position
                                  :                fixed(false) {}
   explicit PositionPlusBool(Position pos, const bool fixed = false)
                                  : Position(pos), fixed(fixed) {}
-  PositionPlusBool(const float x, const float y, const bool fixed = false)
-                                 : Position(x,y), fixed(fixed) {}
+  PositionPlusBool(const float x, const float y, const float z
+      , const bool fixed = false) : Position(x,y,z), fixed(fixed) {}
 
   bool fixed;
 };
@@ -635,21 +639,25 @@ get_position(const Node& node)
   {
     if (i == "position")
     {
-      float x, y;
+      float x, y, z = 0.0f;
       bool fixed;
 
+      // z is optional
+      std::string z_string = i.get_attribute("z");
+
       // if read operation successful
       if (apf::str::S2A(i.get_attribute("x"), x)
-          && apf::str::S2A(i.get_attribute("y"), y))
+          && apf::str::S2A(i.get_attribute("y"), y)
+          && (z_string == "" || apf::str::S2A(z_string, z)))
       {
         // "fixed" indicated
         if (apf::str::S2A(i.get_attribute("fixed"), fixed))
         {
-          temp.reset(new PositionPlusBool(x, y, fixed));
+          temp.reset(new PositionPlusBool(x, y, z, fixed));
         }
         else // "fixed" not indicated
         {
-          temp.reset(new PositionPlusBool(x, y));
+          temp.reset(new PositionPlusBool(x, y, z));
         }
 
         return temp; // return sucessfully
@@ -1372,6 +1380,9 @@ Controller<Renderer>::new_source(const std::string& name
   apf::parameter_map p;
   p.set("connect_to", port_name);
   p.set("properties_file", properties_file);
+  // Start muted, the initial gain and position may only be applied later
+  // (e.g. when the end of a transaction is reached), see below.
+  p.set("mute", true);
   id_t id;
 
   try
@@ -1419,6 +1430,20 @@ Controller<Renderer>::delete_all_sources()
   _renderer.wait_for_rt_thread();
 }
 
+template<typename Renderer>
+void
+Controller<Renderer>::begin_transaction()
+{
+  _publish(&Subscriber::begin_transaction);
+}
+
+template<typename Renderer>
+void
+Controller<Renderer>::end_transaction()
+{
+  _publish(&Subscriber::end_transaction);
+}
+
 template<typename Renderer>
 void
 Controller<Renderer>::delete_source(id_t id)
@@ -1725,6 +1750,10 @@ Controller<Renderer>::_add_position(Node& node
   Node position_node = node.new_child("position");
   position_node.new_attribute("x", apf::str::A2S(position.x));
   position_node.new_attribute("y", apf::str::A2S(position.y));
+  if (position.z != 0)
+  {
+    position_node.new_attribute("z", apf::str::A2S(position.z));
+  }
   if (fixed)
   {
     position_node.new_attribute("fixed", apf::str::A2S(fixed));
@@ -0,0 +1,320 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// Shared cache of impulse responses prepared for convolution.
+
+#ifndef SSR_FILTERCACHE_H
+#define SSR_FILTERCACHE_H
+
+#include <string>
+#include <map>
+#include <memory>  // for std::shared_ptr, std::weak_ptr
+#include <mutex>
+#include <tuple>  // for std::tie()
+#include <cstdlib>  // for realpath(), free()
+#include <algorithm>  // for std::max_element()
+#include <cmath>  // for std::abs()
+#include <cstdint>  // for uint64_t
+#include <sstream>  // for std::ostringstream
+#include <stdexcept>  // for std::logic_error
+#include <sys/stat.h>  // for mkdir()
+
+#include "apf/nonuniform_convolver.h"  // for apf::conv::nonuniform::*
+#include "apf/container.h"  // for apf::fixed_matrix
+#include "apf/sndfiletools.h"  // for apf::load_sndfile
+#include "apf/stringtools.h"  // for apf::str::A2S()
+#include "filterfile.h"  // for FilterSet, FilterFile
+#include "ssr_global.h"  // for WARNING(), VERBOSE()
+
+namespace ssr
+{
+
+/** Process-wide cache of FilterSet%s.
+ * Sources and renderers using the same sound file (with the same sample rate,
+ * block size, length and partitioning) share one read-only copy of the
+ * transformed impulse responses.
+ * Only weak references are stored, a FilterSet is freed as soon as the last
+ * user releases it.
+ * Optionally, transformed impulse responses are stored on disk (see
+ * FilterFile), which makes loading much faster next time.
+ * @note get() is thread-safe, but it must not be called from the audio thread.
+ **/
+class FilterCache
+{
+  public:
+    /// Parameters which determine the contents of a FilterSet
+    struct Key
+    {
+      std::string filename;
+      size_t sample_rate;
+      size_t block_size;
+      size_t size;  ///< Maximum number of samples, 0 means all
+      size_t partitions;  ///< see apf::conv::nonuniform::Layout
+      size_t max_block_size;  ///< see apf::conv::nonuniform::Layout
+
+      bool operator<(const Key& other) const
+      {
+        return std::tie(filename, sample_rate, block_size, size, partitions
+            , max_block_size) < std::tie(other.filename, other.sample_rate
+            , other.block_size, other.size, other.partitions
+            , other.max_block_size);
+      }
+    };
+
+    using pointer = std::shared_ptr<const FilterSet>;
+
+    static pointer get(Key key, const std::string& directory = "");
+    static std::shared_ptr<FilterSet> prepare(const Key& key);
+
+  private:
+    static pointer _load(const Key& key, const std::string& directory);
+    static bool _matches(const FilterFile::Info& info, const Key& key);
+    static std::string _cache_name(const Key& key
+        , const std::string& directory);
+};
+
+/** Get a FilterSet, load and transform the sound file only if needed.
+ * @p key.filename may also be the name of a filter file (see FilterFile).
+ * @param key filter parameters, see Key
+ * @param directory if non-empty, filter files are stored there and re-used
+ *   (until the sound file changes) to speed up loading.
+ * @throw std::logic_error if the file cannot be loaded
+ **/
+inline FilterCache::pointer
+FilterCache::get(Key key, const std::string& directory)
+{
+  // Use the canonical path, different spellings should use the same entry
+  if (char* path = realpath(key.filename.c_str(), nullptr))
+  {
+    key.filename = path;
+    free(path);
+  }
+
+  static std::mutex mutex;
+  static std::map<Key, std::weak_ptr<const FilterSet>> cache;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // Remove stale entries
+  for (auto it = cache.begin(); it != cache.end(); )
+  {
+    if (it->second.expired())
+    {
+      it = cache.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  auto& entry = cache[key];
+  auto result = entry.lock();
+  if (!result)
+  {
+    result = _load(key, directory);
+    entry = result;
+  }
+  return result;
+}
+
+/** Load sound file and transform it to the frequency domain.
+ * The cache is bypassed, this is also used to create filter files.
+ * @throw std::logic_error if the file cannot be loaded
+ **/
+inline std::shared_ptr<FilterSet>
+FilterCache::prepare(const Key& key)
+{
+  auto file = apf::load_sndfile(key.filename, key.sample_rate, 0);
+
+  const size_t channels = file.channels();
+
+  auto parameters = FilterSet::Parameters();
+  parameters.sample_rate = size_t(file.samplerate());
+  parameters.frames = size_t(file.frames());
+  parameters.size = parameters.frames;
+  if (key.size != 0) parameters.size = std::min(parameters.size, key.size);
+
+  // Deinterleave channels and transform to FFT domain
+
+  auto transpose = apf::fixed_matrix<float>(parameters.size, channels);
+
+  parameters.size = size_t(file.readf(transpose.data(), parameters.size));
+  parameters.block_size = key.block_size;
+  parameters.partitions = key.partitions;
+  parameters.max_block_size = key.max_block_size;
+
+  auto result = std::make_shared<FilterSet>(parameters, channels);
+
+  auto temp = apf::conv::nonuniform::Transform(result->layout);
+
+  auto target = result->filters.begin();
+  for (const auto& slice: transpose.slices)
+  {
+    temp.prepare_filter(slice.begin(), slice.end(), *target++);
+  }
+
+  if (channels > 0 && parameters.size > 0)
+  {
+    const auto& first = *transpose.slices.begin();
+    result->peak_index = std::distance(first.begin(), std::max_element(
+          first.begin(), first.end(), [] (float left, float right)
+          {
+            return std::abs(left) < std::abs(right);
+          }));
+  }
+  return result;
+}
+
+inline FilterCache::pointer
+FilterCache::_load(const Key& key, const std::string& directory)
+{
+  auto source = key;  // Sound file which is used if there is no filter file
+
+  if (FilterFile::probe(key.filename))
+  {
+    FilterFile file(key.filename);
+    const auto& info = file.info();
+
+    auto stamp = FileStamp(info.source);
+
+    if (stamp.valid() && stamp != info.source_stamp)
+    {
+      WARNING("\"" << key.filename << "\" is outdated, using \""
+          << info.source << "\" instead.");
+      source.filename = info.source;
+    }
+    else if (_matches(info, key))
+    {
+      VERBOSE("Loading filter file \"" << key.filename << "\".");
+      return file.load();
+    }
+    else if (stamp.valid())
+    {
+      WARNING("\"" << key.filename << "\" was created with different "
+          "settings, using \"" << info.source << "\" instead.");
+      source.filename = info.source;
+    }
+    else
+    {
+      throw std::logic_error("\"" + key.filename + "\" was created with "
+          "different settings (sample rate, block size or partitions) and \""
+          + info.source + "\" is not available!");
+    }
+  }
+
+  auto stamp = FileStamp(source.filename);
+  auto cache_name = std::string();
+
+  if (!directory.empty() && stamp.valid())
+  {
+    cache_name = _cache_name(source, directory);
+
+    if (FilterFile::probe(cache_name))
+    {
+      try
+      {
+        FilterFile file(cache_name);
+        const auto& info = file.info();
+        if (info.source == source.filename && info.source_stamp == stamp
+            && _matches(info, source))
+        {
+          VERBOSE("Loading cached filters for \"" << source.filename
+              << "\" from \"" << cache_name << "\".");
+          return file.load();
+        }
+      }
+      catch (const std::logic_error& e)
+      {
+        WARNING(e.what());
+      }
+    }
+  }
+
+  auto result = prepare(source);
+
+  if (!cache_name.empty())
+  {
+    mkdir(directory.c_str(), 0755);  // Errors are reported by write()
+
+    try
+    {
+      FilterFile::write(cache_name, *result, source.filename, stamp);
+    }
+    catch (const std::logic_error& e)
+    {
+      WARNING(e.what());
+    }
+  }
+  return result;
+}
+
+/// Check if the contents of a filter file can be used for @p key
+inline bool
+FilterCache::_matches(const FilterFile::Info& info, const Key& key)
+{
+  const auto& p = info.parameters;
+  return (key.sample_rate == 0 || p.sample_rate == key.sample_rate)
+    && p.block_size == key.block_size
+    && p.partitions == key.partitions
+    && p.max_block_size == key.max_block_size
+    // key.size == 0 means all frames, truncated filters can't be used then
+    && p.size == (key.size ? std::min(p.frames, key.size) : p.frames);
+}
+
+/// Name of the filter file in the cache @p directory
+inline std::string
+FilterCache::_cache_name(const Key& key, const std::string& directory)
+{
+  auto description = key.filename + "|" + apf::str::A2S(key.sample_rate)
+    + "|" + apf::str::A2S(key.block_size) + "|" + apf::str::A2S(key.size)
+    + "|" + apf::str::A2S(key.partitions)
+    + "|" + apf::str::A2S(key.max_block_size);
+
+  // 64-bit FNV-1a hash, std::hash is not guaranteed to be stable
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char ch: description)
+  {
+    hash ^= ch;
+    hash *= 1099511628211ull;
+  }
+
+  auto basename = key.filename.substr(key.filename.find_last_of('/') + 1);
+
+  std::ostringstream name;
+  name << directory << "/" << basename << "-" << std::hex << hash
+    << ".ssrfilter";
+  return name.str();
+}
+
+}  // namespace ssr
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -0,0 +1,440 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// File format for impulse responses which are already transformed to the
+/// frequency domain.
+
+#ifndef SSR_FILTERFILE_H
+#define SSR_FILTERFILE_H
+
+#include <string>
+#include <vector>
+#include <algorithm>  // for std::copy()
+#include <memory>  // for std::shared_ptr
+#include <fstream>
+#include <stdexcept>  // for std::logic_error
+#include <cstring>  // for std::memcpy(), std::memcmp()
+#include <cstdint>  // for uint64_t, ...
+#include <cstdio>  // for std::rename(), std::remove()
+#include <fcntl.h>  // for open(), O_RDONLY
+#include <sys/mman.h>  // for mmap(), munmap()
+#include <sys/stat.h>  // for stat(), fstat()
+#include <unistd.h>  // for close(), getpid()
+
+#include "apf/nonuniform_convolver.h"  // for apf::conv::nonuniform::*
+#include "apf/stringtools.h"  // for apf::str::A2S()
+
+namespace ssr
+{
+
+/** Impulse responses (e.g. HRIRs or BRIRs) of one sound file, transformed to
+ * the frequency domain.
+ * Objects are created by FilterCache and must not be changed afterwards,
+ * because they may be shared by many sources and renderers.
+ **/
+struct FilterSet
+{
+  using filters_t = apf::fixed_vector<apf::conv::nonuniform::Filter>;
+
+  /// Parameters which determine the contents of a FilterSet
+  struct Parameters
+  {
+    size_t sample_rate;  ///< Sample rate of the sound file
+    size_t frames;  ///< Length of the sound file
+    size_t size;  ///< Number of used coefficients (<= frames)
+    size_t block_size;  ///< see apf::conv::nonuniform::Layout
+    size_t partitions;  ///< see apf::conv::nonuniform::Layout
+    size_t max_block_size;  ///< see apf::conv::nonuniform::Layout
+  };
+
+  FilterSet(const Parameters& parameters_, size_t channels)
+    : parameters(parameters_)
+    , layout(parameters.block_size, parameters.size, parameters.partitions
+        , parameters.max_block_size)
+    , filters(channels, layout)
+    , peak_index(0)
+  {}
+
+  size_t channels() const { return filters.size(); }
+
+  const Parameters parameters;
+  const apf::conv::nonuniform::Layout layout;
+  filters_t filters;  ///< One filter per channel of the sound file
+  size_t peak_index;  ///< Index of absolute maximum in first channel
+};
+
+/// Size and modification time of a file, used to detect changes.
+struct FileStamp
+{
+  FileStamp() : size(0), mtime(0) {}
+
+  /// Get stamp of file @p name. If it cannot be accessed, valid() is false.
+  explicit FileStamp(const std::string& name)
+    : FileStamp()
+  {
+    struct stat sb;
+    if (!name.empty() && stat(name.c_str(), &sb) == 0)
+    {
+      this->size = uint64_t(sb.st_size);
+      this->mtime = int64_t(sb.st_mtime);
+    }
+  }
+
+  bool valid() const { return this->mtime != 0; }
+
+  bool operator==(const FileStamp& other) const
+  {
+    return this->size == other.size && this->mtime == other.mtime;
+  }
+
+  bool operator!=(const FileStamp& other) const { return !(*this == other); }
+
+  uint64_t size;
+  int64_t mtime;
+};
+
+/** Memory-mapped filter file.
+ * A filter file contains the (already sorted) FFT partitions of a FilterSet,
+ * including their zero flags, together with all parameters needed to
+ * re-create the partitioning.
+ * Additionally, the name, size and modification time of the original sound
+ * file are stored, which allows detecting outdated filter files.
+ *
+ * File layout (native byte order, which is checked on reading):
+ *   - header (see _Header), followed by the name of the original sound file
+ *   - one zero flag (byte) per partition
+ *   - partition data (floats), channel by channel, segment by segment
+ *
+ * Zero flags and partition data start at multiples of 64 bytes, therefore
+ * the data can be copied (or used) directly with SIMD instructions.
+ **/
+class FilterFile
+{
+  public:
+    /// Contents of the header
+    struct Info
+    {
+      FilterSet::Parameters parameters;
+      size_t channels;
+      size_t peak_index;
+      std::string source;  ///< Name of the original sound file
+      FileStamp source_stamp;  ///< Stamp of original sound file (when written)
+    };
+
+    explicit FilterFile(const std::string& name);
+    ~FilterFile() { munmap(_data, _length); }
+
+    FilterFile(const FilterFile&) = delete;
+    FilterFile& operator=(const FilterFile&) = delete;
+
+    const Info& info() const { return _info; }
+
+    std::shared_ptr<FilterSet> load() const;
+
+    static bool probe(const std::string& name);
+    static void write(const std::string& name, const FilterSet& filters
+        , const std::string& source, const FileStamp& source_stamp);
+
+  private:
+    struct _Header
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t byte_order;
+      uint64_t data_offset;  ///< Position of zero flags
+      uint64_t sample_rate;
+      uint64_t frames;
+      uint64_t size;
+      uint64_t block_size;
+      uint64_t partitions;
+      uint64_t max_block_size;
+      uint64_t channels;
+      uint64_t peak_index;
+      uint64_t source_size;
+      int64_t source_mtime;
+      uint64_t source_name_length;  ///< The name follows the header
+    };
+
+    static const char* _magic() { return "SSRFILT"; }
+    /// 2: tail segments start at least at twice their block size
+    static const uint32_t _version = 2;
+    static const uint32_t _byte_order = 0x01020304;
+    static const size_t _alignment = 64;
+
+    static size_t _align(size_t n)
+    {
+      return (n + _alignment - 1) / _alignment * _alignment;
+    }
+
+    /// Number of partitions of all segments of one channel
+    static size_t _partitions(const apf::conv::nonuniform::Layout& layout)
+    {
+      size_t result = 0;
+      for (const auto& segment: layout) result += segment.partitions;
+      return result;
+    }
+
+    /// Number of floats of all segments of one channel
+    static size_t _floats(const apf::conv::nonuniform::Layout& layout)
+    {
+      size_t result = 0;
+      for (const auto& segment: layout)
+      {
+        result += segment.partitions * 2 * segment.block_size;
+      }
+      return result;
+    }
+
+    const std::string _name;
+    void* _data;
+    size_t _length;
+    Info _info;
+};
+
+/** Open and map filter file.
+ * @throw std::logic_error if @p name is not a valid filter file
+ **/
+inline FilterFile::FilterFile(const std::string& name)
+  : _name(name)
+  , _data(nullptr)
+  , _length(0)
+{
+  int fd = open(_name.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    throw std::logic_error("FilterFile: \"" + _name + "\" couldn't be opened!");
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) == 0 && size_t(sb.st_size) >= sizeof(_Header))
+  {
+    _length = size_t(sb.st_size);
+    _data = mmap(nullptr, _length, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);  // The mapping stays valid
+
+  if (_data == nullptr || _data == MAP_FAILED)
+  {
+    _data = nullptr;  // munmap() in destructor is a no-op then
+    throw std::logic_error("FilterFile: \"" + _name + "\" couldn't be mapped!");
+  }
+
+  auto invalid = [this] (const std::string& reason)
+  {
+    munmap(_data, _length);
+    return std::logic_error("FilterFile: \"" + _name + "\" " + reason);
+  };
+
+  _Header header;
+  std::memcpy(&header, _data, sizeof(_Header));
+
+  if (std::memcmp(header.magic, _magic(), sizeof(header.magic)) != 0)
+  {
+    throw invalid("is not a filter file!");
+  }
+  if (header.version != _version || header.byte_order != _byte_order)
+  {
+    throw invalid("has an unsupported version or byte order!");
+  }
+  if (sizeof(_Header) + header.source_name_length > _length)
+  {
+    throw invalid("is truncated!");
+  }
+
+  _info.parameters.sample_rate = size_t(header.sample_rate);
+  _info.parameters.frames = size_t(header.frames);
+  _info.parameters.size = size_t(header.size);
+  _info.parameters.block_size = size_t(header.block_size);
+  _info.parameters.partitions = size_t(header.partitions);
+  _info.parameters.max_block_size = size_t(header.max_block_size);
+  _info.channels = size_t(header.channels);
+  _info.peak_index = size_t(header.peak_index);
+  _info.source.assign(static_cast<const char*>(_data) + sizeof(_Header)
+      , size_t(header.source_name_length));
+  _info.source_stamp.size = header.source_size;
+  _info.source_stamp.mtime = header.source_mtime;
+
+  if (_info.parameters.block_size == 0 || _info.parameters.size == 0)
+  {
+    throw invalid("has invalid parameters!");
+  }
+
+  auto layout = apf::conv::nonuniform::Layout(_info.parameters.block_size
+      , _info.parameters.size, _info.parameters.partitions
+      , _info.parameters.max_block_size);
+
+  size_t flags_size = _align(_info.channels * _partitions(layout));
+  size_t data_size = _info.channels * _floats(layout) * sizeof(float);
+
+  if (header.data_offset % _alignment != 0
+      || header.data_offset + flags_size + data_size != _length)
+  {
+    throw invalid("has the wrong size!");
+  }
+}
+
+/** Copy the contents of the filter file to a newly created FilterSet.
+ * No FFTs are necessary and the data is read only once.
+ **/
+inline std::shared_ptr<FilterSet>
+FilterFile::load() const
+{
+  auto result = std::make_shared<FilterSet>(_info.parameters, _info.channels);
+  result->peak_index = _info.peak_index;
+
+  auto header = _Header();
+  std::memcpy(&header, _data, sizeof(_Header));
+
+  madvise(_data, _length, MADV_SEQUENTIAL);
+
+  auto flags = static_cast<const uint8_t*>(_data) + header.data_offset;
+  auto data = reinterpret_cast<const float*>(
+      flags + _align(_info.channels * _partitions(result->layout)));
+
+  for (auto& filter: result->filters)
+  {
+    for (auto& segment: filter)
+    {
+      for (auto& partition: segment)
+      {
+        partition.zero = (*flags++ != 0);
+        if (!partition.zero)
+        {
+          std::copy(data, data + partition.size(), partition.begin());
+        }
+        data += partition.size();
+      }
+    }
+  }
+  return result;
+}
+
+/// Check if @p name is (probably) a filter file.
+inline bool
+FilterFile::probe(const std::string& name)
+{
+  char magic[8] = {};
+  std::ifstream file(name, std::ios::binary);
+  return file.read(magic, sizeof(magic))
+    && std::memcmp(magic, _magic(), sizeof(magic)) == 0;
+}
+
+/** Write FilterSet to a file.
+ * The data is first written to a temporary file which is renamed afterwards,
+ * therefore other processes never see an incomplete file.
+ * @param name name of the file to be written
+ * @param filters filter data
+ * @param source name of the original sound file
+ * @param source_stamp size and modification time of @p source
+ * @throw std::logic_error if the file cannot be written
+ **/
+inline void
+FilterFile::write(const std::string& name, const FilterSet& filters
+    , const std::string& source, const FileStamp& source_stamp)
+{
+  auto header = _Header();
+  std::memcpy(header.magic, _magic(), sizeof(header.magic));
+  header.version = _version;
+  header.byte_order = _byte_order;
+  header.data_offset = _align(sizeof(_Header) + source.size());
+  header.sample_rate = filters.parameters.sample_rate;
+  header.frames = filters.parameters.frames;
+  header.size = filters.parameters.size;
+  header.block_size = filters.parameters.block_size;
+  header.partitions = filters.parameters.partitions;
+  header.max_block_size = filters.parameters.max_block_size;
+  header.channels = filters.channels();
+  header.peak_index = filters.peak_index;
+  header.source_size = source_stamp.size;
+  header.source_mtime = source_stamp.mtime;
+  header.source_name_length = source.size();
+
+  const auto temp_name = name + ".tmp" + apf::str::A2S(getpid());
+
+  std::ofstream file(temp_name, std::ios::binary | std::ios::trunc);
+
+  auto padding = [&file] ()
+  {
+    static const char zeros[_alignment] = {};
+    file.write(zeros, std::streamsize(_align(size_t(file.tellp()))
+          - size_t(file.tellp())));
+  };
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(_Header));
+  file.write(source.data(), std::streamsize(source.size()));
+  padding();
+
+  for (const auto& filter: filters.filters)
+  {
+    for (const auto& segment: filter)
+    {
+      for (const auto& partition: segment)
+      {
+        file.put(partition.zero ? 1 : 0);
+      }
+    }
+  }
+  padding();
+
+  for (const auto& filter: filters.filters)
+  {
+    for (const auto& segment: filter)
+    {
+      for (const auto& partition: segment)
+      {
+        if (partition.zero)
+        {
+          // The buffer content is undefined, write zeros instead
+          auto zeros = std::vector<float>(partition.size());
+          file.write(reinterpret_cast<const char*>(zeros.data())
+              , std::streamsize(zeros.size() * sizeof(float)));
+        }
+        else
+        {
+          file.write(reinterpret_cast<const char*>(partition.data())
+              , std::streamsize(partition.size() * sizeof(float)));
+        }
+      }
+    }
+  }
+
+  file.close();
+
+  if (!file || std::rename(temp_name.c_str(), name.c_str()) != 0)
+  {
+    std::remove(temp_name.c_str());
+    throw std::logic_error("FilterFile: \"" + name + "\" couldn't be written!");
+  }
+}
+
+}  // namespace ssr
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
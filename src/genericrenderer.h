@@ -32,9 +32,9 @@
 
 #include "loudspeakerrenderer.h"
 
-#include "apf/convolver.h"  // for apf::conv::*
-#include "apf/sndfiletools.h"  // for apf::load_sndfile
+#include "apf/nonuniform_convolver.h"  // for apf::conv::nonuniform::*
 #include "apf/combine_channels.h"  // for apf::raised_cosine_fade, ...
+#include "filtercache.h"  // for FilterCache
 
 namespace ssr
 {
@@ -53,10 +53,12 @@ class GenericRenderer : public SourceToOutput<GenericRenderer
     struct SourceChannel;
     class Output;
     class RenderFunction;
+    class AccumulateFunction;
 
     GenericRenderer(const apf::parameter_map& params)
       : _base(params)
       , _fade(this->block_size())
+      , _frequency_domain(params.get("frequency_domain_accumulation", false))
     {}
 
     APF_PROCESS(GenericRenderer, _base)
@@ -66,12 +68,12 @@ class GenericRenderer : public SourceToOutput<GenericRenderer
 
   private:
     apf::raised_cosine_fade<sample_type> _fade;
+    bool _frequency_domain;  // accumulate outputs in frequency domain
 };
 
 struct GenericRenderer::SourceChannel : apf::has_begin_and_end<sample_type*>
 {
-  template<typename In>
-  explicit SourceChannel(const Source& s, In first, In last);
+  SourceChannel(const Source& s, const apf::conv::nonuniform::Filter& filter);
 
   // out-of-class definition because of cyclic dependencies with Source
   void update();
@@ -79,7 +81,7 @@ struct GenericRenderer::SourceChannel : apf::has_begin_and_end<sample_type*>
 
   const Source& source;
 
-  apf::conv::StaticOutput convolver;
+  apf::conv::nonuniform::StaticOutput convolver;
 };
 
 class GenericRenderer::Source : public _base::Source
@@ -89,33 +91,29 @@ class GenericRenderer::Source : public _base::Source
       : _base::Source(p)
       , _weighting_factor()
     {
-      using matrix_t = apf::fixed_matrix<sample_type>;
-
       size_t outputs = this->parent.get_output_list().size();
 
-      auto ir_file = apf::load_sndfile(
-          p.get<std::string>("properties_file"), this->parent.sample_rate()
-          , outputs);
-
-      size_t size = ir_file.frames();
-
-      auto ir_data = matrix_t(size, outputs);
-
-      // TODO: check return value?
-      ir_file.readf(ir_data.data(), size);
+      _filters = FilterCache::get({p.get<std::string>("properties_file")
+          , size_t(this->parent.sample_rate())
+          , size_t(this->parent.block_size()), 0
+          , this->parent.params.get("nonuniform_partitions", 0u)
+          , this->parent.params.get("nonuniform_max_block_size", 0u)}
+          , this->parent.params.get("filter_cache_dir", ""));
 
-      size_t block_size = this->parent.block_size();
+      if (_filters->channels() != outputs)
+      {
+        throw std::logic_error("\"" + p.get<std::string>("properties_file")
+            + "\" has " + apf::str::A2S(_filters->channels())
+            + " channels instead of " + apf::str::A2S(outputs) + "!");
+      }
 
-      _convolver.reset(new apf::conv::Input(block_size
-            , apf::conv::min_partitions(block_size, size)));
+      _convolver.reset(new apf::conv::nonuniform::Input(_filters->layout));
 
       this->sourcechannels.reserve(outputs);
 
-      for (matrix_t::slices_iterator slice = ir_data.slices.begin()
-          ; slice != ir_data.slices.end()
-          ; slice++)
+      for (const auto& filter: _filters->filters)
       {
-        this->sourcechannels.emplace_back(*this, slice->begin(), slice->end());
+        this->sourcechannels.emplace_back(*this, filter);
       }
     }
 
@@ -128,17 +126,33 @@ class GenericRenderer::Source : public _base::Source
       assert(_weighting_factor.exactly_one_assignment());
     }
 
+    apf::CombineChannelsResult::type crossfade_mode() const
+    {
+      using namespace apf::CombineChannelsResult;
+
+      if (_weighting_factor.both() == 0) return nothing;
+
+      if (_weighting_factor.old() == 0) return fade_in;
+
+      if (_weighting_factor == 0) return fade_out;
+
+      if (!_weighting_factor.changed()) return constant;
+
+      return change;
+    }
+
     apf::BlockParameter<sample_type> _weighting_factor;
 
-    std::unique_ptr<apf::conv::Input> _convolver;
+    std::unique_ptr<apf::conv::nonuniform::Input> _convolver;
+
+    FilterCache::pointer _filters;  // shared with other sources
 };
 
-template<typename In>
 GenericRenderer::SourceChannel::SourceChannel(const Source& s
-    , In first, In last)
+    , const apf::conv::nonuniform::Filter& filter)
   : source(s)
   // TODO: assert s._convolver != 0?
-  , convolver(*s._convolver, first, last)
+  , convolver(*s._convolver, filter)
 {}
 
 void GenericRenderer::SourceChannel::update()
@@ -162,27 +176,51 @@ class GenericRenderer::RenderFunction
     {
       _in = & in;
 
-      const auto& factor = in.source._weighting_factor;
-
       using namespace apf::CombineChannelsResult;
 
-      if (factor.both() == 0) return nothing;
+      auto mode = in.source.crossfade_mode();
 
-      if (factor.old() == 0) return fade_in;
+      if (mode != nothing && mode != fade_in)
+      {
+        in.convolve(in.source._weighting_factor.old());
+      }
+      return mode;
+    }
 
-      in.convolve(factor.old());
+    void update()
+    {
+      assert(_in);
+      _in->update();
+    }
 
-      if (factor == 0) return fade_out;
+  private:
+    SourceChannel* _in;
+};
 
-      if (!factor.changed()) return constant;
+/// Like RenderFunction, but for frequency-domain accumulation
+class GenericRenderer::AccumulateFunction
+{
+  public:
+    AccumulateFunction() : _in(0) {}
 
-      return change;
+    apf::CombineChannelsResult::type select(SourceChannel& in)
+    {
+      _in = & in;
+      return in.source.crossfade_mode();
     }
 
-    void update()
+    void accumulate(apf::conv::nonuniform::Accumulator& target)
     {
       assert(_in);
-      _in->update();
+      _in->convolver.accumulate(target, _in->source._weighting_factor);
+    }
+
+    void accumulate(apf::conv::nonuniform::Accumulator& target
+        , apf::fade_out_tag)
+    {
+      assert(_in);
+      _in->convolver.accumulate(target
+          , _in->source._weighting_factor.old());
     }
 
   private:
@@ -195,17 +233,36 @@ class GenericRenderer::Output : public _base::Output
     Output(const Params& p)
       : _base::Output(p)
       , _combiner(this->sourcechannels, this->buffer, this->parent._fade)
-    {}
+    {
+      if (this->parent._frequency_domain)
+      {
+        _accumulator.reset(new accumulator_t(this->sourcechannels
+              , this->buffer, this->parent._fade));
+      }
+    }
 
     APF_PROCESS(Output, _base::Output)
     {
-      _combiner.process(RenderFunction());
+      if (_accumulator)
+      {
+        _accumulator->process(AccumulateFunction());
+      }
+      else
+      {
+        _combiner.process(RenderFunction());
+      }
     }
 
   private:
+    using accumulator_t = apf::CombineChannelsCrossfadeAccumulate<
+      apf::cast_proxy<SourceChannel, sourcechannels_t>, buffer_type
+      , apf::raised_cosine_fade<sample_type>
+      , apf::conv::nonuniform::Accumulator>;
+
     apf::CombineChannelsCrossfadeCopy<apf::cast_proxy<SourceChannel
       , sourcechannels_t>, buffer_type
       , apf::raised_cosine_fade<sample_type>> _combiner;
+    std::unique_ptr<accumulator_t> _accumulator;
 };
 
 }  // namespace ssr
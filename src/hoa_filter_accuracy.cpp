@@ -0,0 +1,174 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// Offline accuracy test of single precision NFC-HOA filters.
+///
+/// The mode filters of the NFC-HOA renderer are computed in double precision
+/// (apf::CascadeBank) and in single precision (apf::LatticeBank, see
+/// NfcHoaRenderer::single_precision). For comparison, single precision Direct
+/// Form II filters with coefficients designed in single and double precision
+/// are shown as well. The error (relative to the double precision filter) is
+/// printed for each mode number. The test fails if the error of the single
+/// precision lattice filters exceeds the given limit.
+
+#include <iostream>
+#include <iomanip>  // for std::setw()
+#include <vector>
+#include <array>
+#include <cmath>  // for std::log10(), std::sqrt()
+#include <algorithm>  // for std::max()
+#include <memory>  // for std::unique_ptr
+#include <stdexcept>  // for std::logic_error
+
+#include "apf/biquad.h"
+#include "hoacoefficients.h"
+
+using ssr::HoaCoefficients;
+
+namespace
+{
+
+const size_t sample_rate = 44100;
+const float array_radius = 1.5f;
+const float speed_of_sound = 343.0f;
+
+// maximum error (in dB, relative to RMS of the double precision output)
+const double error_limit = -90.0;
+
+template<typename Bank, typename T>
+std::vector<float> filter(const std::vector<float>& input
+    , const HoaCoefficients<T>& coefficients)
+{
+  Bank bank(coefficients.size());
+  bank.set(0, coefficients.begin(), coefficients.end());
+  auto output = std::vector<float>(input.size());
+  bank.execute(input.begin(), input.end()
+      , std::array<float*, 1>{{output.data()}});
+  return output;
+}
+
+// Error in dB relative to RMS value of the reference
+double error(const std::vector<float>& reference
+    , const std::vector<float>& output)
+{
+  double signal = 0, noise = 0;
+  for (size_t i = 0; i < reference.size(); ++i)
+  {
+    signal += double(reference[i]) * double(reference[i]);
+    double difference = double(output[i]) - double(reference[i]);
+    noise += difference * difference;
+  }
+  // limit to -200 dB (e.g. for mode 0, which is not filtered at all)
+  return 10 * std::log10(std::max(noise / signal, 1e-20));
+}
+
+}  // unnamed namespace
+
+int main()
+{
+  // white noise (with a simple linear congruential generator)
+  auto input = std::vector<float>(2 * sample_rate);
+  unsigned int state = 1;
+  for (auto& sample: input)
+  {
+    state = state * 1664525u + 1013904223u;
+    sample = float(state) / 4294967296.0f - 0.5f;
+  }
+
+  struct Case { float distance; HoaCoefficients<double>::source_t type; };
+  const Case cases[] = {
+    { array_radius, HoaCoefficients<double>::point_source },
+    { 3.0f, HoaCoefficients<double>::point_source },
+    { 30.0f, HoaCoefficients<double>::point_source },
+    { 1.0f, HoaCoefficients<double>::plane_wave },
+  };
+
+  bool success = true;
+
+  for (const auto& c: cases)
+  {
+    if (c.type == HoaCoefficients<double>::point_source)
+    {
+      std::cout << "\nPoint source at " << c.distance << " m";
+    }
+    else
+    {
+      std::cout << "\nPlane wave";
+    }
+    std::cout << ", error in dB:\n\n"
+      "  mode  DF (float design)  DF (double design)  lattice\n";
+
+    for (size_t mode = 0; ; ++mode)
+    {
+      auto coeffs_double = std::unique_ptr<HoaCoefficients<double>>();
+      auto coeffs_float = std::unique_ptr<HoaCoefficients<float>>();
+      try
+      {
+        coeffs_double.reset(new HoaCoefficients<double>(mode, sample_rate
+              , array_radius, speed_of_sound));
+        coeffs_float.reset(new HoaCoefficients<float>(mode, sample_rate
+              , array_radius, speed_of_sound));
+      }
+      catch (std::logic_error&)
+      {
+        break;  // highest supported order
+      }
+      coeffs_double->reset(std::max(c.distance, array_radius), c.type);
+      coeffs_float->reset(std::max(c.distance, array_radius)
+          , HoaCoefficients<float>::source_t(c.type));
+
+      auto reference = filter<apf::CascadeBank<double, 1>>(input
+          , *coeffs_double);
+      double df_float = error(reference
+          , filter<apf::CascadeBank<float, 1>>(input, *coeffs_float));
+      double df_double = error(reference
+          , filter<apf::CascadeBank<float, 1>>(input, *coeffs_double));
+      double lattice = error(reference
+          , filter<apf::LatticeBank<float, 1>>(input, *coeffs_double));
+
+      std::cout << std::fixed << std::setprecision(1)
+        << std::setw(6) << mode
+        << std::setw(19) << df_float
+        << std::setw(20) << df_double
+        << std::setw(9) << lattice << "\n";
+
+      if (!(lattice < error_limit)) success = false;
+    }
+  }
+
+  if (!success)
+  {
+    std::cout << "\nError of lattice filters is above " << error_limit
+      << " dB!" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
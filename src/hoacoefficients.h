@@ -34,6 +34,7 @@
 
 #include "apf/biquad.h"
 #include "apf/iterator.h"
+#include "apf/stringtools.h"  // for apf::str::A2S()
 
 namespace ssr
 {
@@ -151,10 +152,25 @@ class HoaCoefficients : public std::vector<apf::SosCoefficients<T>>
           c.a2 = row[1] * std::pow(_scale_factor_two, two);
 
           // TODO: make prewarping frequency an (optional) parameter?
-          return apf::bilinear(c, _sample_rate, 1000);
+          auto result = apf::bilinear(c, _sample_rate, 1000);
+
+          // First order sections (and the "section" of order 0) have a
+          // common factor s in numerator and denominator, which leads to
+          // poles on the unit circle. They are cancelled with the zeros,
+          // otherwise the filter states would grow without bounds.
+          if (row[1] == 0) result = _cancel_dc(result);
+          if (row[0] == 0) result = _cancel_dc(result);
+
+          return result;
         }
 
       private:
+        /// Remove common factor (1 - z^-1) from numerator and denominator.
+        static result_type _cancel_dc(const result_type& c)
+        {
+          return result_type(c.b0, -c.b2, 0, -c.a2, 0);
+        }
+
         const T _scale_factor_one, _scale_factor_two;
         const source_t _source_type;
         const size_t _sample_rate;
@@ -428,13 +428,17 @@ LoudspeakerRenderer<Derived>::_get_position(const Node& node)
   {
     if (i == "position")
     {
-      float x, y;
+      float x, y, z = 0.0f;
+
+      // z is optional (only used for 3-D loudspeaker setups)
+      std::string z_string = i.get_attribute("z");
 
       // if read operation successful
       if (apf::str::S2A(i.get_attribute("x"), x)
-          && apf::str::S2A(i.get_attribute("y"), y))
+          && apf::str::S2A(i.get_attribute("y"), y)
+          && (z_string == "" || apf::str::S2A(z_string, z)))
       {
-        temp.reset(new Position(x, y));
+        temp.reset(new Position(x, y, z));
         return temp; // return sucessfully
       }
       else
@@ -0,0 +1,190 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+/// @file
+/// Throughput of the network Server with several threads and clients.
+///
+/// Each client sends many pipelined position requests (like a head-tracker)
+/// over its own TCP connection.  The Server is started with 1, 2, 4, ...
+/// network threads and the time until all requests reached the Publisher is
+/// measured.  Calls to the Publisher are serialized (see
+/// SynchronizedPublisher), receiving and parsing of requests is not.
+/// Usage: network-benchmark [clients [messages per client [port]]]
+
+#include <algorithm>  // for std::max()
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "apf/stringtools.h"  // for S2A(), A2S()
+#include "publisher.h"
+#include "server.h"
+
+using apf::str::S2A;
+using apf::str::A2S;
+
+namespace
+{
+
+/// Counts changes, everything else is ignored
+struct CountingPublisher : ssr::Publisher
+{
+  std::atomic<size_t> changes{0};
+
+  virtual bool load_scene(const std::string&) { return true; }
+  virtual bool save_scene_as_XML(const std::string&) const { return true; }
+  virtual void start_processing() {}
+  virtual void stop_processing() {}
+  virtual void new_source(const std::string&, Source::model_t
+      , const std::string&, int, const Position&, const bool
+      , const Orientation&, const bool, const float, const bool
+      , const std::string&) {}
+  virtual void begin_transaction() {}
+  virtual void end_transaction() {}
+  virtual void delete_source(ssr::id_t) {}
+  virtual void delete_all_sources() {}
+  virtual void set_source_position(ssr::id_t, const Position&) { ++changes; }
+  virtual void set_source_orientation(ssr::id_t, const Orientation&) {}
+  virtual void set_source_gain(ssr::id_t, float) {}
+  virtual void set_source_mute(ssr::id_t, bool) {}
+  virtual void set_source_signal_level(const ssr::id_t, const float) {}
+  virtual void set_source_name(ssr::id_t, const std::string&) {}
+  virtual void set_source_properties_file(ssr::id_t, const std::string&) {}
+  virtual void set_source_model(ssr::id_t, Source::model_t) {}
+  virtual void set_source_port_name(ssr::id_t, const std::string&) {}
+  virtual void set_source_position_fixed(ssr::id_t, const bool) {}
+  virtual void set_reference_position(const Position&) {}
+  virtual void set_reference_orientation(const Orientation&) {}
+  virtual void set_reference_offset_position(const Position&) {}
+  virtual void set_reference_offset_orientation(const Orientation&) {}
+  virtual void set_master_volume(float) {}
+  virtual void set_amplitude_reference_distance(float) {}
+  virtual void set_master_signal_level(float) {}
+  virtual void set_cpu_load(const float) {}
+  virtual void publish_sample_rate(const int) {}
+  virtual std::string get_renderer_name() const { return ""; }
+  virtual bool show_head() const { return false; }
+  virtual void transport_start() {}
+  virtual void transport_stop() {}
+  virtual bool transport_locate(float) { return true; }
+  virtual void calibrate_client() {}
+  virtual void set_processing_state(bool) {}
+  virtual void subscribe(ssr::Subscriber*) {}
+  virtual void unsubscribe(ssr::Subscriber*) {}
+  virtual std::string get_scene_as_XML() const { return "<update/>"; }
+};
+
+/// Messages/s of all clients together with the given number of threads
+double run(int threads, int port, size_t clients, size_t messages)
+{
+  using boost::asio::ip::tcp;
+
+  CountingPublisher publisher;
+  ssr::Server server(publisher, port, 0, threads);
+  server.start();
+
+  std::vector<std::string> buffers(clients);
+  for (size_t c = 0; c < clients; ++c)
+  {
+    for (size_t i = 0; i < messages; ++i)
+    {
+      buffers[c] += "<request><source id='" + A2S(c + 1)
+        + "'><position x='" + A2S(i % 1000) + ".25' y='-2.5"
+        + A2S(i % 100) + "'/></source></request>";
+      buffers[c] += '\0';
+    }
+  }
+
+  boost::asio::io_service io_service;
+  std::vector<tcp::socket> sockets;
+  for (size_t c = 0; c < clients; ++c)
+  {
+    sockets.emplace_back(io_service);
+    sockets.back().connect(tcp::endpoint(
+          boost::asio::ip::address_v4::loopback(), port));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> senders;
+  for (size_t c = 0; c < clients; ++c)
+  {
+    senders.emplace_back([&sockets, &buffers, c] ()
+    {
+      boost::asio::write(sockets[c], boost::asio::buffer(buffers[c]));
+    });
+  }
+  for (auto& sender: senders) sender.join();
+
+  while (publisher.changes < clients * messages)
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  auto time = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  server.stop();
+  return double(clients * messages) / time;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  size_t clients = 8, messages = 50000;
+  int port = 4712;
+  if ((argc > 1 && !S2A(argv[1], clients))
+      || (argc > 2 && !S2A(argv[2], messages))
+      || (argc > 3 && !S2A(argv[3], port)))
+  {
+    std::cerr << "Usage: " << argv[0]
+      << " [clients [messages per client [port]]]\n";
+    return 1;
+  }
+
+  auto cores = std::max(1u, std::thread::hardware_concurrency());
+  std::cout << clients << " clients, " << messages << " messages each, "
+    << cores << " CPU core(s)\n";
+
+  double single = 0;
+  for (unsigned threads = 1; threads <= std::max(4u, cores); threads *= 2)
+  {
+    auto throughput = run(int(threads), port, clients, messages);
+    if (threads == 1) single = throughput;
+    std::cout << threads << " thread(s): " << throughput << " messages/s"
+      << " (" << throughput / single << "x)" << std::endl;
+  }
+  return 0;
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -30,6 +30,8 @@
 #ifndef SSR_NFCHOARENDERER_H
 #define SSR_NFCHOARENDERER_H
 
+#include <array>
+
 #include "apf/math.h"  // for apf::math::linear_interpolator
 #include "apf/fftwtools.h"  // for apf::fftw, apf::fftw_allocator
 #include "apf/iterator.h"  // for apf::dual_iterator, apf::discard_iterator, ...
@@ -51,14 +53,17 @@ class NfcHoaRenderer : public LoudspeakerRenderer<NfcHoaRenderer>
   public:
     static const char* name() { return "NFC-HOA-Renderer"; }
 
-    using matrix_t = apf::fixed_matrix<sample_type>;
-    using fft_matrix_t
+    using matrix_t
       = apf::fixed_matrix<sample_type, apf::fftw_allocator<sample_type>>;
-    using filter_type = apf::Cascade<apf::BiQuad<double, apf::dp::ac>>;
+    /// Mode filters in double precision (one SIMD lane per Mode)
+    using filter_type = apf::CascadeBank<double, 4, apf::dp::ac>;
+    /// Mode filters in single precision, see #single_precision
+    using float_filter_type = apf::LatticeBank<float, 8, apf::dp::ac>;
 
     class Source;
     class Mode;
-    class ModePair;
+    struct ModeGroupBase;
+    template<typename Filter> class ModeGroup;
     struct ModeAccumulatorBase;
     template<typename I1, typename I2> class ModeAccumulator;
     class FftProcessor;
@@ -67,30 +72,45 @@ class NfcHoaRenderer : public LoudspeakerRenderer<NfcHoaRenderer>
 
     NfcHoaRenderer(const apf::parameter_map& params)
       : _base(params)
-      , _mode_pair_list(_fifo)
+      , update_interval(params.get("hoa_update_interval", 1u))
+      , single_precision(params.get("hoa_single_precision", false))
+      , _mode_group_list(_fifo)
       , _mode_accumulator_list(_fifo)
       , _fft_list(_fifo)
-    {}
+    {
+      // 0 means: no interpolation within a block
+      if (update_interval == 0
+          || update_interval > size_t(this->block_size()))
+      {
+        update_interval = this->block_size();
+      }
+    }
 
     APF_PROCESS(NfcHoaRenderer, _base)
     {
-      this->_process_list(_source_list);
-      this->_process_list(_mode_pair_list);
-      this->_process_list(_mode_accumulator_list);
-
-      _fft_matrix.set_channels(_mode_matrix.slices);  // transpose matrix
+      // Each ModeGroup waits only for its Source and each ModeAccumulator
+      // waits only for the ModeGroups it uses, not for the whole list.
+      this->_process_graph(_source_list, _mode_group_list
+          , _mode_accumulator_list);
 
+      // The FFTs work in-place on the columns of the mode matrix, afterwards
+      // each channel holds the signal of one loudspeaker.
       this->_process_list(_fft_list);
     }
 
     void load_reproduction_setup();
     size_t order;  // Ambisonics order
     float array_radius;
+    /// Number of samples after which the filter coefficients are updated
+    /// while the source distance changes.
+    size_t update_interval;
+    /// Use single precision filters (twice as many Mode%s per SIMD register).
+    /// Lattice filters are used, which are stable even at low frequencies.
+    bool single_precision;
 
   private:
     matrix_t _mode_matrix;
-    fft_matrix_t _fft_matrix;
-    rtlist_t _mode_pair_list, _mode_accumulator_list, _fft_list;
+    rtlist_t _mode_group_list, _mode_accumulator_list, _fft_list;
 };
 
 class NfcHoaRenderer::Source : public _base::Source
@@ -154,106 +174,88 @@ class NfcHoaRenderer::Source : public _base::Source
     apf::BlockParameter<coeff_t::source_t> source_model;
 
   private:
+    template<typename Filter> void _create_mode_groups();
+
     // Pointers to Mode objects for (dis-)connecting
     std::list<const Mode*> _modes;
-    // Pointers to ModePair objects for removing when Source is deleted
-    std::list<ModePair*> _mode_pairs;
+    // Pointers to ModeGroup objects for removing when Source is deleted
+    std::list<ModeGroupBase*> _mode_groups;
 };
 
-class NfcHoaRenderer::Mode : public ProcessItem<Mode>
-                           , public apf::fixed_vector<sample_type>
+class NfcHoaRenderer::Mode : public apf::fixed_vector<sample_type>
 {
   public:
-    Mode(size_t mode_number, const Source& s)
+    Mode(size_t mode_number, const Source& s, const Item& owner_)
       : apf::fixed_vector<sample_type>(s.parent.block_size())
       , source(s)
+      , owner(owner_)
       , rotation1(0)
       , rotation2(0)
       , old_rotation1(0)
       , old_rotation2(0)
       , _mode_number(mode_number)
-      , _filter(mode_number == 0 ? 1 : (mode_number + 1) / 2)  // round up
       // Coefficients are all zeros by default
       , _coefficients(mode_number, s.parent.sample_rate()
           , s.parent.array_radius, ssr::c)
       , _old_coefficients(_coefficients)
     {}
 
-    APF_PROCESS(Mode, ProcessItem<Mode>)
-    {
-      _process();
-    }
+    void update_coefficients();
+    template<typename Filter>
+    void set_filter(Filter& filter, size_t lane, sample_type index) const;
+    void update_rotation();
 
     const Source& source;
+    const Item& owner;  ///< the list item which processes this Mode
     sample_type rotation1, rotation2, old_rotation1, old_rotation2;
     apf::CombineChannelsResult::type interpolation_mode;
 
   private:
-    void _process();
-
     sample_type _mode_number;
-    filter_type _filter;
     coeff_t _coefficients, _old_coefficients;
 };
 
-void NfcHoaRenderer::Mode::_process()
+/// Calculate new filter coefficients, the old ones are kept for interpolation.
+void NfcHoaRenderer::Mode::update_coefficients()
 {
-  // IIR filtering is not done in RenderFunction because workload would be
-  // distributed very un-evenly between threads!
-
-  if (!this->source.distance.changed() && !this->source.source_model.changed())
-  {
-    // process filter (entire block)
-    _filter.execute(this->source.begin(), this->source.end()
-        , this->begin());
-  }
-  else
-  {
-    _old_coefficients.swap(_coefficients);
-
-    // Avoid focused sources (for now ...):
-    float distance = std::max(this->source.distance.get()
-        , this->source.parent.array_radius);
-
-    // scale filter coefficients
-    _coefficients.reset(distance, this->source.source_model);
+  _old_coefficients.swap(_coefficients);
 
-    apf::dual_iterator<coeff_t::iterator>
-      first_section(_old_coefficients.begin(), _coefficients.begin());
-    apf::dual_iterator<coeff_t::iterator>
-      last_section(_old_coefficients.end(), _coefficients.end());
+  // Avoid focused sources (for now ...):
+  float distance = std::max(this->source.distance.get()
+      , this->source.parent.array_radius);
 
-    sample_type block_size = this->size();
-
-    auto in = this->source.begin();
-    auto out = this->begin();
+  // scale filter coefficients
+  _coefficients.reset(distance, this->source.source_model);
+}
 
-    // Calculate each sample separately. The first sample uses the old
-    // coefficients, after the last sample the filter is updated again for the
-    // next block.
-    for (sample_type index = 1; index <= block_size; ++index)
-    {
-      // Calculate one output sample
-      *out++ = _filter(*in++);
+/// Set interpolated filter coefficients for one lane of @p filter.
+/// @param index position within the block (0 gives the old coefficients)
+template<typename Filter>
+void NfcHoaRenderer::Mode::set_filter(Filter& filter, size_t lane
+    , sample_type index) const
+{
+  apf::dual_iterator<coeff_t::const_iterator>
+    first_section(_old_coefficients.begin(), _coefficients.begin());
+  apf::dual_iterator<coeff_t::const_iterator>
+    last_section(_old_coefficients.end(), _coefficients.end());
 
-      using result_type = apf::SosCoefficients<double>;
-      using argument_type = const std::pair<result_type, result_type>&;
+  const size_t block_size = this->size();
 
-      auto interp_coeffs = [index, block_size] (argument_type coeffs)
-      {
-        return coeffs.first
-          + index * (coeffs.second - coeffs.first) / block_size;
-      };
+  using result_type = apf::SosCoefficients<double>;
+  using argument_type = const std::pair<result_type, result_type>&;
 
-      // Set interpolated filter coefficients
-      _filter.set(apf::make_transform_iterator(first_section, interp_coeffs)
-                , apf::make_transform_iterator(last_section, interp_coeffs));
-    }
+  auto interp_coeffs = [index, block_size] (argument_type coeffs)
+  {
+    return coeffs.first
+      + index * (coeffs.second - coeffs.first) / double(block_size);
+  };
 
-    assert(in == this->source.end());
-    assert(out == this->end());
-  }
+  filter.set(lane, apf::make_transform_iterator(first_section, interp_coeffs)
+                 , apf::make_transform_iterator(last_section, interp_coeffs));
+}
 
+void NfcHoaRenderer::Mode::update_rotation()
+{
   // Note: This must be done if angle OR weighting factor changes
   this->old_rotation1 = this->rotation1;
   this->old_rotation2 = this->rotation2;
@@ -286,46 +288,120 @@ void NfcHoaRenderer::Mode::_process()
   }
 }
 
-/** Combination of two Mode%s.
- * The only reason for this class is distribution of workload. It combines two
- * Mode%s in a way that each ModePair needs a similar amount of processing
- * power.
+// Template-free base class to be used in Source::connect()
+struct NfcHoaRenderer::ModeGroupBase : Item
+{
+  apf::fixed_vector<Mode> modes;
+};
+
+/** Group of Mode%s with consecutive mode numbers.
+ * The IIR filters of all Mode%s in a group are computed together in one
+ * filter bank (one SIMD lane per Mode).
+ * Consecutive Mode%s have a similar number of filter sections, Mode%s with
+ * fewer sections than the highest Mode of the group leave the remaining
+ * sections unused.
+ * @tparam Filter filter bank, e.g. #filter_type or #float_filter_type
  **/
-class NfcHoaRenderer::ModePair : public ProcessItem<ModePair>
+template<typename Filter>
+class NfcHoaRenderer::ModeGroup : public ModeGroupBase
 {
   public:
-    ModePair(size_t mode_number, size_t order, const Source& source)
-      : _second(order - mode_number, source)
+    ModeGroup(size_t first_mode, size_t last_mode, const Source& source)
+      : _source(source)
+      , _filter(last_mode == 0 ? 1 : (last_mode + 1) / 2)  // round up
+      , _scratch(source.parent.block_size())
     {
-      bool order_is_odd = (order % 2 == 0);
+      assert(first_mode <= last_mode);
+      assert(last_mode - first_mode < Filter::lanes);
 
-      if ((mode_number == 0) && order_is_odd)
+      this->modes.reserve(last_mode - first_mode + 1);
+      for (size_t mode = first_mode; mode <= last_mode; ++mode)
       {
-        // With an odd number of Modes, the first ModePair gets only one Mode.
-        // Therefore, _first stays empty.
-      }
-      else
-      {
-        _first.reset(new Mode(mode_number - order_is_odd, source));
+        this->modes.emplace_back(mode, source, *this);
+        // initialize filter with the (all-zero) coefficients of the Mode
+        this->modes.back().set_filter(_filter, this->modes.size() - 1, 0);
       }
     }
 
-    APF_PROCESS(ModePair, ProcessItem<ModePair>)
+    // APF_PROCESS doesn't work here because ModeGroupBase cannot be a
+    // class template.
+
+    virtual void process()
+    {
+      _source.parent.wait_for(_source);
+
+      _process();
+    }
+
+  private:
+    void _process();
+
+    const Source& _source;
+    Filter _filter;
+    apf::fixed_vector<sample_type> _scratch;  ///< output of unused lanes
+};
+
+template<typename Filter>
+void NfcHoaRenderer::ModeGroup<Filter>::_process()
+{
+  // IIR filtering is not done in RenderFunction because workload would be
+  // distributed very un-evenly between threads!
+
+  using iterator = apf::fixed_vector<sample_type>::iterator;
+  auto outputs = std::array<iterator, Filter::lanes>();
+  outputs.fill(_scratch.begin());
+  for (size_t lane = 0; lane < this->modes.size(); ++lane)
+  {
+    outputs[lane] = this->modes[lane].begin();
+  }
+
+  if (!_source.distance.changed() && !_source.source_model.changed())
+  {
+    // process filters (entire block)
+    _filter.execute(_source.begin(), _source.end(), outputs);
+  }
+  else
+  {
+    for (auto& mode: this->modes)
+    {
+      mode.update_coefficients();
+    }
+
+    const size_t block_size = _scratch.size();
+    const size_t interval = _source.parent.update_interval;
+
+    auto in = _source.begin();
+
+    // Calculate the block in chunks of update_interval samples (which may be
+    // a single sample). The first chunk uses the old coefficients, after the
+    // last chunk the filters are updated again for the next block.
+    for (size_t first = 0; first < block_size; first += interval)
     {
-      if (_first)
+      size_t chunk = std::min(interval, block_size - first);
+
+      _filter.execute(in, in + chunk, outputs);
+      in += chunk;
+      for (auto& out: outputs)
+      {
+        out += chunk;
+      }
+
+      sample_type index = sample_type(first + chunk);
+
+      for (size_t lane = 0; lane < this->modes.size(); ++lane)
       {
-        _first->process();
+        this->modes[lane].set_filter(_filter, lane, index);
       }
-      _second.process();
     }
 
-    const Mode* first_ptr() const { return _first.get(); }
-    const Mode* second_ptr() const { return &_second; }
+    assert(in == _source.end());
+  }
 
-  private:
-    std::unique_ptr<Mode> _first;
-    Mode _second;
-};
+  for (auto& mode: this->modes)
+  {
+    mode.update_rotation();
+  }
+}
 
 NfcHoaRenderer::Source::Source(const Params& p)
   : _base::Source(p)
@@ -414,6 +490,11 @@ class NfcHoaRenderer::ModeAccumulator : public ModeAccumulatorBase
     {
       // TODO: global scale factor (depends only on array size)?
 
+      for (auto mode: mode_pointers)
+      {
+        mode->source.parent.wait_for(mode->owner);
+      }
+
       _combiner.process(RenderFunction());
     }
 
@@ -451,31 +532,54 @@ new_mode_accumulator(I1 i1, I2 i2, size_t block_size)
   return new NfcHoaRenderer::ModeAccumulator<I1, I2>(i1, i2, block_size);
 }
 
+template<typename Filter>
 void
-NfcHoaRenderer::Source::connect()
+NfcHoaRenderer::Source::_create_mode_groups()
 {
   size_t order = this->parent.order;
+  const size_t lanes = Filter::lanes;
 
-  // create ModePair objects
+  // Higher modes need more filter sections. The groups with the most work are
+  // put at the beginning of the list, which distributes the workload more
+  // evenly between threads.
 
-  for (size_t mode_number = 0; mode_number <= order / 2; ++mode_number)
+  for (size_t first_mode = 0; first_mode <= order; first_mode += lanes)
   {
-    _mode_pairs.push_back(new ModePair(mode_number, order, *this));
+    size_t last_mode = std::min(first_mode + lanes - 1, order);
+    _mode_groups.push_front(new ModeGroup<Filter>(first_mode, last_mode
+          , *this));
   }
+}
 
-  // create list of pointers to Mode objects
+void
+NfcHoaRenderer::Source::connect()
+{
+  // create ModeGroup objects
 
-  auto reverse_pairs
-    = apf::make_begin_and_end(_mode_pairs.rbegin(), _mode_pairs.rend());
-  for (auto pair: reverse_pairs)
+  if (this->parent.single_precision)
   {
-    if (pair->first_ptr()) _modes.push_front(pair->first_ptr());
-    _modes.push_back(pair->second_ptr());
+    _create_mode_groups<float_filter_type>();
+  }
+  else
+  {
+    _create_mode_groups<filter_type>();
+  }
+
+  // create list of pointers to Mode objects (in order of mode number)
+
+  auto reverse_groups
+    = apf::make_begin_and_end(_mode_groups.rbegin(), _mode_groups.rend());
+  for (auto group: reverse_groups)
+  {
+    for (const auto& mode: group->modes)
+    {
+      _modes.push_back(&mode);
+    }
   }
 
-  // add _mode_pairs to _mode_pair_list
+  // add _mode_groups to _mode_group_list
 
-  this->parent._mode_pair_list.add(_mode_pairs.begin(), _mode_pairs.end());
+  this->parent._mode_group_list.add(_mode_groups.begin(), _mode_groups.end());
 
   // connect modes with ModeAccumulator
 
@@ -496,18 +600,30 @@ NfcHoaRenderer::Source::disconnect()
       , &ModeAccumulatorBase::mode_pointers);
 
   // The objects are actually deleted here (via the _fifo):
-  this->parent._mode_pair_list.rem(_mode_pairs.begin(), _mode_pairs.end());
+  this->parent._mode_group_list.rem(_mode_groups.begin(), _mode_groups.end());
 
   _modes.clear();
-  _mode_pairs.clear();
+  _mode_groups.clear();
 }
 
+/** Several FFTs over the Mode%s (one per sample).
+ * All FFTs of a block are split into a few FftProcessor%s (for parallel
+ * processing), each one computes @p howmany FFTs with a single plan.
+ * The transforms are done in-place along the columns of the mode matrix,
+ * therefore no transposition is needed.
+ **/
 class NfcHoaRenderer::FftProcessor : public ProcessItem<FftProcessor>
 {
   public:
-    FftProcessor(size_t block_size, sample_type* first)
-      : _fft_plan(apf::fftw<sample_type>::plan_r2r_1d, block_size, first, first
-            , FFTW_R2HC, FFTW_PATIENT)
+    /// @param size FFT size (number of loudspeakers)
+    /// @param howmany number of FFTs (i.e. number of samples)
+    /// @param stride distance between two Mode%s (i.e. block size)
+    /// @param first first sample of the first Mode
+    FftProcessor(int size, int howmany, int stride, sample_type* first)
+      : _kind(FFTW_R2HC)
+      , _fft_plan(apf::fftw<sample_type>::plan_many_r2r, 1, &size, howmany
+            , first, nullptr, stride, 1, first, nullptr, stride, 1
+            , &_kind, FFTW_PATIENT)
     {}
 
     APF_PROCESS(FftProcessor, ProcessItem<FftProcessor>)
@@ -517,6 +633,8 @@ class NfcHoaRenderer::FftProcessor : public ProcessItem<FftProcessor>
     }
 
   private:
+    const fftw_r2r_kind _kind;  // must be initialized before _fft_plan
+
     apf::fftw<sample_type>::scoped_plan _fft_plan;
 };
 
@@ -526,10 +644,11 @@ struct NfcHoaRenderer::Output : _base::Output
 
   APF_PROCESS(Output, _base::Output)
   {
-    std::copy(this->slice.begin(), this->slice.end(), this->buffer.begin());
+    std::copy(this->channel.begin(), this->channel.end()
+        , this->buffer.begin());
   }
 
-  fft_matrix_t::Slice slice;
+  matrix_t::Channel channel;
 };
 
 void
@@ -567,7 +686,6 @@ NfcHoaRenderer::load_reproduction_setup()
     "Assuming circular (counterclockwise) setup!\n" << std::endl;
 
   _mode_matrix.initialize(normal_loudspeakers, this->block_size());
-  _fft_matrix.initialize(this->block_size(), normal_loudspeakers);
 
   this->order = normal_loudspeakers / 2;  // round down
 
@@ -591,22 +709,29 @@ NfcHoaRenderer::load_reproduction_setup()
     // TODO: documentation, mention half-complex format of FFTW
   }
 
-  for (fft_matrix_t::channels_iterator ch = _fft_matrix.channels.begin()
-      ; ch != _fft_matrix.channels.end()
-      ; ++ch)
+  // One chunk of FFTs per thread, each chunk (except the last one) is a
+  // multiple of 4 samples to keep the alignment of the first sample.
+  size_t chunks = std::max(this->num_threads(), 1);
+  size_t block_size = this->block_size();
+  size_t chunk_size = (block_size + chunks - 1) / chunks;
+  chunk_size = (chunk_size + 3) / 4 * 4;
+
+  for (size_t first = 0; first < block_size; first += chunk_size)
   {
-    _fft_list.add(new FftProcessor(normal_loudspeakers, ch->begin()));
+    size_t howmany = std::min(chunk_size, block_size - first);
+    _fft_list.add(new FftProcessor(int(normal_loudspeakers), int(howmany)
+          , int(block_size), _mode_matrix.channels.begin()->begin() + first));
   }
 
-  assert(outputs.size() == size_t(std::distance(_fft_matrix.slices.begin()
-                                              , _fft_matrix.slices.end())));
+  assert(outputs.size() == size_t(std::distance(_mode_matrix.channels.begin()
+                                              , _mode_matrix.channels.end())));
 
-  fft_matrix_t::slices_iterator slice = _fft_matrix.slices.begin();
+  matrix_t::channels_iterator channel = _mode_matrix.channels.begin();
   for (output_list_t::iterator out = outputs.begin()
       ; out != outputs.end()
       ; ++out)
   {
-    out->slice = *slice++;
+    out->channel = *channel++;
   }
 }
 
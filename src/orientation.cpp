@@ -81,6 +81,16 @@ Orientation& Orientation::operator-=(const Orientation& other)
   return *this;
 }
 
+bool Orientation::operator==(const Orientation& other) const
+{
+  return azimuth == other.azimuth && elevation == other.elevation;
+}
+
+bool Orientation::operator!=(const Orientation& other) const
+{
+  return !this->operator==(other);
+}
+
 /** convert the orientation given by the orientation angles (yaw,pitch) to a
  * Position unit-length look vector.
  * @return Position with the corresponding unit-length 3D look vector
@@ -51,6 +51,8 @@ struct Orientation
 
   Orientation& operator+=(const Orientation& other);
   Orientation& operator-=(const Orientation& other);
+  bool operator==(const Orientation& other) const;  ///< == operator
+  bool operator!=(const Orientation& other) const;  ///< != operator
 
   Position look_vector() const;
 
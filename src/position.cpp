@@ -97,7 +97,8 @@ Position& Position::rotate(float yaw, float pitch)
   float phi = apf::math::deg2rad(this->orientation().azimuth + yaw);
   float theta = apf::math::deg2rad(this->orientation().elevation + pitch);
   float radius = this->length();
-  return *this = Position(radius * cos(theta) * cos(phi), radius * cos(theta) * sin(phi));
+  return *this = Position(radius * cos(theta) * cos(phi)
+      , radius * cos(theta) * sin(phi), radius * sin(theta));
 }
 
 Position& Position::rotate(const Orientation& rotation)
@@ -38,14 +38,14 @@
  * If you want to speak in design patterns, you could call this a "Messenger"
  * patter. It's the most trivial of all patterns. So maybe it's not even worth
  * mentioning. But I did it anyway ...
- * @warning For now, it only uses 2 dimensions (x,y) but a z coordinate can be 
- * added later, if needed.
+ * @warning Not all renderers take the z coordinate into account.
  **/
 struct Position
 {
   /** with no arguments, all member variables are initialized to zero.
    * @param x x coordinate (in meters)
    * @param y y coordinate (in meters)
+   * @param z z coordinate (in meters)
    **/
   explicit Position(const float x = 0.f, const float y = 0.f, const float z = 0.f);
 
@@ -81,6 +81,11 @@ struct Publisher
       const float gain = 1.0f, const bool mute_state = false, 
       const std::string& properties_file = "") = 0;
 
+  /// start a group of changes which should be applied together
+  virtual void begin_transaction() = 0;
+  /// finish a group of changes, see begin_transaction()
+  virtual void end_transaction() = 0;
+
   /// delete a source
   /// @param[in] id id of the source to be deleted
   virtual void delete_source(id_t id) = 0;
@@ -159,6 +164,25 @@ struct Publisher
   virtual std::string get_scene_as_XML() const = 0;
 };
 
+/// All changes of one request are applied together (exception-safe)
+class ScopedTransaction
+{
+  public:
+    explicit ScopedTransaction(Publisher& controller)
+      : _controller(controller)
+    {
+      _controller.begin_transaction();
+    }
+
+    ~ScopedTransaction() { _controller.end_transaction(); }
+
+    ScopedTransaction(const ScopedTransaction&) = delete;
+    ScopedTransaction& operator=(const ScopedTransaction&) = delete;
+
+  private:
+    Publisher& _controller;
+};
+
 }  // namespace ssr
 
 #endif
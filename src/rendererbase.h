@@ -31,6 +31,7 @@
 #define SSR_RENDERERBASE_H
 
 #include <string>
+#include <vector>
 
 #include "apf/mimoprocessor.h"
 #include "apf/shareddata.h"
@@ -80,6 +81,7 @@ class RendererBase : public apf::MimoProcessor<Derived
     // TODO: try to remove this:
     using SourceBase = Source;
     class Output;
+    class Transaction;
 
     struct State
     {
@@ -103,6 +105,22 @@ class RendererBase : public apf::MimoProcessor<Derived
       apf::SharedData<sample_type> amplitude_reference_distance;
     } state;
 
+    /// Updates the block-rate copies of the reference state before the
+    /// Derived renderer (and therefore its sources) is processed.
+    struct Process : _base::Process
+    {
+      explicit Process(Derived& ctrl)
+        : _base::Process(ctrl)
+      {
+        ctrl._update_reference();
+      }
+    };
+
+    /// Check if any part of the reference (position, orientation, offset or
+    /// amplitude reference distance) has changed since the last block.
+    /// May only be used in realtime thread!
+    bool reference_changed() const { return _reference_changed; }
+
     // If you don't need a list proxy, just use a reference to the list
     template<typename L, typename ListProxy, typename DataMember>
     class AddToSublistCommand : public apf::CommandQueue::Command
@@ -214,10 +232,21 @@ class RendererBase : public apf::MimoProcessor<Derived
 
     int _get_new_id();
 
+    void _update_reference();
+
     std::map<int, Source*> _source_map;
 
     int _highest_id;
 
+    // Copies of the reference state (see State) for the current and the
+    // previous block, used to find out if anything has changed.
+    apf::BlockParameter<Position> _block_reference_position;
+    apf::BlockParameter<Orientation> _block_reference_orientation;
+    apf::BlockParameter<Position> _block_reference_offset_position;
+    apf::BlockParameter<Orientation> _block_reference_offset_orientation;
+    apf::BlockParameter<sample_type> _block_amplitude_reference_distance;
+    bool _reference_changed;
+
     typename _base::Lock _lock;
 };
 
@@ -234,6 +263,14 @@ RendererBase<Derived>::RendererBase(const apf::parameter_map& p)
   , _source_list(_fifo)
   , _show_head(true)
   , _highest_id(0)
+  , _block_reference_position(state.reference_position.get())
+  , _block_reference_orientation(state.reference_orientation.get())
+  , _block_reference_offset_position(state.reference_offset_position.get())
+  , _block_reference_offset_orientation(
+      state.reference_offset_orientation.get())
+  , _block_amplitude_reference_distance(
+      state.amplitude_reference_distance.get())
+  , _reference_changed(false)
 {}
 
 /** Create a new source.
@@ -335,6 +372,25 @@ RendererBase<Derived>::_get_new_id()
   return ++_highest_id;
 }
 
+template<typename Derived>
+void
+RendererBase<Derived>::_update_reference()
+{
+  _block_reference_position = state.reference_position.get();
+  _block_reference_orientation = state.reference_orientation.get();
+  _block_reference_offset_position = state.reference_offset_position.get();
+  _block_reference_offset_orientation
+    = state.reference_offset_orientation.get();
+  _block_amplitude_reference_distance
+    = state.amplitude_reference_distance.get();
+
+  _reference_changed = _block_reference_position.changed()
+    || _block_reference_orientation.changed()
+    || _block_reference_offset_position.changed()
+    || _block_reference_offset_orientation.changed()
+    || _block_amplitude_reference_distance.changed();
+}
+
 /// A sound source.
 template<typename Derived>
 class RendererBase<Derived>::Source
@@ -368,7 +424,7 @@ class RendererBase<Derived>::Source
               "Bug (RendererBase::Source): fifo == NULL!")))
       , orientation(*p.fifo)
       , gain(*p.fifo, sample_type(1.0))
-      , mute(*p.fifo, false)
+      , mute(*p.fifo, p.get("mute", false))
       , model(*p.fifo, ::Source::point)
       , weighting_factor()
       , id(p.id)
@@ -376,6 +432,8 @@ class RendererBase<Derived>::Source
               "Bug (RendererBase::Source): input == NULL!")))
       , _pre_fader_level()
       , _level()
+      , _first_block(true)
+      , _geometry_changed(true)
     {}
 
     APF_PROCESS(Source, SourceBase)
@@ -399,8 +457,29 @@ class RendererBase<Derived>::Source
       _level_helper(_input.parent);
 
       assert(this->weighting_factor.exactly_one_assignment());
+
+      _block_position = this->position.get();
+      _block_orientation = this->orientation.get();
+      _block_model = this->model.get();
+
+      _geometry_changed = _first_block
+        || _block_position.changed()
+        || _block_orientation.changed()
+        || _block_model.changed()
+        || this->parent.reference_changed();
+      _first_block = false;
     }
 
+    /** Check if position, orientation or model of the source or anything
+     * about the reference has changed since the last block.
+     * This is always @c true in the first block of a source.
+     * Renderers can use this to re-use their coefficients of the last block.
+     * The gain (including mute, master volume etc.) is not considered, use
+     * @c weighting_factor.changed() for that.
+     * @note Only valid after Source::process() in the current block.
+     **/
+    bool geometry_changed() const { return _geometry_changed; }
+
     sample_type get_level() const { return _level; }
 
     // In the default case, the output level are ignored
@@ -435,8 +514,204 @@ class RendererBase<Derived>::Source
 
     sample_type _pre_fader_level;
     sample_type _level;
+
+    apf::BlockParameter<Position> _block_position;
+    apf::BlockParameter<Orientation> _block_orientation;
+    apf::BlockParameter< ::Source::model_t> _block_model;
+    bool _first_block, _geometry_changed;
 };
 
+/** Collection of scene changes which are applied in one audio cycle.
+ * Changes can be collected from the non-realtime thread without locking.
+ * commit() resolves the source IDs (changes to non-existing sources are
+ * ignored) and pushes a single command to the realtime thread.
+ * Therefore, the realtime thread never sees a half-applied scene update and
+ * only one slot in the CommandQueue is needed.
+ **/
+template<typename Derived>
+class RendererBase<Derived>::Transaction
+{
+  public:
+    explicit Transaction(RendererBase& renderer)
+      : _renderer(renderer)
+      , _reference_position_changed(false)
+      , _reference_orientation_changed(false)
+    {}
+
+    void set_source_position(int id, const Position& position)
+    {
+      auto& change = _sources[id];
+      change.position = position;
+      change.changed |= _position;
+    }
+
+    void set_source_orientation(int id, const Orientation& orientation)
+    {
+      auto& change = _sources[id];
+      change.orientation = orientation;
+      change.changed |= _orientation;
+    }
+
+    void set_source_gain(int id, sample_type gain)
+    {
+      auto& change = _sources[id];
+      change.gain = gain;
+      change.changed |= _gain;
+    }
+
+    void set_source_mute(int id, bool mute)
+    {
+      auto& change = _sources[id];
+      change.mute = mute;
+      change.changed |= _mute;
+    }
+
+    void set_source_model(int id, ::Source::model_t model)
+    {
+      auto& change = _sources[id];
+      change.model = model;
+      change.changed |= _model;
+    }
+
+    void set_reference_position(const Position& position)
+    {
+      _reference_position = position;
+      _reference_position_changed = true;
+    }
+
+    void set_reference_orientation(const Orientation& orientation)
+    {
+      _reference_orientation = orientation;
+      _reference_orientation_changed = true;
+    }
+
+    bool empty() const
+    {
+      return _sources.empty() && !_reference_position_changed
+        && !_reference_orientation_changed;
+    }
+
+    void commit();
+
+  private:
+    enum { _position = 1, _orientation = 2, _gain = 4, _mute = 8, _model = 16 };
+
+    struct SourceChange
+    {
+      SourceChange() : source(nullptr), changed(0), gain(), mute(), model() {}
+
+      Source* source;
+      unsigned changed;  // bit mask
+      Position position;
+      Orientation orientation;
+      sample_type gain;
+      bool mute;
+      ::Source::model_t model;
+    };
+
+    class Command;
+
+    RendererBase& _renderer;
+    std::map<int, SourceChange> _sources;
+    Position _reference_position;
+    Orientation _reference_orientation;
+    bool _reference_position_changed, _reference_orientation_changed;
+};
+
+template<typename Derived>
+class RendererBase<Derived>::Transaction::Command
+                                            : public apf::CommandQueue::Command
+{
+  public:
+    Command(std::vector<SourceChange>&& sources, State& state
+        , const Transaction& t)
+      : _sources(std::move(sources))
+      , _state(state)
+      , _reference_position(t._reference_position)
+      , _reference_orientation(t._reference_orientation)
+      , _reference_position_changed(t._reference_position_changed)
+      , _reference_orientation_changed(t._reference_orientation_changed)
+    {}
+
+    virtual void execute()
+    {
+      for (const auto& change: _sources)
+      {
+        auto& src = *change.source;
+        if (change.changed & _position)
+        {
+          src.position.assign_in_realtime_thread(change.position);
+        }
+        if (change.changed & _orientation)
+        {
+          src.orientation.assign_in_realtime_thread(change.orientation);
+        }
+        if (change.changed & _gain)
+        {
+          src.gain.assign_in_realtime_thread(change.gain);
+        }
+        if (change.changed & _mute)
+        {
+          src.mute.assign_in_realtime_thread(change.mute);
+        }
+        if (change.changed & _model)
+        {
+          src.model.assign_in_realtime_thread(change.model);
+        }
+      }
+      if (_reference_position_changed)
+      {
+        _state.reference_position.assign_in_realtime_thread(
+            _reference_position);
+      }
+      if (_reference_orientation_changed)
+      {
+        _state.reference_orientation.assign_in_realtime_thread(
+            _reference_orientation);
+      }
+    }
+
+    // _sources is de-allocated in the non-realtime thread
+    virtual void cleanup() {}
+
+  private:
+    std::vector<SourceChange> _sources;
+    State& _state;
+    Position _reference_position;
+    Orientation _reference_orientation;
+    bool _reference_position_changed, _reference_orientation_changed;
+};
+
+/** Apply all collected changes with one command.
+ * Afterwards, the Transaction is empty and can be re-used.
+ **/
+template<typename Derived>
+void
+RendererBase<Derived>::Transaction::commit()
+{
+  if (this->empty()) return;
+
+  std::vector<SourceChange> sources;
+  sources.reserve(_sources.size());
+
+  {
+    auto guard = _renderer.get_scoped_lock();
+
+    for (auto& item: _sources)
+    {
+      item.second.source = _renderer.get_source(item.first);
+      if (item.second.source) sources.push_back(item.second);
+    }
+
+    _renderer._fifo.template emplace<Command>(std::move(sources)
+        , _renderer.state, *this);
+  }
+
+  _sources.clear();
+  _reference_position_changed = false;
+  _reference_orientation_changed = false;
+}
+
 template<typename Derived>
 class RendererBase<Derived>::Output : public _base::Output
 {
@@ -37,6 +37,8 @@
 
 #include "subscriber.h"
 #include <map>
+#include <set>
+#include <thread>  // for std::this_thread::get_id()
 
 namespace ssr
 {
@@ -45,27 +47,59 @@ template<typename Renderer>
 class RenderSubscriber : public Subscriber
 {
   public:
-    RenderSubscriber(Renderer &renderer) : _renderer(renderer) {}
+    RenderSubscriber(Renderer &renderer)
+      : _renderer(renderer)
+      , _transaction(renderer)
+      , _transaction_depth(0)
+    {}
 
     // Subscriber Interface
     virtual void set_loudspeakers(const Loudspeaker::container_t& loudspeakers);
 
-    virtual void new_source(id_t id) { (void) id; }
+    // NOTE: All Subscriber functions are called with the subscriber lock of
+    // the Controller, only the thread which started a transaction uses it.
+
+    virtual void begin_transaction()
+    {
+      if (_transaction_depth > 0
+          && _transaction_thread != std::this_thread::get_id())
+      {
+        return;  // only one transaction at a time, others are applied directly
+      }
+      _transaction_thread = std::this_thread::get_id();
+      ++_transaction_depth;
+    }
+
+    virtual void end_transaction()
+    {
+      if (!_current_transaction()) return;
+      if (--_transaction_depth == 0) _transaction.commit();
+    }
+
+    virtual void new_source(id_t id) { _source_ids.insert(id); }
 
     virtual void delete_source(id_t id)
     {
+      _source_ids.erase(id);
       auto guard = _renderer.get_scoped_lock();
       _renderer.rem_source(id);
     }
 
     virtual void delete_all_sources()
     {
+      _source_ids.clear();
       auto guard = _renderer.get_scoped_lock();
       _renderer.rem_all_sources();
     }
 
     virtual bool set_source_position(id_t id, const Position& position)
     {
+      if (auto transaction = _current_transaction())
+      {
+        if (!_source_ids.count(id)) return false;
+        transaction->set_source_position(id, position);
+        return true;
+      }
       auto guard = _renderer.get_scoped_lock();
       auto src = _renderer.get_source(id);
       if (!src) return false;
@@ -75,6 +109,12 @@ class RenderSubscriber : public Subscriber
 
     virtual bool set_source_orientation(id_t id, const Orientation& orientation)
     {
+      if (auto transaction = _current_transaction())
+      {
+        if (!_source_ids.count(id)) return false;
+        transaction->set_source_orientation(id, orientation);
+        return true;
+      }
       auto guard = _renderer.get_scoped_lock();
       auto src = _renderer.get_source(id);
       if (!src) return false;
@@ -84,6 +124,12 @@ class RenderSubscriber : public Subscriber
 
     virtual bool set_source_gain(id_t id, const float& gain)
     {
+      if (auto transaction = _current_transaction())
+      {
+        if (!_source_ids.count(id)) return false;
+        transaction->set_source_gain(id, gain);
+        return true;
+      }
       auto guard = _renderer.get_scoped_lock();
       auto src = _renderer.get_source(id);
       if (!src) return false;
@@ -93,6 +139,12 @@ class RenderSubscriber : public Subscriber
 
     virtual bool set_source_mute(id_t id, const bool& mute)
     {
+      if (auto transaction = _current_transaction())
+      {
+        if (!_source_ids.count(id)) return false;
+        transaction->set_source_mute(id, mute);
+        return true;
+      }
       auto guard = _renderer.get_scoped_lock();
       auto src = _renderer.get_source(id);
       if (!src) return false;
@@ -116,6 +168,12 @@ class RenderSubscriber : public Subscriber
 
     virtual bool set_source_model(id_t id, const Source::model_t& model)
     {
+      if (auto transaction = _current_transaction())
+      {
+        if (!_source_ids.count(id)) return false;
+        transaction->set_source_model(id, model);
+        return true;
+      }
       auto guard = _renderer.get_scoped_lock();
       auto src = _renderer.get_source(id);
       if (!src) return false;
@@ -153,12 +211,22 @@ class RenderSubscriber : public Subscriber
 
     virtual void set_reference_position(const Position& position)
     {
+      if (auto transaction = _current_transaction())
+      {
+        transaction->set_reference_position(position);
+        return;
+      }
       auto guard = _renderer.get_scoped_lock();
       _renderer.state.reference_position = position;
     }
 
     virtual void set_reference_orientation(const Orientation& orientation)
     {
+      if (auto transaction = _current_transaction())
+      {
+        transaction->set_reference_orientation(orientation);
+        return;
+      }
       auto guard = _renderer.get_scoped_lock();
       _renderer.state.reference_orientation = orientation;
     }
@@ -236,7 +304,26 @@ class RenderSubscriber : public Subscriber
     }
 
   private:
+    /// Open transaction of the current thread (or @b nullptr)
+    typename Renderer::Transaction* _current_transaction()
+    {
+      if (_transaction_depth > 0
+          && _transaction_thread == std::this_thread::get_id())
+      {
+        return &_transaction;
+      }
+      return nullptr;
+    }
+
     Renderer& _renderer;
+
+    /// IDs of all sources announced with new_source(), used to report
+    /// unknown IDs within a transaction without taking the renderer lock
+    std::set<id_t> _source_ids;
+
+    typename Renderer::Transaction _transaction;
+    int _transaction_depth;
+    std::thread::id _transaction_thread;
 };
 
 template<typename Renderer>
@@ -0,0 +1,140 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// Command line tool to convert impulse responses to filter files.
+
+#include <iostream>
+#include <string>
+#include <cstdlib>  // for realpath(), free(), strtoul()
+#include <getopt.h>  // for getopt_long()
+
+#include "filtercache.h"  // for FilterCache, FilterFile
+
+namespace
+{
+
+void usage(const char* exec_name)
+{
+  std::cout << "\nUSAGE: " << exec_name << " [OPTIONS] <input> <output>\n"
+"\n"
+"Transform the impulse responses in the sound file <input> to the frequency\n"
+"domain and store them in the filter file <output>, which can be used by\n"
+"the binaural, BRS and generic renderers instead of the sound file.\n"
+"The block size and partitioning must match the settings of the renderer.\n"
+"\n"
+"OPTIONS:\n"
+"\n"
+"-b, --block-size=N     JACK block size (required)\n"
+"-s, --size=N           Maximum IR length (default: whole file)\n"
+"-p, --nonuniform-partitions=N  Number of partitions per block size for\n"
+"                       non-uniformly partitioned convolution (default: 0)\n"
+"-m, --nonuniform-max-block-size=N  Largest block size of non-uniform\n"
+"                       partitions (default: 0, no limit)\n"
+"-h, --help             Show this help and exit\n"
+"\n";
+}
+
+}  // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+  const struct option longopts[] =
+  {
+    {"block-size",   required_argument, nullptr, 'b'},
+    {"size",         required_argument, nullptr, 's'},
+    {"nonuniform-partitions", required_argument, nullptr, 'p'},
+    {"nonuniform-max-block-size", required_argument, nullptr, 'm'},
+    {"help",         no_argument,       nullptr, 'h'},
+    {nullptr,        0,                 nullptr,  0 }
+  };
+
+  auto key = ssr::FilterCache::Key{"", 0, 0, 0, 0, 0};
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "b:s:p:m:h", longopts, nullptr)) != -1)
+  {
+    switch (opt)
+    {
+      case 'b':
+        key.block_size = strtoul(optarg, nullptr, 10);
+        break;
+      case 's':
+        key.size = strtoul(optarg, nullptr, 10);
+        break;
+      case 'p':
+        key.partitions = strtoul(optarg, nullptr, 10);
+        break;
+      case 'm':
+        key.max_block_size = strtoul(optarg, nullptr, 10);
+        break;
+      case 'h':
+        usage(argv[0]);
+        return EXIT_SUCCESS;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+
+  if (argc - optind != 2 || key.block_size == 0)
+  {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  key.filename = argv[optind];
+  const std::string output = argv[optind + 1];
+
+  // The canonical name is stored to find the original file later
+  if (char* path = realpath(key.filename.c_str(), nullptr))
+  {
+    key.filename = path;
+    free(path);
+  }
+
+  try
+  {
+    auto stamp = ssr::FileStamp(key.filename);
+    auto filters = ssr::FilterCache::prepare(key);
+    ssr::FilterFile::write(output, *filters, key.filename, stamp);
+
+    std::cout << "\"" << output << "\": " << filters->channels()
+      << " channels, " << filters->parameters.size << " samples, "
+      << filters->layout.size() << " segment(s), sample rate "
+      << filters->parameters.sample_rate << " Hz" << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -51,6 +51,14 @@ struct Subscriber
 
   virtual void set_loudspeakers(const Loudspeaker::container_t& loudspeakers) = 0;
 
+  /// Start a group of changes.
+  /// Changes until end_transaction() may be applied together.
+  /// Calls can be nested, only the outermost pair is relevant.
+  virtual void begin_transaction() {}
+
+  /// Finish a group of changes. @see begin_transaction()
+  virtual void end_transaction() {}
+
   /// Create a new source with default values.
   /// @param id ID of the new source
   virtual void new_source(id_t id) {(void)id;}
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// Offline test of batched scene changes (RendererBase::Transaction).
+///
+/// A new source is created within a transaction (like Controller::new_source()
+/// does it for a network request) and its initial parameters are set.
+/// Until the end of the transaction, the source must stay muted, afterwards
+/// all parameters must be applied in the same audio block.
+
+#include <iostream>
+#include <vector>
+
+#define APF_MIMOPROCESSOR_SAMPLE_TYPE float
+#include "apf/pointer_policy.h"
+#include "apf/default_thread_policy.h"
+
+#include "rendererbase.h"
+#include "rendersubscriber.h"
+
+namespace
+{
+
+const int block_size = 64;
+
+// Renderer without outputs, sources only remember what they've seen
+class TestRenderer : public ssr::RendererBase<TestRenderer>
+{
+  private:
+    using _base = ssr::RendererBase<TestRenderer>;
+
+  public:
+    static const char* name() { return "TestRenderer"; }
+
+    class Source : public _base::Source
+    {
+      public:
+        explicit Source(const Params& p)
+          : _base::Source(p)
+          , block_weight(-1)
+        {}
+
+        APF_PROCESS(Source, _base::Source)
+        {
+          this->block_weight = this->weighting_factor;
+          this->block_position = this->position.get();
+        }
+
+        sample_type block_weight;
+        Position block_position;
+    };
+
+    explicit TestRenderer(const apf::parameter_map& params)
+      : _base(params)
+    {}
+
+    APF_PROCESS(TestRenderer, _base)
+    {
+      this->_process_list(_source_list);
+    }
+};
+
+bool success = true;
+
+void check(bool condition, const char* message)
+{
+  if (!condition)
+  {
+    std::cout << "FAILED: " << message << std::endl;
+    success = false;
+  }
+}
+
+}  // unnamed namespace
+
+int main()
+{
+  apf::parameter_map params;
+  params.set("block_size", block_size);
+  params.set("sample_rate", 44100);
+  TestRenderer renderer(params);
+  renderer.activate();
+
+  ssr::RenderSubscriber<TestRenderer> subscriber(renderer);
+
+  auto input = std::vector<float>(block_size);
+  float* inputs[] = { input.data() };
+  auto process = [&renderer, &inputs]()
+  {
+    renderer.audio_callback(block_size, inputs, nullptr);
+  };
+
+  subscriber.begin_transaction();
+
+  // see Controller::new_source()
+  apf::parameter_map p;
+  p.set("mute", true);
+  ssr::id_t id;
+  {
+    auto guard = renderer.get_scoped_lock();
+    id = renderer.add_source(p);
+  }
+  subscriber.new_source(id);
+  check(subscriber.set_source_mute(id, true), "set_source_mute()");
+  check(subscriber.set_source_gain(id, 0.5f), "set_source_gain()");
+  check(subscriber.set_source_position(id, Position(1, 2))
+      , "set_source_position()");
+  check(subscriber.set_source_mute(id, false), "set_source_mute()");
+  check(!subscriber.set_source_gain(id + 1, 0.5f)
+      , "set_source_gain() of non-existing source (in transaction)");
+
+  process();
+
+  auto base_source = renderer.get_source(id);
+  check(base_source != nullptr, "get_source()");
+  if (!base_source) return 1;
+  auto source = &base_source->derived();
+
+  check(source->block_weight == 0.0f, "new source is muted in transaction");
+
+  subscriber.end_transaction();
+  process();
+
+  check(source->block_weight == 0.5f, "gain after end of transaction");
+  check(source->block_position == Position(1, 2)
+      , "position after end of transaction");
+
+  check(!subscriber.set_source_gain(id + 1, 0.5f)
+      , "set_source_gain() of non-existing source");
+  check(subscriber.set_source_gain(id, 0.25f), "set_source_gain()");
+  process();
+  check(source->block_weight == 0.25f, "gain without transaction");
+
+  subscriber.begin_transaction();
+  subscriber.delete_source(id);
+  check(!subscriber.set_source_gain(id, 0.5f)
+      , "set_source_gain() of deleted source (in transaction)");
+  subscriber.end_transaction();
+  process();
+
+  renderer.deactivate();
+
+  return success ? 0 : 1;
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
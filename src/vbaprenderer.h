@@ -30,7 +30,12 @@
 #ifndef SSR_VBAPRENDERER_H
 #define SSR_VBAPRENDERER_H
 
+#include <array>
+#include <memory>  // for std::unique_ptr
+
+#include "ssr_global.h"  // for VERBOSE()
 #include "loudspeakerrenderer.h"
+#include "vbaptriangulation.h"
 #include "apf/combine_channels.h"
 
 namespace ssr
@@ -48,6 +53,10 @@ namespace ssr
  * \sin \phi \cos \phi_0}{2 \cos \phi_0 \sin \phi_0} \f$
  * \par 
  * whereby \f$ \displaystyle \phi\f$ denotes blah, blah
+ * \par
+ * If any loudspeaker is outside of the horizontal plane, 3-D VBAP is used:
+ * The loudspeaker directions are triangulated (see VbapTriangulation) and
+ * each source is reproduced by (up to) three loudspeakers.
  **/
 class VbapRenderer : public LoudspeakerRenderer<VbapRenderer>
 {
@@ -60,6 +69,8 @@ class VbapRenderer : public LoudspeakerRenderer<VbapRenderer>
     class Source;
     class Output;
     class RenderFunction;
+    struct Contribution;
+    class ContributionList;
 
     explicit VbapRenderer(const apf::parameter_map& params)
       : _base(params)
@@ -87,17 +98,24 @@ class VbapRenderer : public LoudspeakerRenderer<VbapRenderer>
       {
         // TODO: check if reference is 'inside' the array?
 
-        _update_angles();
-
-        // The (circular) order will always be the same in a convex array.
-        // However, angles may be wrapped around 0 and 2*pi.
-        // Only in this case the list has to be re-sorted.
-        if (_sorted_loudspeakers.back() < _sorted_loudspeakers.front())
+        if (_triangulation)
         {
-          _sort_loudspeakers();
+          _update_directions();
         }
+        else
+        {
+          _update_angles();
 
-        _update_valid_sections();
+          // The (circular) order will always be the same in a convex array.
+          // However, angles may be wrapped around 0 and 2*pi.
+          // Only in this case the list has to be re-sorted.
+          if (_sorted_loudspeakers.back() < _sorted_loudspeakers.front())
+          {
+            _sort_loudspeakers();
+          }
+
+          _update_valid_sections();
+        }
       }
 
       _absolute_reference_offset_position
@@ -106,6 +124,8 @@ class VbapRenderer : public LoudspeakerRenderer<VbapRenderer>
         + this->state.reference_position;
 
       _process_list(_source_list);
+
+      _link_contributions();
     }
 
   private:
@@ -113,7 +133,7 @@ class VbapRenderer : public LoudspeakerRenderer<VbapRenderer>
     {
       // Note: This is non-explicit to allow comparison with angle
       LoudspeakerEntry(float angle_, bool valid_section_ = false
-          , const Output* output_ = nullptr)
+          , Output* output_ = nullptr)
         : angle(angle_)
         , valid_section(valid_section_)
         , ls_ptr(output_)
@@ -128,29 +148,109 @@ class VbapRenderer : public LoudspeakerRenderer<VbapRenderer>
 
       float angle;  // radians
       bool valid_section;  // Is the angle to the next loudspeaker < _max_angle?
-      const Output* ls_ptr;
+      Output* ls_ptr;
     };
 
     struct LoudspeakerWeight
     {
-      const Output* ls_ptr = nullptr;
+      Output* ls_ptr = nullptr;
       float weight = 0.0;
     };
 
+    /// (up to) three loudspeakers per Source, the third one only for 3-D
+    using weights_t = std::array<LoudspeakerWeight, 3>;
+
+    void _link_contributions();
     void _update_angles();
     void _sort_loudspeakers();
     void _update_valid_sections();
+    void _update_directions();
 
     float _max_angle, _overhang_angle;
 
     apf::math::raised_cosine<float> _overhang_func;
 
+    /// For 3-D VBAP the list is not sorted, its order is the same as in
+    /// #_directions (the angles and valid sections are not used).
     std::vector<LoudspeakerEntry> _sorted_loudspeakers;
 
+    /// Loudspeaker positions relative to the reference offset (only for 3-D)
+    std::vector<Position> _directions;
+    /// Only available for 3-D loudspeaker setups
+    std::unique_ptr<VbapTriangulation> _triangulation;
+
     apf::BlockParameter<Position> _reference_offset_position;
     Position _absolute_reference_offset_position;
 };
 
+/// Weights of one Source for one Output (in the current block).
+struct VbapRenderer::Contribution
+{
+  Output* output = nullptr;  ///< nullptr if unused
+  const _base::Source* source = nullptr;
+  sample_type old_weight = 0, new_weight = 0;
+  Contribution* next = nullptr;  ///< Next contribution to the same Output
+
+  using iterator = decltype(source->begin());
+
+  iterator begin() const { return source->begin(); }
+  iterator end() const { return source->end(); }
+};
+
+/** Singly linked list of Contribution%s.
+ * The list is re-built in each block, the elements are owned by the Source%s,
+ * therefore no memory has to be allocated in the realtime thread.
+ **/
+class VbapRenderer::ContributionList : apf::NonCopyable
+{
+  public:
+    using value_type = Contribution;
+
+    class iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Contribution;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Contribution*;
+        using reference = Contribution&;
+
+        explicit iterator(pointer ptr = nullptr) : _ptr(ptr) {}
+
+        reference operator*() const { return *_ptr; }
+        pointer operator->() const { return _ptr; }
+        iterator& operator++() { _ptr = _ptr->next; return *this; }
+
+        bool operator==(const iterator& rhs) const { return _ptr == rhs._ptr; }
+        bool operator!=(const iterator& rhs) const { return _ptr != rhs._ptr; }
+
+      private:
+        pointer _ptr;
+    };
+
+    ContributionList() : _first(nullptr), _last(&_first) {}
+
+    iterator begin() const { return iterator(_first); }
+    iterator end() const { return iterator(); }
+
+    void clear()
+    {
+      _first = nullptr;
+      _last = &_first;
+    }
+
+    void push_back(Contribution& contribution)
+    {
+      contribution.next = nullptr;
+      *_last = &contribution;
+      _last = &contribution.next;
+    }
+
+  private:
+    Contribution* _first;
+    Contribution** _last;
+};
+
 class VbapRenderer::Source : public _base::Source
 {
   public:
@@ -160,36 +260,54 @@ class VbapRenderer::Source : public _base::Source
 
     APF_PROCESS(Source, _base::Source)
     {
-      // NOTE: reference_offset_orientation doesn't affect rendering
+      // For static scenes, the weights of the last block are re-used
+      if (this->geometry_changed() && this->parent._triangulation)
+      {
+        _unweighted = _calculate_loudspeaker_weights_3d();
+      }
+      else if (this->geometry_changed())
+      {
+        // NOTE: reference_offset_orientation doesn't affect rendering
+
+        float incidence_angle = apf::math::wrap_two_pi(apf::math::deg2rad(
+              ((this->position
+                - this->parent._absolute_reference_offset_position)
+               .orientation() - this->parent.state.reference_orientation)
+              .azimuth));
 
-      float incidence_angle = apf::math::wrap_two_pi(apf::math::deg2rad(
-            ((this->position
-              - this->parent._absolute_reference_offset_position).orientation()
-             - this->parent.state.reference_orientation).azimuth));
+        auto l_begin = this->parent._sorted_loudspeakers.begin();
+        auto l_end = this->parent._sorted_loudspeakers.end();
 
-      auto l_begin = this->parent._sorted_loudspeakers.begin();
-      auto l_end = this->parent._sorted_loudspeakers.end();
+        auto second = apf::make_circular_iterator(l_begin, l_end
+            , std::upper_bound(l_begin, l_end, incidence_angle));
 
-      auto second = apf::make_circular_iterator(l_begin, l_end
-          , std::upper_bound(l_begin, l_end, incidence_angle));
+        auto first = second;
 
-      auto first = second;
+        --first;
 
-      --first;
+        _unweighted = _calculate_loudspeaker_weights(incidence_angle
+            , *first, *second);
+      }
+
+      for (size_t i = 0; i < _unweighted.size(); ++i)
+      {
+        auto weight = _unweighted[i];
 
-      auto weights = _calculate_loudspeaker_weights(incidence_angle
-          , *first, *second);
+        // Apply source volume, mute, ...
+        weight.weight *= this->weighting_factor;
 
-      // Apply source volume, mute, ...
-      weights.first.weight *= this->weighting_factor;
-      weights.second.weight *= this->weighting_factor;
+        this->loudspeaker_weights[i] = weight;
 
-      this->loudspeaker_weights = weights;
+        assert(this->loudspeaker_weights[i].exactly_one_assignment());
+      }
 
-      assert(this->loudspeaker_weights.first.exactly_one_assignment());
-      assert(this->loudspeaker_weights.second.exactly_one_assignment());
+      _update_contributions();
     }
 
+    /// Append contributions to the lists of their Outputs.
+    /// This must not be called for several Sources in parallel!
+    void link_contributions();
+
     bool get_output_levels(sample_type* first, sample_type* last) const
     {
       auto current = first;
@@ -198,17 +316,15 @@ class VbapRenderer::Source : public _base::Source
       {
         // TODO: handle subwoofers!
 
-        if (this->loudspeaker_weights.first.get().ls_ptr == &out)
-        {
-          *current = this->loudspeaker_weights.first.get().weight;
-        }
-        else if (this->loudspeaker_weights.second.get().ls_ptr == &out)
-        {
-          *current = this->loudspeaker_weights.second.get().weight;
-        }
-        else
+        *current = 0;
+
+        for (const auto& weight: this->loudspeaker_weights)
         {
-          *current = 0;
+          if (weight.get().ls_ptr == &out)
+          {
+            *current = weight.get().weight;
+            break;
+          }
         }
 
         ++current;
@@ -220,21 +336,26 @@ class VbapRenderer::Source : public _base::Source
     }
 
   private:
-    std::pair<LoudspeakerWeight, LoudspeakerWeight>
-    _calculate_loudspeaker_weights(float angle
+    weights_t _calculate_loudspeaker_weights(float angle
           , const LoudspeakerEntry& first, const LoudspeakerEntry& second);
+    weights_t _calculate_loudspeaker_weights_3d();
+
+    void _update_contributions();
+
+    // weights without source volume, only updated if geometry_changed()
+    weights_t _unweighted;
+
+    // old and new loudspeakers, unused entries have no output
+    std::array<Contribution, 6> _contributions;
 
   public:
-    std::pair<apf::BlockParameter<LoudspeakerWeight>
-            , apf::BlockParameter<LoudspeakerWeight>> loudspeaker_weights;
+    std::array<apf::BlockParameter<LoudspeakerWeight>, 3> loudspeaker_weights;
 };
 
 class VbapRenderer::RenderFunction
 {
   public:
-    RenderFunction(const Output& out) : _out(out) {}
-
-    apf::CombineChannelsResult::type select(const Source& in);
+    apf::CombineChannelsResult::type select(const Contribution& in);
 
     sample_type operator()(sample_type in)
     {
@@ -249,8 +370,6 @@ class VbapRenderer::RenderFunction
   private:
     sample_type _weight;
     apf::math::linear_interpolator<sample_type> _interpolator;
-
-    const Output& _out;
 };
 
 class VbapRenderer::Output : public _base::Output
@@ -258,7 +377,7 @@ class VbapRenderer::Output : public _base::Output
   public:
     Output(const Params& p)
       : _base::Output(p)
-      , _combiner(this->parent._source_list, this->buffer)
+      , _combiner(this->contributions, this->buffer)
     {
       // TODO: handle loudspeaker delays?
       // TODO: optional delay line?
@@ -266,11 +385,14 @@ class VbapRenderer::Output : public _base::Output
 
     APF_PROCESS(Output, _base::Output)
     {
-      _combiner.process(RenderFunction(*this));
+      _combiner.process(RenderFunction());
     }
 
+    /// Sources contributing to this Output in the current block
+    ContributionList contributions;
+
   private:
-    apf::CombineChannelsInterpolation<rtlist_proxy<Source>, buffer_type>
+    apf::CombineChannelsInterpolation<ContributionList&, buffer_type>
       _combiner;
 };
 
@@ -286,7 +408,11 @@ VbapRenderer::load_reproduction_setup()
   // TODO: get loudspeaker delays from setup?
   // delay_samples = size_t(delay * sample_rate + 0.5f)
 
-  for (const auto& out: rtlist_proxy<Output>(this->get_output_list()))
+  // Non-const access is needed for the lists of contributions
+  auto outputs = apf::make_cast_proxy<Output>(
+      const_cast<rtlist_t&>(this->get_output_list()));
+
+  for (auto& out: outputs)
   {
     if (out.model == Loudspeaker::subwoofer)
     {
@@ -303,46 +429,121 @@ VbapRenderer::load_reproduction_setup()
     throw std::logic_error("No loudspeakers found!");
   }
 
+  if (std::any_of(_sorted_loudspeakers.begin(), _sorted_loudspeakers.end()
+        , [] (const LoudspeakerEntry& ls)
+        {
+          return ls.ls_ptr->position.z != 0;
+        }))
+  {
+    VERBOSE("Loudspeakers are not in one plane, using 3-D VBAP.");
+
+    _directions.resize(_sorted_loudspeakers.size());
+    for (size_t i = 0; i < _directions.size(); ++i)
+    {
+      _directions[i] = _sorted_loudspeakers[i].ls_ptr->position
+        - _reference_offset_position;
+    }
+    _triangulation.reset(new VbapTriangulation(_directions));
+    return;
+  }
+
   _update_angles();
   _sort_loudspeakers();
   _update_valid_sections();
 }
 
 apf::CombineChannelsResult::type
-VbapRenderer::RenderFunction::select(const Source& in)
+VbapRenderer::RenderFunction::select(const Contribution& in)
+{
+  using namespace apf::CombineChannelsResult;
+
+  if (in.old_weight == in.new_weight)
+  {
+    _weight = in.new_weight;
+    return constant;
+  }
+  else
+  {
+    _interpolator.set(in.old_weight, in.new_weight
+        , in.source->parent.block_size());
+    return change;
+  }
+}
+
+void
+VbapRenderer::Source::_update_contributions()
 {
-  const auto& ls = in.loudspeaker_weights;
+  const auto& ls = this->loudspeaker_weights;
 
-  assert(ls.first.get().ls_ptr != ls.second.get().ls_ptr
-      || ls.first.get().ls_ptr == nullptr);
+  assert(ls[0].get().ls_ptr != ls[1].get().ls_ptr
+      || ls[0].get().ls_ptr == nullptr);
 
-  auto get_weight = [this] (const LoudspeakerWeight& first
-      , const LoudspeakerWeight& second)
+  auto get_weight = [&ls] (const Output* out, bool old)
   {
-    float weight = 0;
-    if (first.ls_ptr == &_out) { weight = first.weight; }
-    else if (second.ls_ptr == &_out) { weight = second.weight; }
-    return weight;
+    for (const auto& weight: ls)
+    {
+      const auto& w = old ? weight.old() : weight.get();
+      if (w.ls_ptr == out) return w.weight;
+    }
+    return 0.0f;
   };
 
-  auto old_weight = get_weight(ls.first.old(), ls.second.old());
-  auto new_weight = get_weight(ls.first, ls.second);
+  auto contribution = _contributions.begin();
 
-  using namespace apf::CombineChannelsResult;
+  for (auto out: { ls[0].old().ls_ptr, ls[1].old().ls_ptr, ls[2].old().ls_ptr
+      , ls[0].get().ls_ptr, ls[1].get().ls_ptr, ls[2].get().ls_ptr })
+  {
+    if (out == nullptr
+        || std::any_of(_contributions.begin(), contribution
+          , [out] (const Contribution& other) { return other.output == out; }))
+    {
+      continue;
+    }
+
+    auto old_weight = get_weight(out, true);
+    auto new_weight = get_weight(out, false);
 
-  if (old_weight == 0 && new_weight == 0)
+    if (old_weight == 0 && new_weight == 0) continue;
+
+    contribution->output = out;
+    contribution->source = this;
+    contribution->old_weight = old_weight;
+    contribution->new_weight = new_weight;
+    ++contribution;
+  }
+
+  for (; contribution != _contributions.end(); ++contribution)
   {
-    return nothing;
+    contribution->output = nullptr;
   }
-  else if (old_weight == new_weight)
+}
+
+void
+VbapRenderer::Source::link_contributions()
+{
+  for (auto& contribution: _contributions)
   {
-    _weight = new_weight;
-    return constant;
+    if (contribution.output)
+    {
+      contribution.output->contributions.push_back(contribution);
+    }
   }
-  else
+}
+
+/// Each Source contributes to at most four Outputs (two for the old and two
+/// for the new loudspeaker pair; six for 3-D VBAP).  The sparse lists of
+/// contributions are built here (in one thread), afterwards each Output only
+/// has to mix its own contributions instead of checking all Sources.
+void
+VbapRenderer::_link_contributions()
+{
+  for (auto& ls: _sorted_loudspeakers)
   {
-    _interpolator.set(old_weight, new_weight, in.parent.block_size());
-    return change;
+    ls.ls_ptr->contributions.clear();
+  }
+  for (auto& source: apf::make_cast_proxy<Source>(_source_list))
+  {
+    source.link_contributions();
   }
 }
 
@@ -358,6 +559,21 @@ VbapRenderer::_update_angles()
   }
 }
 
+void
+VbapRenderer::_update_directions()
+{
+  assert(_directions.size() == _sorted_loudspeakers.size());
+
+  for (size_t i = 0; i < _directions.size(); ++i)
+  {
+    // NOTE: reference_offset_orientation doesn't affect rendering
+    _directions[i] = _sorted_loudspeakers[i].ls_ptr->position
+      - _reference_offset_position;
+  }
+
+  _triangulation->update_directions(_directions);
+}
+
 void
 VbapRenderer::_sort_loudspeakers()
 {
@@ -386,14 +602,14 @@ VbapRenderer::_update_valid_sections()
   }
 }
 
-std::pair<VbapRenderer::LoudspeakerWeight, VbapRenderer::LoudspeakerWeight>
+VbapRenderer::weights_t
 VbapRenderer::Source::_calculate_loudspeaker_weights(float source_angle
     , const LoudspeakerEntry& first, const LoudspeakerEntry& second)
 {
   using namespace apf::math;
 
-  // Constructed with defaults: nullptr/0.0
-  std::pair<LoudspeakerWeight, LoudspeakerWeight> weights;
+  // Constructed with defaults: nullptr/0.0, the third one is not used
+  weights_t weights;
 
   if (first.valid_section)
   {
@@ -408,11 +624,11 @@ VbapRenderer::Source::_calculate_loudspeaker_weights(float source_angle
     float num2 = std::sin(phi) * std::cos(phi_0);
     float den  = 2 * std::cos(phi_0) * std::sin(phi_0);
 
-    weights.second.weight = (num1 + num2) / den;
-    weights.first.weight = (num1 - num2) / den;
+    weights[1].weight = (num1 + num2) / den;
+    weights[0].weight = (num1 - num2) / den;
 
-    weights.second.ls_ptr = second.ls_ptr;
-    weights.first.ls_ptr = first.ls_ptr;
+    weights[1].ls_ptr = second.ls_ptr;
+    weights[0].ls_ptr = first.ls_ptr;
   }
   else
   {
@@ -423,16 +639,42 @@ VbapRenderer::Source::_calculate_loudspeaker_weights(float source_angle
 
     if (overhang < max_overhang)
     {
-      weights.first.weight = overhang_func(overhang);
-      weights.first.ls_ptr = first.ls_ptr;
+      weights[0].weight = overhang_func(overhang);
+      weights[0].ls_ptr = first.ls_ptr;
     }
 
     overhang = wrap_two_pi(second.angle - source_angle);
 
     if (overhang < max_overhang)
     {
-      weights.second.weight = overhang_func(overhang);
-      weights.second.ls_ptr = second.ls_ptr;
+      weights[1].weight = overhang_func(overhang);
+      weights[1].ls_ptr = second.ls_ptr;
+    }
+  }
+  return weights;
+}
+
+VbapRenderer::weights_t
+VbapRenderer::Source::_calculate_loudspeaker_weights_3d()
+{
+  auto direction
+    = this->position - this->parent._absolute_reference_offset_position;
+
+  // only around the z-axis, the elevation of the reference is ignored
+  direction.rotate(-this->parent.state.reference_orientation.get().azimuth);
+
+  weights_t weights;
+  VbapTriangulation::gains_t gains;
+
+  auto triangle = this->parent._triangulation->find(direction, gains);
+
+  if (triangle)
+  {
+    for (size_t i = 0; i < 3; ++i)
+    {
+      weights[i].ls_ptr
+        = this->parent._sorted_loudspeakers[triangle->loudspeakers[i]].ls_ptr;
+      weights[i].weight = gains[i];
     }
   }
   return weights;
@@ -0,0 +1,581 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// Triangulation of loudspeaker directions for 3-D VBAP.
+
+#ifndef SSR_VBAPTRIANGULATION_H
+#define SSR_VBAPTRIANGULATION_H
+
+#include <array>
+#include <vector>
+#include <utility>  // for std::pair
+#include <algorithm>  // for std::sort(), std::unique(), std::min(), ...
+#include <limits>  // for std::numeric_limits
+#include <cmath>  // for std::sqrt(), std::abs()
+#include <stdexcept>  // for std::logic_error
+
+#include "position.h"
+
+namespace ssr
+{
+
+/** Triangulation of loudspeaker directions for 3-D VBAP.
+ * The triangles are the faces of the convex hull of the loudspeaker
+ * directions (normalized to unit length), see Ville Pulkki, "Virtual Sound
+ * Source Positioning Using Vector Base Amplitude Panning", JAES, 1997.
+ *
+ * For each triangle, the inverse of the matrix of its three loudspeaker
+ * directions is stored.  The gains for a given source direction are then
+ * obtained with a single matrix-vector multiplication.
+ *
+ * To quickly find the triangle containing a given direction, a cube map is
+ * used: Each of the six faces of a cube is divided into @p grid_size x
+ * @p grid_size cells and each cell stores a (short) list of the triangles
+ * which may contain directions pointing into this cell.
+ *
+ * The triangulation is calculated in the constructor (which is not realtime
+ * safe), update_directions() and find() don't allocate any memory.
+ **/
+class VbapTriangulation
+{
+  public:
+    using gains_t = std::array<float, 3>;
+
+    struct Triangle
+    {
+      /// Indices into the list of directions given to the constructor
+      std::array<size_t, 3> loudspeakers;
+      /// Loudspeaker base matrix (normalized directions, one per row)
+      std::array<float, 9> base;
+      /// Inverse of the loudspeaker base matrix (one row per loudspeaker)
+      std::array<float, 9> inverse;
+      /// @c false if the loudspeakers are in one plane with the origin
+      bool valid;
+
+      /// Calculate gains for (normalized) @p dir, return the smallest gain.
+      float get_gains(const Position& dir, gains_t& gains) const
+      {
+        for (size_t i = 0; i < 3; ++i)
+        {
+          gains[i] = inverse[3 * i] * dir.x + inverse[3 * i + 1] * dir.y
+            + inverse[3 * i + 2] * dir.z;
+        }
+        return std::min(gains[0], std::min(gains[1], gains[2]));
+      }
+    };
+
+    explicit VbapTriangulation(const std::vector<Position>& directions
+        , size_t grid_size = 8);
+
+    void update_directions(const std::vector<Position>& directions);
+
+    const Triangle* find(Position direction, gains_t& gains) const;
+
+    const std::vector<Triangle>& triangles() const { return _triangles; }
+
+  private:
+    using vec3 = std::array<double, 3>;
+    using face_t = std::array<size_t, 3>;
+
+    static vec3 _normalize(const Position& p);
+    static vec3 _unit_vector(const Position& p);
+    static vec3 _sub(const vec3& a, const vec3& b);
+    static vec3 _cross(const vec3& a, const vec3& b);
+    static double _dot(const vec3& a, const vec3& b);
+
+    static std::vector<face_t> _convex_hull(const std::vector<vec3>& points);
+
+    void _update_triangle(Triangle& t, const std::vector<Position>& dirs);
+    size_t _cell(const Position& dir) const;
+    void _create_cube_map(const std::vector<vec3>& points);
+
+    /// Tolerance for gains at the border of a triangle
+    static constexpr float _tolerance = 1e-5f;
+
+    std::vector<Triangle> _triangles;
+    size_t _grid_size;
+    /// Start of the candidate list of each cell (and end of the last one)
+    std::vector<size_t> _cell_begin;
+    /// Concatenated candidate lists of all cells (indices into _triangles)
+    std::vector<size_t> _candidates;
+};
+
+/** Constructor.
+ * @param directions loudspeaker positions relative to the reference point,
+ *   the length doesn't matter
+ * @param grid_size number of cells per edge of each cube face
+ * @throw std::logic_error if the loudspeakers don't span a 3-D space
+ **/
+inline
+VbapTriangulation::VbapTriangulation(const std::vector<Position>& directions
+    , size_t grid_size)
+  : _grid_size(std::max(grid_size, size_t(1)))
+{
+  std::vector<vec3> points;
+  for (const auto& dir: directions)
+  {
+    points.push_back(_normalize(dir));
+  }
+
+  for (const auto& face: _convex_hull(points))
+  {
+    _triangles.push_back(Triangle());
+    _triangles.back().loudspeakers = face;
+  }
+
+  this->update_directions(directions);
+
+  if (std::none_of(_triangles.begin(), _triangles.end()
+        , [] (const Triangle& t) { return t.valid; }))
+  {
+    throw std::logic_error("VbapTriangulation: No valid triangles!");
+  }
+
+  _create_cube_map(points);
+}
+
+/// Re-calculate the inverse base matrices (e.g. if the reference offset has
+/// changed).  The triangulation itself and the cube map are not changed.
+/// This doesn't throw, triangles with a loudspeaker at the reference point
+/// become invalid.
+/// @param directions same number and order as given to the constructor
+inline void
+VbapTriangulation::update_directions(const std::vector<Position>& directions)
+{
+  for (auto& t: _triangles)
+  {
+    _update_triangle(t, directions);
+  }
+}
+
+/** Find triangle which contains @p direction and calculate the gains.
+ * If no triangle contains @p direction (e.g. below a hemispherical array),
+ * the closest triangle is used, negative gains are set to zero and the
+ * remaining gains are scaled to get a resulting vector of unit length.
+ * @return the triangle (whose loudspeakers belong to @p gains), @b nullptr if
+ *   no triangle is valid
+ **/
+inline const VbapTriangulation::Triangle*
+VbapTriangulation::find(Position direction, gains_t& gains) const
+{
+  float length = direction.length();
+  if (length == 0)
+  {
+    direction = Position(1.0f, 0.0f, 0.0f);  // arbitrary direction
+  }
+  else
+  {
+    direction = direction / length;
+  }
+
+  size_t cell = _cell(direction);
+  for (size_t i = _cell_begin[cell]; i < _cell_begin[cell + 1]; ++i)
+  {
+    const auto& t = _triangles[_candidates[i]];
+    // may have become invalid in update_directions()
+    if (!t.valid) continue;
+    if (t.get_gains(direction, gains) >= -_tolerance)
+    {
+      for (auto& g: gains) { g = std::max(g, 0.0f); }
+      return &t;
+    }
+  }
+
+  // Fallback: check all triangles, use the one with the largest minimum gain.
+  // This can happen at the "open" side of the array or if the directions
+  // have changed since the cube map was created.
+  const Triangle* best = nullptr;
+  float best_min = -std::numeric_limits<float>::max();
+  for (const auto& t: _triangles)
+  {
+    if (!t.valid) continue;
+
+    gains_t temp;
+    float min = t.get_gains(direction, temp);
+    if (min > best_min)
+    {
+      best_min = min;
+      best = &t;
+      gains = temp;
+    }
+  }
+
+  if (best)
+  {
+    for (auto& g: gains) { g = std::max(g, 0.0f); }
+
+    Position result;
+    for (size_t i = 0; i < 3; ++i)
+    {
+      result += Position(gains[i] * best->base[3 * i]
+          , gains[i] * best->base[3 * i + 1], gains[i] * best->base[3 * i + 2]);
+    }
+    float result_length = result.length();
+    if (result_length > 0)
+    {
+      for (auto& g: gains) { g /= result_length; }
+    }
+  }
+  return best;
+}
+
+/// @throw std::logic_error if @p p has zero length
+inline VbapTriangulation::vec3
+VbapTriangulation::_normalize(const Position& p)
+{
+  if (p.length() == 0)
+  {
+    throw std::logic_error("VbapTriangulation: Loudspeaker at reference!");
+  }
+  return _unit_vector(p);
+}
+
+/// Like _normalize(), but a zero vector is returned for zero length.
+inline VbapTriangulation::vec3
+VbapTriangulation::_unit_vector(const Position& p)
+{
+  double length = p.length();
+  if (length == 0) return {{0, 0, 0}};
+  return {{p.x / length, p.y / length, p.z / length}};
+}
+
+inline VbapTriangulation::vec3
+VbapTriangulation::_sub(const vec3& a, const vec3& b)
+{
+  return {{a[0] - b[0], a[1] - b[1], a[2] - b[2]}};
+}
+
+inline VbapTriangulation::vec3
+VbapTriangulation::_cross(const vec3& a, const vec3& b)
+{
+  return {{a[1] * b[2] - a[2] * b[1]
+         , a[2] * b[0] - a[0] * b[2]
+         , a[0] * b[1] - a[1] * b[0]}};
+}
+
+inline double
+VbapTriangulation::_dot(const vec3& a, const vec3& b)
+{
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/** Incremental convex hull.
+ * Each new point removes all faces it can "see" and is connected to the
+ * horizon edges of the removed faces.  This is O(N^2), which is fast enough
+ * for a few hundred loudspeakers.
+ * @return faces, vertices in counter-clockwise order (seen from outside)
+ **/
+inline std::vector<VbapTriangulation::face_t>
+VbapTriangulation::_convex_hull(const std::vector<vec3>& p)
+{
+  const double eps = 1e-9;
+  size_t n = p.size();
+
+  if (n < 4)
+  {
+    throw std::logic_error(
+        "VbapTriangulation: At least 4 loudspeakers are needed!");
+  }
+
+  // Initial tetrahedron: spanning as much volume as possible
+
+  size_t i0 = 0, i1 = 0, i2 = 0, i3 = 0;
+  double max = 0;
+  for (size_t i = 1; i < n; ++i)
+  {
+    auto d = _sub(p[i], p[i0]);
+    if (_dot(d, d) > max) { max = _dot(d, d); i1 = i; }
+  }
+  max = 0;
+  for (size_t i = 1; i < n; ++i)
+  {
+    auto normal = _cross(_sub(p[i1], p[i0]), _sub(p[i], p[i0]));
+    if (_dot(normal, normal) > max) { max = _dot(normal, normal); i2 = i; }
+  }
+  auto base_normal = _cross(_sub(p[i1], p[i0]), _sub(p[i2], p[i0]));
+  max = 0;
+  for (size_t i = 1; i < n; ++i)
+  {
+    double dist = std::abs(_dot(base_normal, _sub(p[i], p[i0])));
+    if (dist > max) { max = dist; i3 = i; }
+  }
+  if (max < eps)
+  {
+    throw std::logic_error(
+        "VbapTriangulation: Loudspeakers are not in three dimensions!");
+  }
+
+  vec3 inside = {{(p[i0][0] + p[i1][0] + p[i2][0] + p[i3][0]) / 4
+                , (p[i0][1] + p[i1][1] + p[i2][1] + p[i3][1]) / 4
+                , (p[i0][2] + p[i1][2] + p[i2][2] + p[i3][2]) / 4}};
+
+  struct Face
+  {
+    face_t v;
+    vec3 normal;  // normalized, pointing outwards
+    double offset;
+  };
+
+  std::vector<Face> faces;
+
+  auto add_face = [&] (size_t v0, size_t v1, size_t v2)
+  {
+    auto normal = _cross(_sub(p[v1], p[v0]), _sub(p[v2], p[v0]));
+    double length = std::sqrt(_dot(normal, normal));
+    if (length > 0)
+    {
+      for (auto& x: normal) { x /= length; }
+    }
+    faces.push_back({{{v0, v1, v2}}, normal, _dot(normal, p[v0])});
+  };
+
+  for (auto f: { face_t{{i0, i1, i2}}, face_t{{i0, i1, i3}}
+               , face_t{{i0, i2, i3}}, face_t{{i1, i2, i3}} })
+  {
+    add_face(f[0], f[1], f[2]);
+    if (_dot(faces.back().normal, inside) - faces.back().offset > 0)
+    {
+      faces.pop_back();
+      add_face(f[0], f[2], f[1]);
+    }
+  }
+
+  std::vector<std::pair<size_t, size_t>> edges, horizon;
+  std::vector<char> visible;
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (i == i0 || i == i1 || i == i2 || i == i3) continue;
+
+    visible.assign(faces.size(), false);
+    edges.clear();
+    for (size_t f = 0; f < faces.size(); ++f)
+    {
+      if (_dot(faces[f].normal, p[i]) - faces[f].offset > eps)
+      {
+        visible[f] = true;
+        const auto& v = faces[f].v;
+        edges.emplace_back(v[0], v[1]);
+        edges.emplace_back(v[1], v[2]);
+        edges.emplace_back(v[2], v[0]);
+      }
+    }
+
+    if (edges.empty()) continue;  // point is inside (or a duplicate)
+
+    // Horizon: edges of visible faces which are not shared with another
+    // visible face (i.e. the reverse edge doesn't exist).
+    std::sort(edges.begin(), edges.end());
+    horizon.clear();
+    for (const auto& e: edges)
+    {
+      if (!std::binary_search(edges.begin(), edges.end()
+            , std::make_pair(e.second, e.first)))
+      {
+        horizon.push_back(e);
+      }
+    }
+
+    size_t f = 0;
+    faces.erase(std::remove_if(faces.begin(), faces.end()
+          , [&] (const Face&) { return visible[f++]; }), faces.end());
+
+    for (const auto& e: horizon)
+    {
+      add_face(e.first, e.second, i);
+    }
+  }
+
+  std::vector<face_t> result;
+  for (const auto& face: faces)
+  {
+    result.push_back(face.v);
+  }
+  return result;
+}
+
+inline void
+VbapTriangulation::_update_triangle(Triangle& t
+    , const std::vector<Position>& dirs)
+{
+  // This is used in the realtime thread, therefore it must not throw.
+  // A loudspeaker at the reference point leads to det == 0 (see below).
+  auto l = std::array<vec3, 3>{{ _unit_vector(dirs[t.loudspeakers[0]])
+    , _unit_vector(dirs[t.loudspeakers[1]])
+    , _unit_vector(dirs[t.loudspeakers[2]]) }};
+
+  // Gain of each loudspeaker: scalar triple product with the other two
+  auto rows = std::array<vec3, 3>{{ _cross(l[1], l[2]), _cross(l[2], l[0])
+    , _cross(l[0], l[1]) }};
+
+  double det = _dot(l[0], rows[0]);
+
+  // Faces are counter-clockwise, det is only positive if the origin is
+  // inside of the hull and the loudspeakers aren't in one plane with it.
+  t.valid = det > 1e-6;
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      t.base[3 * i + j] = static_cast<float>(l[i][j]);
+      t.inverse[3 * i + j] = t.valid ? static_cast<float>(rows[i][j] / det) : 0;
+    }
+  }
+}
+
+/// Cube face (axis with the largest component, sign) and cell within it.
+inline size_t
+VbapTriangulation::_cell(const Position& dir) const
+{
+  float abs_x = std::abs(dir.x), abs_y = std::abs(dir.y)
+    , abs_z = std::abs(dir.z);
+
+  size_t face;
+  float major, u, v;
+
+  if (abs_x >= abs_y && abs_x >= abs_z)
+  {
+    face = dir.x < 0; major = abs_x; u = dir.y; v = dir.z;
+  }
+  else if (abs_y >= abs_z)
+  {
+    face = 2 + (dir.y < 0); major = abs_y; u = dir.z; v = dir.x;
+  }
+  else
+  {
+    face = 4 + (dir.z < 0); major = abs_z; u = dir.x; v = dir.y;
+  }
+
+  if (major == 0) return 0;
+
+  auto index = [this] (float coordinate)
+  {
+    // coordinate is in the range [-1, 1]
+    auto i = static_cast<size_t>(std::max((coordinate + 1) / 2
+          * static_cast<float>(_grid_size), 0.0f));
+    return std::min(i, _grid_size - 1);
+  };
+
+  return (face * _grid_size + index(u / major)) * _grid_size + index(v / major);
+}
+
+/** Find candidate triangles for each cell of the cube map.
+ * Each cell is sampled on a regular grid (including its border), all
+ * triangles containing a sample point are candidates for this cell.
+ * Triangles which are smaller than the sample spacing are added to the cells
+ * of their corners.
+ **/
+inline void
+VbapTriangulation::_create_cube_map(const std::vector<vec3>& points)
+{
+  const size_t samples = 4;  // per cell edge
+
+  size_t cells = 6 * _grid_size * _grid_size;
+  std::vector<std::vector<size_t>> lists(cells);
+
+  for (size_t face = 0; face < 6; ++face)
+  {
+    float sign = (face % 2) ? -1.0f : 1.0f;
+
+    for (size_t i = 0; i < _grid_size * samples + 1; ++i)
+    {
+      for (size_t j = 0; j < _grid_size * samples + 1; ++j)
+      {
+        float u = 2.0f * static_cast<float>(i)
+          / static_cast<float>(_grid_size * samples) - 1.0f;
+        float v = 2.0f * static_cast<float>(j)
+          / static_cast<float>(_grid_size * samples) - 1.0f;
+
+        Position dir;
+        switch (face / 2)
+        {
+          case 0: dir = Position(sign, u, v); break;
+          case 1: dir = Position(v, sign, u); break;
+          default: dir = Position(u, v, sign); break;
+        }
+        dir = dir / dir.length();
+
+        // Sample points on the border belong to several cells
+        size_t ci = i / samples, cj = j / samples;
+        for (size_t di = (i % samples == 0 && ci > 0) ? 1 : 0; ; --di)
+        {
+          for (size_t dj = (j % samples == 0 && cj > 0) ? 1 : 0; ; --dj)
+          {
+            size_t cell_i = std::min(ci - di, _grid_size - 1);
+            size_t cell_j = std::min(cj - dj, _grid_size - 1);
+            size_t cell = (face * _grid_size + cell_i) * _grid_size + cell_j;
+
+            for (size_t t = 0; t < _triangles.size(); ++t)
+            {
+              gains_t gains;
+              if (_triangles[t].valid
+                  && _triangles[t].get_gains(dir, gains) >= -_tolerance)
+              {
+                lists[cell].push_back(t);
+              }
+            }
+            if (dj == 0) break;
+          }
+          if (di == 0) break;
+        }
+      }
+    }
+  }
+
+  for (size_t t = 0; t < _triangles.size(); ++t)
+  {
+    if (!_triangles[t].valid) continue;
+
+    for (auto index: _triangles[t].loudspeakers)
+    {
+      const auto& corner = points[index];
+      lists[_cell(Position(static_cast<float>(corner[0])
+              , static_cast<float>(corner[1])
+              , static_cast<float>(corner[2])))].push_back(t);
+    }
+  }
+
+  _cell_begin.clear();
+  _candidates.clear();
+  for (auto& list: lists)
+  {
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    _cell_begin.push_back(_candidates.size());
+    _candidates.insert(_candidates.end(), list.begin(), list.end());
+  }
+  _cell_begin.push_back(_candidates.size());
+}
+
+}  // namespace ssr
+
+#endif
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='
@@ -33,11 +33,15 @@
 #include "loudspeakerrenderer.h"
 #include "ssr_global.h"
 
-#include "apf/convolver.h"  // for apf::conv::...
+#include "apf/nonuniform_convolver.h"  // for apf::conv::nonuniform::...
 #include "apf/blockdelayline.h"  // for NonCausalBlockDelayLine
+#include "apf/fractional_delay.h"  // for DelayInterpolator
 #include "apf/sndfiletools.h"  // for apf::load_sndfile
 #include "apf/combine_channels.h"  // for apf::raised_cosine_fade, ...
 
+#include <vector>
+#include <algorithm>  // for std::max(), std::fill()
+
 // TODO: make more flexible option:
 #define WEIGHTING_OLD
 //#define WEIGHTING_DELFT
@@ -95,18 +99,46 @@ class WfsRenderer : public SourceToOutput<WfsRenderer, LoudspeakerRenderer>
       // TODO: warning if size changed?
       // TODO: warning if size == 0?
 
-      _pre_filter.reset(new apf::conv::Filter(this->block_size()
+      _pre_filter.reset(new apf::conv::nonuniform::Filter(
+            apf::conv::nonuniform::Layout(this->block_size(), size
+              , this->params.get("nonuniform_partitions", 0)
+              , this->params.get("nonuniform_max_block_size", 0))
             , ir.begin(), ir.end()));
+
+      auto interpolation = this->params.get("delay_interpolation", "none");
+      if (interpolation != "none")
+      {
+        _interpolator.reset(new apf::DelayInterpolator<sample_type>(
+              apf::DelayInterpolator<sample_type>::from_string(interpolation)
+              , this->params.get("delay_interpolation_order", 3u)));
+      }
     }
 
+    void load_reproduction_setup();
+
     APF_PROCESS(WfsRenderer, _base)
     {
       this->_process_list(_source_list);
     }
 
   private:
+    /// Loudspeaker data as structure of arrays (in the same order as the
+    /// output list), used for computing the driving functions of all
+    /// loudspeakers at once. Positions and orientations are @e not transformed
+    /// according to the reference.
+    struct LoudspeakerArrays
+    {
+      std::vector<float> x, y;  ///< position
+      std::vector<float> nx, ny;  ///< unit vector in loudspeaker direction
+      std::vector<float> weight;  ///< tapering weight
+      std::vector<char> subwoofer;
+    };
+
     apf::raised_cosine_fade<sample_type> _fade;
-    std::unique_ptr<apf::conv::Filter> _pre_filter;
+    LoudspeakerArrays _loudspeakers;
+    std::unique_ptr<apf::conv::nonuniform::Filter> _pre_filter;
+    // Only for fractional delays, otherwise nullptr
+    std::unique_ptr<apf::DelayInterpolator<sample_type>> _interpolator;
 
     size_t _max_delay, _initial_delay;
 };
@@ -120,7 +152,10 @@ class WfsRenderer::Input : public _base::Input
       : _base::Input(p)
       // TODO: check if _pre_filter != 0!
       , _convolver(*this->parent._pre_filter)
+      // The interpolator needs a few more samples
       , _delayline(this->parent.block_size(), this->parent._max_delay
+          + (this->parent._interpolator ? this->parent._interpolator->taps()
+            : 0)
           , this->parent._initial_delay)
     {}
 
@@ -131,7 +166,7 @@ class WfsRenderer::Input : public _base::Input
     }
 
   private:
-    apf::conv::StaticConvolver _convolver;
+    apf::conv::nonuniform::StaticConvolver _convolver;
     apf::NonCausalBlockDelayLine<sample_type> _delayline;
 };
 
@@ -139,18 +174,18 @@ class WfsRenderer::SourceChannel : public apf::has_begin_and_end<
                           apf::NonCausalBlockDelayLine<sample_type>::circulator>
 {
   public:
-    SourceChannel(const Source& s)
-      : crossfade_mode(0)
-      , weighting_factor(0.0f)
-      , delay(0)
-      , source(s)
-    {}
+    SourceChannel(const Source& s);
 
     void update();
 
+    /// Position of this channel within Source::sourcechannels (and therefore
+    /// of the corresponding Output in the output list).
+    size_t index() const;
+
     int crossfade_mode;
     apf::BlockParameter<sample_type> weighting_factor;
     apf::BlockParameter<int> delay;
+    apf::BlockParameter<float> fractional_delay;  ///< for DelayInterpolator
 
     const Source& source;
 
@@ -164,7 +199,7 @@ class WfsRenderer::SourceChannel : public apf::has_begin_and_end<
 class WfsRenderer::RenderFunction
 {
   public:
-    RenderFunction(const Output& out) : _in(0), _out(out) {}
+    RenderFunction(Output& out) : _in(0), _out(out) {}
 
     apf::CombineChannelsResult::type select(SourceChannel& in);
 
@@ -185,20 +220,26 @@ class WfsRenderer::RenderFunction
     }
 
   private:
+    apf::CombineChannelsResult::type _select_interpolated(SourceChannel& in
+        , float float_delay, sample_type weighting_factor);
+
     sample_type _old_factor, _new_factor;
 
     SourceChannel* _in;
-    const Output& _out;
+    Output& _out;
 };
 
 class WfsRenderer::Output : public _base::Output
 {
   public:
     friend class Source;  // to be able to see _sourcechannels
+    friend class RenderFunction;  // to be able to use _interpolation_buffer
 
     Output(const Params& p)
       : _base::Output(p)
       , _combiner(this->sourcechannels, this->buffer, this->parent._fade)
+      , _interpolation_buffer(this->parent._interpolator
+          ? this->parent.block_size() + 1 : 0)
     {}
 
     APF_PROCESS(Output, _base::Output)
@@ -210,17 +251,30 @@ class WfsRenderer::Output : public _base::Output
     apf::CombineChannelsCrossfade<apf::cast_proxy<SourceChannel
       , sourcechannels_t>, buffer_type
       , apf::raised_cosine_fade<sample_type>> _combiner;
+
+    /// Signal with fractional delay (only if DelayInterpolator is used).
+    /// It is re-used for all SourceChannels, because the combiner reads it
+    /// right after RenderFunction::select().
+    /// It has one more element than the block size, otherwise the circulators
+    /// SourceChannel::_begin and SourceChannel::_end would be equal.
+    apf::fixed_vector<sample_type> _interpolation_buffer;
 };
 
 class WfsRenderer::Source : public _base::Source
 {
   private:
     void _process();
+    void _update_driving_functions();
 
   public:
     Source(const Params& p)
       : _base::Source(p, p.parent->get_output_list().size(), *this)
       , delayline(p.input->_delayline)
+      , delays(this->sourcechannels.size())
+      , weights(this->sourcechannels.size())
+      , _focused(false)
+      , _distance(this->sourcechannels.size())
+      , _projection(this->sourcechannels.size())
     {}
 
     APF_PROCESS(Source, _base::Source)
@@ -244,281 +298,284 @@ class WfsRenderer::Source : public _base::Source
 
     const apf::NonCausalBlockDelayLine<sample_type>& delayline;
 
-  //private:
+    /// Driving functions for all loudspeakers: delays in samples and weights
+    /// (without the source gain). They are only re-computed if
+    /// geometry_changed().
+    apf::fixed_vector<float> delays, weights;
+
+  private:
     bool _focused;
+
+    // temporary arrays for _update_driving_functions()
+    apf::fixed_vector<float> _distance, _projection;
 };
 
 void WfsRenderer::Source::_process()
 {
-  if (this->model == ::Source::plane)
+  // For static scenes, the driving functions of the last block are re-used
+  if (this->geometry_changed())
   {
-    // do nothing, focused-ness is irrelevant for plane waves
-    _focused = false;
-  }
-  else
-  {
-    _focused = true;
-    for (const auto& out: rtlist_proxy<Output>(_input.parent.get_output_list()))
-    {
-      // subwoofers have to be ignored!
-      if (out.model == Loudspeaker::subwoofer) continue;
-
-      // TODO: calculate with inner product
-
-      // angle (modulo) between the line connecting source<->loudspeaker
-      // and the loudspeaker orientation
-
-      // TODO: avoid getting reference 2 times (see select())
-      auto ls = DirectionalPoint(out);
-      auto ref = DirectionalPoint(out.parent.state.reference_position
-          , out.parent.state.reference_orientation);
-      ls.transform(ref);
-
-      auto a = apf::math::wrap(angle(ls.position - this->position
-            , ls.orientation), 2 * apf::math::pi<sample_type>());
-
-      auto halfpi = apf::math::pi<sample_type>()/2;
-
-      if (a < halfpi || a > 3 * halfpi)
-      {
-        // if at least one loudspeaker "turns its back" to the source, the
-        // source is considered non-focused
-        _focused = false;
-        break;
-      }
-    }
+    _update_driving_functions();
   }
 
   // TODO: active sources?
 }
 
-void WfsRenderer::SourceChannel::update()
+/** Compute delays and weights for all loudspeakers.
+ * Instead of transforming each loudspeaker according to the reference, the
+ * source (and the reference offset) is transformed into the coordinate system
+ * of the loudspeakers, which doesn't change distances and angles.
+ * The loops over the loudspeakers are free of branches and trigonometric
+ * functions (the cosine of an angle is computed with an inner product),
+ * therefore the compiler can vectorize them.
+ **/
+void WfsRenderer::Source::_update_driving_functions()
 {
-  _begin = this->source.delayline.get_read_circulator(this->delay);
-  _end = _begin + source.parent.block_size();
-}
-
-apf::CombineChannelsResult::type
-WfsRenderer::RenderFunction::select(SourceChannel& in)
-{
-  _in = &in;
+  const auto& ls = this->parent._loudspeakers;
+  const size_t n = this->delays.size();
+  assert(ls.x.size() == n);
 
   // define a restricted area around loudspeakers to avoid division by zero:
   const float safety_radius = 0.01f; // 1 cm
 
-  // TODO: move reference calculation to WfsRenderer::Process?
-  auto ref = DirectionalPoint(_out.parent.state.reference_position
-      , _out.parent.state.reference_orientation);
+  const auto& state = this->parent.state;
+
+  auto ref = DirectionalPoint(state.reference_position
+      , state.reference_orientation);
 
   // TODO: this is actually wrong!
   // We use it to be compatible with the (also wrong) GUI implementation.
   auto ref_off = ref;
-  ref_off.transform(DirectionalPoint(
-        _out.parent.state.reference_offset_position
-        , _out.parent.state.reference_offset_orientation));
-
-  sample_type weighting_factor = 1;
-  float float_delay = 0;
-
-  auto ls = Loudspeaker(_out);
-  auto src_pos = in.source.position;
-
-  // TODO: shortcut if in.source.weighting_factor == 0
-
-  // Transform loudspeaker position according to reference and offset
-  ls.transform(ref);
-
-  float reference_distance = (ls.position - ref_off.position).length();
+  ref_off.transform(DirectionalPoint(state.reference_offset_position
+        , state.reference_offset_orientation));
+
+  const float yaw = -ref.orientation.azimuth;
+  const Position src = (this->position.get() - ref.position).rotate(yaw);
+  const Position off = (ref_off.position - ref.position).rotate(yaw);
+  // local copies, otherwise the loops below may not be vectorized
+  const float sx = src.x, sy = src.y, ox = off.x, oy = off.y;
+  const float source_distance = (src - off).length();
+
+  const float* const x = ls.x.data();
+  const float* const y = ls.y.data();
+  const float* const nx = ls.nx.data();
+  const float* const ny = ls.ny.data();
+  float* const delay = this->delays.data();
+  float* const weight = this->weights.data();
+  float* const distance = _distance.data();
+  float* const projection = _projection.data();
+
+  auto reference_distance = [&](size_t i)
+  {
+    return std::sqrt((x[i] - ox) * (x[i] - ox)
+        + (y[i] - oy) * (y[i] - oy));
+  };
 
-  float source_ls_distance = (ls.position - src_pos).length();
+  sample_type amplitude;
 
-  switch (in.source.model) // check if point source or plane wave or ...
+  switch (this->model) // check if point source or plane wave or ...
   {
     case ::Source::point:
-      if (ls.model == Loudspeaker::subwoofer)
+      for (size_t i = 0; i < n; ++i)
       {
-        // the delay is calculated to be correct on the reference position
-        // delay can be negative!
-        float_delay = (src_pos - ref_off.position).length()
-          - reference_distance;
+        const float dx = x[i] - sx;
+        const float dy = y[i] - sy;
+        distance[i] = std::sqrt(dx * dx + dy * dy);
+        // distance times the cosine of the angle between the line connecting
+        // source<->loudspeaker and the loudspeaker orientation
+        projection[i] = dx * nx[i] + dy * ny[i];
+      }
 
-        if (std::abs(float_delay) < safety_radius)
-        {
-          weighting_factor = 1.0f / std::sqrt(safety_radius);
-        }
-        else
+      _focused = true;
+      for (size_t i = 0; i < n; ++i)
+      {
+        // subwoofers have to be ignored!
+        if (!ls.subwoofer[i] && projection[i] > 0.0f)
         {
-          weighting_factor = 1.0f / std::sqrt(std::abs(float_delay));
+          // if at least one loudspeaker "turns its back" to the source, the
+          // source is considered non-focused
+          _focused = false;
+          break;
         }
-        break; // step out of switch
       }
 
-      float_delay = (ls.position - src_pos).length();
-      assert(float_delay >= 0);
-
-      float denominator;
-      if (float_delay < safety_radius) denominator = std::sqrt(safety_radius);
-      else denominator = std::sqrt(float_delay);
-
-      // TODO: does this really do the right thing?
-      weighting_factor = cos(angle(ls.position - src_pos,
-            ls.orientation)) / denominator;
+      for (size_t i = 0; i < n; ++i)
+      {
+        delay[i] = distance[i];
+        // cosine of the angle divided by the square root of the distance
+        weight[i] = projection[i] / (std::max(distance[i], 1e-6f)
+            * std::sqrt(std::max(distance[i], safety_radius)));
+      }
 
-      if (weighting_factor < 0.0f)
+      for (size_t i = 0; i < n; ++i)
       {
-        // negative weighting factor is only valid for focused sources
-        if (in.source._focused)
+        if (ls.subwoofer[i])
         {
-          // loudspeaker selection:
-
-          // this could also be done by using the cosine function instead of
-          // inner product
-
-          // calculate inner product of those two vectors:
-          // this = source
-          auto lhs = ls.position - src_pos;
-          auto rhs = ref_off.position - src_pos;
-
-          // TODO: write inner product function in Position class
-          if ((lhs.x * rhs.x + lhs.y * rhs.y) < 0.0f)
+          // the delay is calculated to be correct on the reference position
+          // delay can be negative!
+          delay[i] = source_distance - reference_distance(i);
+          weight[i] = 1.0f / std::sqrt(std::max(std::abs(delay[i])
+                , safety_radius));
+        }
+        else if (weight[i] < 0.0f)
+        {
+          // negative weighting factor is only valid for focused sources
+          // if the inner product is less than zero, the source is more or
+          // less between the loudspeaker and the reference
+          if (_focused && ((x[i] - sx) * (ox - sx)
+                + (y[i] - sy) * (oy - sy)) < 0.0f)
           {
-            // if the inner product is less than zero, the source is more or
-            // less between the loudspeaker and the reference
-            float_delay = -float_delay;
-            weighting_factor = -weighting_factor;
+            delay[i] = -delay[i];
+            weight[i] = -weight[i];
 
-#if defined(WEIGHTING_OLD)
-            (void)source_ls_distance;  // avoid "unused variable" warning
-#elif defined(WEIGHTING_DELFT)
+#if defined(WEIGHTING_DELFT)
             // limit to a maximum of 2.0
-            weighting_factor *= std::min(2.0f, std::sqrt(source_ls_distance
-                / (reference_distance + source_ls_distance)));
+            weight[i] *= std::min(2.0f, std::sqrt(distance[i]
+                / (reference_distance(i) + distance[i])));
 #endif
           }
           else
           {
-            // ignored focused point source
-            weighting_factor = 0;
-            break;
+            // ignored focused or non-focused point source
+            weight[i] = 0;
           }
         }
-        else // non-focused and weighting_factor < 0
-        {
-          // ignored non-focused point source
-          weighting_factor = 0;
-          break;
-        }
-      }
-      else if(weighting_factor > 0.0f) // positive weighting factor
-      {
-        if (!in.source._focused)
+        else if (weight[i] > 0.0f && !_focused)
         {
           // non-focused point source
 
-#if defined(WEIGHTING_OLD)
-#elif defined(WEIGHTING_DELFT)
+#if defined(WEIGHTING_DELFT)
           // WARNING: division by zero is possible!
-          weighting_factor *= std::sqrt(source_ls_distance
-              / (reference_distance + source_ls_distance));
+          weight[i] *= std::sqrt(distance[i]
+              / (reference_distance(i) + distance[i]));
 #endif
         }
-        else // focused
-        {
-          // ignored focused point source
-          break;
-        }
-      }
-      else
-      {
-        // this should never happen: Weighting factor is 0 or +-Inf or NaN!
-        break;
       }
       break;
 
     case ::Source::plane:
-      if (ls.model == Loudspeaker::subwoofer)
+      // focused-ness is irrelevant for plane waves
+      _focused = false;
       {
-        weighting_factor = 1.0f; // TODO: is this correct?
-        // the delay is calculated to be correct on the reference position
-        // delay can be negative!
-        float_delay
-          = DirectionalPoint(in.source.position, in.source.orientation)
-          .plane_to_point_distance(ref_off.position) - reference_distance;
-        break; // step out of switch
-      }
+        const auto dir
+          = Orientation(this->orientation.get().azimuth + yaw).look_vector();
+        const float dx = dir.x, dy = dir.y;
 
-      // weighting factor is determined by the cosine of the angle
-      // difference between plane wave direction and loudspeaker direction
-      weighting_factor = cos(angle(in.source.orientation, ls.orientation));
-      // check if loudspeaker is active for this source
-      if (weighting_factor < 0)
-      {
-        // ignored plane wave
-        weighting_factor = 0;
-        break;
-      }
-
-      float_delay = DirectionalPoint(in.source.position, in.source.orientation)
-        .plane_to_point_distance(ls.position);
+        for (size_t i = 0; i < n; ++i)
+        {
+          // weighting factor is determined by the cosine of the angle
+          // difference between plane wave direction and loudspeaker direction
+          weight[i] = dx * nx[i] + dy * ny[i];
+          // distance between loudspeaker and wave front through source position
+          delay[i] = (x[i] - sx) * dx + (y[i] - sy) * dy;
+        }
 
-      if (float_delay < 0.0)
-      {
-        // "focused" plane wave
-      }
-      else // positive delay
-      {
-        // plane wave
+        for (size_t i = 0; i < n; ++i)
+        {
+          if (ls.subwoofer[i])
+          {
+            weight[i] = 1.0f; // TODO: is this correct?
+            // the delay is calculated to be correct on the reference position
+            // delay can be negative!
+            delay[i] = (ox - sx) * dx + (oy - sy) * dy
+              - reference_distance(i);
+          }
+          else if (weight[i] < 0.0f)
+          {
+            // ignored plane wave
+            weight[i] = 0;
+            delay[i] = 0;
+          }
+        }
       }
       break;
 
     default:
       //WARNING("Unknown source model");
+      _focused = false;
+      std::fill(weight, weight + n, 1.0f);
+      std::fill(delay, delay + n, 0.0f);
       break;
-  } // switch source model
+  }
 
-  // no distance attenuation for plane waves 
-  if (in.source.model == ::Source::plane)
+  // no distance attenuation for plane waves
+  if (this->model == ::Source::plane)
   {
-    float ampl_ref = _out.parent.state.amplitude_reference_distance;
+    float ampl_ref = state.amplitude_reference_distance;
     assert(ampl_ref > 0);
 
     // 1/r:
-    weighting_factor *= 0.5f / ampl_ref;
+    amplitude = 0.5f / ampl_ref;
     // 1/sqrt(r)
-    //weighting_factor *= 0.25f / std::sqrt(ampl_ref);
+    //amplitude = 0.25f / std::sqrt(ampl_ref);
   }
   else
   {
 #if defined(WEIGHTING_OLD)
     // consider distance attenuation
-    float source_distance = (src_pos - ref_off.position).length();
-
     // no volume increase for sources closer than 0.5m to reference position
-    source_distance = std::max(source_distance, 0.5f);
-
-    weighting_factor *= 0.5f / source_distance; // 1/r
-    // weighting_factor *= 0.25f / std::sqrt(source_distance); // 1/sqrt(r)
+    amplitude = 0.5f / std::max(source_distance, 0.5f); // 1/r
+    // amplitude = 0.25f / std::sqrt(std::max(source_distance, 0.5f));
 #elif defined(WEIGHTING_DELFT)
+    amplitude = 1.0f;
 #endif
   }
 
-  // apply the gain factor of the current source
-  weighting_factor *= in.source.weighting_factor;
+  const float samples_per_meter = c_inverse * this->parent.sample_rate();
 
-  // apply tapering
-  weighting_factor *= ls.weight;
+  for (size_t i = 0; i < n; ++i)
+  {
+    // apply tapering
+    weight[i] *= amplitude * ls.weight[i];
+    delay[i] *= samples_per_meter;
+  }
+}
 
-  assert(weighting_factor >= 0.0f);
+WfsRenderer::SourceChannel::SourceChannel(const Source& s)
+  : crossfade_mode(0)
+  , weighting_factor(0.0f)
+  , delay(0)
+  , fractional_delay(0.0f)
+  , source(s)
+{}
+
+size_t WfsRenderer::SourceChannel::index() const
+{
+  return static_cast<size_t>(this - this->source.sourcechannels.data());
+}
+
+void WfsRenderer::SourceChannel::update()
+{
+  _begin = this->source.delayline.get_read_circulator(this->delay);
+  _end = _begin + source.parent.block_size();
+}
+
+apf::CombineChannelsResult::type
+WfsRenderer::RenderFunction::select(SourceChannel& in)
+{
+  _in = &in;
+
+  // TODO: shortcut if in.source.weighting_factor == 0
+
+  const size_t index = in.index();
 
-  // delay in seconds
-  float_delay *= c_inverse;
   // delay in samples
-  float_delay *= _out.parent.sample_rate();
+  float float_delay = in.source.delays[index];
+
+  // apply the gain factor of the current source
+  sample_type weighting_factor
+    = in.source.weights[index] * in.source.weighting_factor;
+
+  assert(weighting_factor >= 0.0f);
 
   // TODO: check for negative delay and print an error if > initial_delay
 
+  if (_out.parent._interpolator)
+  {
+    return _select_interpolated(in, float_delay, weighting_factor);
+  }
+
   // TODO: do proper rounding
-  // TODO: enable interpolated reading from delay line.
   int int_delay = static_cast<int>(float_delay + 0.5f);
 
   if (in.source.delayline.delay_is_valid(int_delay))
@@ -577,6 +634,95 @@ WfsRenderer::RenderFunction::select(SourceChannel& in)
   return crossfade_mode;
 }
 
+void WfsRenderer::load_reproduction_setup()
+{
+  _base::load_reproduction_setup();
+
+  for (const auto& out: rtlist_proxy<Output>(this->get_output_list()))
+  {
+    auto direction = out.orientation.look_vector();
+    _loudspeakers.x.push_back(out.position.x);
+    _loudspeakers.y.push_back(out.position.y);
+    _loudspeakers.nx.push_back(direction.x);
+    _loudspeakers.ny.push_back(direction.y);
+    _loudspeakers.weight.push_back(out.weight);
+    _loudspeakers.subwoofer.push_back(out.model == Loudspeaker::subwoofer);
+  }
+}
+
+/** Read from the delay line with fractional delay.
+ * Delay and weighting factor are changed sample by sample, the result is
+ * stored in Output::_interpolation_buffer and has only to be accumulated.
+ * Therefore, moving sources don't need a crossfade.
+ **/
+apf::CombineChannelsResult::type
+WfsRenderer::RenderFunction::_select_interpolated(SourceChannel& in
+    , float float_delay, sample_type weighting_factor)
+{
+  const auto& interpolator = *_out.parent._interpolator;
+
+  if (in.source.delayline.delay_is_valid(float_delay, interpolator))
+  {
+    in.fractional_delay = float_delay;
+    in.weighting_factor = weighting_factor;
+  }
+  else
+  {
+    // keep the old delay for fading out
+    in.fractional_delay = in.fractional_delay.get();
+    in.weighting_factor = 0;
+  }
+
+  assert(in.weighting_factor.exactly_one_assignment());
+  assert(in.fractional_delay.exactly_one_assignment());
+
+  float old_delay = in.fractional_delay.old();
+  float new_delay = in.fractional_delay;
+  sample_type old_weight = in.weighting_factor.old();
+  sample_type new_weight = in.weighting_factor;
+
+  if (old_weight == 0 && new_weight == 0)
+  {
+    return apf::CombineChannelsResult::nothing;
+  }
+
+  // no need to change the delay while fading in or out
+  if (old_weight == 0) old_delay = new_delay;
+  if (new_weight == 0) new_delay = old_delay;
+
+  size_t block_size = _out.parent.block_size();
+  auto& scratch = _out._interpolation_buffer;
+  auto buffer = scratch.begin();
+  bool success;
+
+  // More than a quarter of a sample per sample (i.e. a quarter of the speed
+  // of sound) is not a movement anymore but a jump, which would cause a
+  // strong Doppler effect. In this case, a crossfade is used.
+  if (std::abs(new_delay - old_delay) <= 0.25f * float(block_size))
+  {
+    success = in.source.delayline.read_block(buffer, old_delay, new_delay
+        , old_weight, new_weight, interpolator);
+  }
+  else
+  {
+    success = in.source.delayline.read_block(buffer, old_delay, old_delay
+        , old_weight, sample_type(), interpolator)
+      && in.source.delayline.read_block(apf::make_accumulating_iterator(buffer)
+        , new_delay, new_delay, sample_type(), new_weight, interpolator);
+  }
+  assert(success);
+  (void)success;  // avoid "unused-but-set-variable" warning
+
+  in._begin = apf::NonCausalBlockDelayLine<sample_type>::circulator(
+      scratch.begin(), scratch.end());
+  in._end = in._begin + block_size;
+
+  // weighting factors are already applied
+  _old_factor = _new_factor = 1;
+
+  return apf::CombineChannelsResult::constant;
+}
+
 }  // namespace ssr
 
 #endif
@@ -0,0 +1,243 @@
+/******************************************************************************
+ * Copyright © 2012-2014 Institut für Nachrichtentechnik, Universität Rostock *
+ * Copyright © 2006-2012 Quality & Usability Lab,                             *
+ *                       Telekom Innovation Laboratories, TU Berlin           *
+ *                                                                            *
+ * This file is part of the SoundScape Renderer (SSR).                        *
+ *                                                                            *
+ * The SSR is free software:  you can redistribute it and/or modify it  under *
+ * the terms of the  GNU  General  Public  License  as published by the  Free *
+ * Software Foundation, either version 3 of the License,  or (at your option) *
+ * any later version.                                                         *
+ *                                                                            *
+ * The SSR is distributed in the hope that it will be useful, but WITHOUT ANY *
+ * WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS *
+ * FOR A PARTICULAR PURPOSE.                                                  *
+ * See the GNU General Public License for more details.                       *
+ *                                                                            *
+ * You should  have received a copy  of the GNU General Public License  along *
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.            *
+ *                                                                            *
+ * The SSR is a tool  for  real-time  spatial audio reproduction  providing a *
+ * variety of rendering algorithms.                                           *
+ *                                                                            *
+ * http://spatialaudio.net/ssr                           ssr@spatialaudio.net *
+ ******************************************************************************/
+
+/// @file
+/// Offline test of the XML pull parser for network messages.
+///
+/// Covers the sequence of parser events (including skipped content and
+/// syntax errors), the resolution of entities in attribute values and the
+/// conversion of attribute values to numbers.
+
+#include <iostream>
+#include <string>
+#include <cstring>  // for std::strlen()
+#include <cmath>  // for std::abs()
+
+#include "boostnetwork/xmlpullparser.h"
+
+using ssr::XmlPullParser;
+
+namespace
+{
+
+bool success = true;
+
+void check(bool condition, const std::string& message)
+{
+  if (!condition)
+  {
+    std::cout << "FAILED: " << message << std::endl;
+    success = false;
+  }
+}
+
+/// Events of a whole message, e.g. "<a <b >b >a ."
+std::string events(const char* message)
+{
+  XmlPullParser xml;
+  xml.reset(message, message + std::strlen(message));
+  std::string result;
+  for (;;)
+  {
+    switch (xml.next())
+    {
+      case XmlPullParser::start_element:
+        result += "<" + xml.name() + " ";
+        break;
+      case XmlPullParser::end_element:
+        result += ">" + xml.name() + " ";
+        break;
+      case XmlPullParser::end_of_input:
+        return result + ".";
+      case XmlPullParser::error:
+        return result + "error";
+    }
+  }
+}
+
+/// Attribute "v" of a single element with the given attribute string
+template<typename F>
+void with_attribute(const std::string& value, F f)
+{
+  auto message = "<a v='" + value + "'/>";
+  XmlPullParser xml;
+  xml.reset(message.data(), message.data() + message.size());
+  if (xml.next() != XmlPullParser::start_element)
+  {
+    check(false, "syntax error in " + message);
+    return;
+  }
+  f(xml.attribute("v"));
+}
+
+void check_float(const std::string& value, float expected)
+{
+  with_attribute(value, [&] (XmlPullParser::Attribute attr)
+  {
+    float result;
+    check(attr.get(result)
+        && std::abs(result - expected) <= std::abs(expected) * 1e-6f
+        , "get(float&) of \"" + value + "\"");
+  });
+}
+
+template<typename T>
+void check_invalid(const std::string& value)
+{
+  with_attribute(value, [&] (XmlPullParser::Attribute attr)
+  {
+    T result;
+    check(!attr.get(result), "invalid value \"" + value + "\"");
+  });
+}
+
+template<typename T>
+void check_value(const std::string& value, T expected)
+{
+  with_attribute(value, [&] (XmlPullParser::Attribute attr)
+  {
+    T result;
+    check(attr.get(result) && result == expected
+        , "get() of \"" + value + "\"");
+  });
+}
+
+void check_str(const std::string& value, const std::string& expected)
+{
+  with_attribute(value, [&] (XmlPullParser::Attribute attr)
+  {
+    check(attr.str() == expected, "entities in \"" + value + "\"");
+  });
+}
+
+}  // unnamed namespace
+
+int main()
+{
+  // Elements
+
+  check(events("<a><b x='1' y=\"2\"/><c></c></a>")
+      == "<a <b >b <c >c >a .", "elements");
+  check(events("<?xml version='1.0'?><!DOCTYPE a><a>text<!-- <b/> --></a>")
+      == "<a >a .", "skipped content");
+  check(events(" <a > </a >\n") == "<a >a .", "white space");
+  check(events("") == ".", "empty input");
+  check(events("<a><b></a>") == "<a <b error", "wrong end tag");
+  check(events("</a>") == "error", "end tag without start tag");
+  check(events("<a>") == "<a error", "missing end tag");
+  check(events("<a x=1/>") == "error", "unquoted attribute");
+  check(events("<a x='1/>") == "error", "unterminated attribute");
+  check(events("<a/ >") == "error", "broken empty element");
+  check(events("<a><!-- </a>") == "<a error", "unterminated comment");
+
+  {
+    const char message[] = "<a><b><c/><d>x</d></b><e k='v'/></a>";
+    XmlPullParser xml;
+    xml.reset(message, message + sizeof(message) - 1);
+    check(xml.next() == XmlPullParser::start_element && xml.is("a")
+        , "start of a");
+    check(xml.next() == XmlPullParser::start_element && xml.is("b")
+        && xml.depth() == 2, "start of b");
+    check(xml.skip() == XmlPullParser::end_element && xml.is("b")
+        && xml.depth() == 1, "skip() of b");
+    check(xml.next() == XmlPullParser::start_element && xml.is("e")
+        && xml.attribute("k").str() == "v" && !xml.attribute("x")
+        , "element after skipped element");
+    check(xml.skip() == XmlPullParser::end_element && xml.is("e")
+        , "skip() of empty element");
+    check(xml.next() == XmlPullParser::end_element && xml.is("a")
+        , "end of a");
+    check(xml.next() == XmlPullParser::end_of_input, "end of input");
+  }
+
+  // Entities
+
+  check_str("&lt;&gt;&amp;&quot;&apos;", "<>&\"'");
+  check_str("&#65;&#x42;", "AB");
+  check_str("&#xE9;", "\xC3\xA9");
+  check_str("&#x20AC;", "\xE2\x82\xAC");
+  check_str("&#x1F600;", "\xF0\x9F\x98\x80");
+  check_str("a&unknown;b", "a&unknown;b");
+  check_str("&#0;&#x110000;&#12a;", "&#0;&#x110000;&#12a;");
+  check_str("&amp", "&amp");
+  check_str("", "");
+
+  // Numbers
+
+  check_float("1.5", 1.5f);
+  check_float(" -2.25 ", -2.25f);
+  check_float("+.5", 0.5f);
+  check_float("5.", 5.0f);
+  check_float("1E-2", 0.01f);
+  check_float("1e3", 1000.0f);
+  check_float("0", 0.0f);
+  check_float("-0.0", 0.0f);
+  check_float("0e999", 0.0f);
+  check_float("1e-999", 0.0f);
+  check_float("0.000000000000000000001234", 1.234e-21f);
+  check_float("000000000000000000000000001.5", 1.5f);
+  check_float("12345678901234567890123", 1.2345679e22f);
+  check_float("3.4e38", 3.4e38f);
+  check_invalid<float>("1e39");
+  check_invalid<float>("-1e39");
+  check_invalid<float>("1e999");
+  check_invalid<float>("1e99999999999999999999");
+  check_invalid<float>("");
+  check_invalid<float>(".");
+  check_invalid<float>("-");
+  check_invalid<float>("1e");
+  check_invalid<float>("1.2.3");
+  check_invalid<float>("1 2");
+  check_invalid<float>("nan");
+  check_invalid<float>("inf");
+
+  check_value<int>("-42", -42);
+  check_value<int>("-2147483648", -2147483647 - 1);
+  check_value<int>("2147483647", 2147483647);
+  check_value<int>("0000000000042", 42);
+  check_invalid<int>("2147483648");
+  check_invalid<int>("1.5");
+  check_value<unsigned>("4294967295", 4294967295u);
+  check_value<unsigned>("+7", 7u);
+  check_invalid<unsigned>("4294967296");
+  check_invalid<unsigned>("-1");
+  check_value<bool>(" true ", true);
+  check_value<bool>("0", false);
+  check_invalid<bool>("yes");
+
+  {
+    XmlPullParser::Attribute missing;
+    float f;
+    check(!missing && missing.str() == "" && !missing.get(f)
+        , "missing attribute");
+  }
+
+  return success ? 0 : 1;
+}
+
+// Settings for Vim (http://www.vim.org/), please do not remove:
+// vim:softtabstop=2:shiftwidth=2:expandtab:textwidth=80:cindent
+// vim:fdm=expr:foldexpr=getline(v\:lnum)=~'/\\*\\*'&&getline(v\:lnum)!~'\\*\\*/'?'a1'\:getline(v\:lnum)=~'\\*\\*/'&&getline(v\:lnum)!~'/\\*\\*'?'s1'\:'='